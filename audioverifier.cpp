@@ -0,0 +1,214 @@
+#include "audioverifier.h"
+#include "flacdecoder.h"
+
+#include <QByteArrayView>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+AudioVerifier::AudioVerifier(QObject *parent)
+    : QObject(parent)
+    , m_next(0)
+    , m_done(0)
+    , m_passed(0)
+    , m_failed(0)
+    , m_bytes(0)
+    , m_activeWorkers(0)
+    , m_cancelled(false)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+AudioVerifier::~AudioVerifier()
+{
+    cancel();
+    waitForDone();
+}
+
+void AudioVerifier::setMaxThreads(int count)
+{
+    m_pool.setMaxThreadCount(std::max(1, count));
+}
+
+int AudioVerifier::maxThreads() const
+{
+    return m_pool.maxThreadCount();
+}
+
+bool AudioVerifier::isRunning() const
+{
+    return m_activeWorkers.load() > 0;
+}
+
+void AudioVerifier::start(const QStringList &filePaths)
+{
+    if (isRunning()) {
+        return;
+    }
+
+    m_filePaths = filePaths;
+    m_next = 0;
+    m_done = 0;
+    m_passed = 0;
+    m_failed = 0;
+    m_bytes = 0;
+    m_cancelled = false;
+    m_timer.start();
+
+    if (m_filePaths.isEmpty()) {
+        emit finished(0, 0, 0, 0, 0);
+        return;
+    }
+
+    const int workers = std::min(m_pool.maxThreadCount(), static_cast<int>(m_filePaths.size()));
+    // One more than the workers, held until the last one has read the results
+    m_activeWorkers = workers + 1;
+    for (int worker = 0; worker < workers; ++worker) {
+        m_pool.start([this]() { runWorker(); });
+    }
+}
+
+void AudioVerifier::cancel()
+{
+    m_cancelled = true;
+}
+
+void AudioVerifier::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+bool AudioVerifier::canVerify(const QString &filePath)
+{
+    return QFileInfo(filePath).suffix().compare(QLatin1String("flac"), Qt::CaseInsensitive) == 0;
+}
+
+AudioVerifier::Result AudioVerifier::verifyFile(const QString &filePath, const std::atomic<bool> *cancelled)
+{
+    Result result;
+
+    if (!canVerify(filePath)) {
+        result.status = Unsupported;
+        return result;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.errorString = file.errorString();
+        return result;
+    }
+    result.bytes = file.size();
+
+    // The decoder walks the mapping front to back, so the kernel reads the
+    // file ahead of it and no copy of the compressed data is made
+    const uchar *data = result.bytes > 0 ? file.map(0, result.bytes) : nullptr;
+    if (!data) {
+        result.errorString = result.bytes > 0 ? file.errorString() : QStringLiteral("File is empty");
+        return result;
+    }
+
+    FlacDecoder decoder(data, static_cast<std::size_t>(result.bytes));
+    if (!decoder.readHeader()) {
+        result.errorString = QString::fromStdString(decoder.errorString());
+        return result;
+    }
+
+    const FlacDecoder::StreamInfo &info = decoder.streamInfo();
+    if (std::all_of(std::begin(info.md5), std::end(info.md5), [](unsigned char byte) { return byte == 0; })) {
+        result.status = NoSignature;
+        return result;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    std::vector<unsigned char> samples;
+    while (decoder.decodeFrame(samples)) {
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(samples.data()),
+                                    static_cast<qsizetype>(samples.size())));
+        if (cancelled && cancelled->load()) {
+            result.errorString = QStringLiteral("Verification cancelled");
+            return result;
+        }
+    }
+
+    if (!decoder.atEnd()) {
+        result.errorString = QString::fromStdString(decoder.errorString());
+        return result;
+    }
+
+    if (info.totalSamples > 0 && decoder.decodedSamples() != info.totalSamples) {
+        result.errorString = QStringLiteral("Decoded %1 samples, STREAMINFO says %2")
+                                 .arg(decoder.decodedSamples())
+                                 .arg(info.totalSamples);
+        return result;
+    }
+
+    const QByteArray expected(reinterpret_cast<const char *>(info.md5), sizeof(info.md5));
+    if (hash.result() == expected) {
+        result.status = Match;
+    } else {
+        result.status = Mismatch;
+        result.errorString = QStringLiteral("Audio MD5 does not match STREAMINFO");
+    }
+
+    return result;
+}
+
+QString AudioVerifier::statusText(Status status)
+{
+    switch (status) {
+    case Match:
+        return QStringLiteral("OK");
+    case Mismatch:
+        return QStringLiteral("MD5 mismatch");
+    case NoSignature:
+        return QStringLiteral("No MD5 stored");
+    case Unsupported:
+        return QStringLiteral("Not a FLAC file");
+    case Failed:
+        break;
+    }
+    return QStringLiteral("Error");
+}
+
+void AudioVerifier::runWorker()
+{
+    const int total = m_filePaths.size();
+
+    while (!m_cancelled.load()) {
+        const int index = m_next.fetch_add(1);
+        if (index >= total) {
+            break;
+        }
+
+        const QString &filePath = m_filePaths.at(index);
+        const Result result = verifyFile(filePath, &m_cancelled);
+        m_bytes += result.bytes;
+        if (result.status == Match) {
+            ++m_passed;
+        } else if (result.status == Mismatch || result.status == Failed) {
+            ++m_failed;
+        }
+
+        const int done = ++m_done;
+        emit fileVerified(filePath, result.status, result.errorString);
+        emit progress(done, total);
+    }
+
+    // The last worker reads the results before it releases the extra count
+    // taken by start(): once none is left, start() may reset the counters
+    // and restart the timer for the next run
+    if (--m_activeWorkers == 1) {
+        const int done = m_done.load();
+        const int passed = m_passed.load();
+        const int failed = m_failed.load();
+        const qint64 bytes = m_bytes.load();
+        const qint64 elapsedMs = m_timer.elapsed();
+        m_activeWorkers = 0;
+        emit finished(passed, failed, done - passed - failed, bytes, elapsedMs);
+    }
+}
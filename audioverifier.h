@@ -0,0 +1,86 @@
+#ifndef AUDIOVERIFIER_H
+#define AUDIOVERIFIER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <atomic>
+
+// Checks that the audio of FLAC files still matches the MD5 the encoder
+// stored in STREAMINFO.
+//
+// Each file is mapped and decoded one frame at a time into a running MD5, so
+// memory use does not grow with the file. Files are spread over a worker
+// pool; like CommitPipeline, signals are emitted from worker threads and
+// receivers in the GUI thread get them queued. Tag edits never touch the
+// audio frames, so a match after a batch save proves the audio is intact.
+class AudioVerifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Status {
+        Match,
+        Mismatch,
+        // The encoder did not store a checksum
+        NoSignature,
+        // Not a FLAC file
+        Unsupported,
+        Failed
+    };
+    Q_ENUM(Status)
+
+    struct Result
+    {
+        Status status = Failed;
+        QString errorString;
+        // Size of the file, counted towards the throughput
+        qint64 bytes = 0;
+    };
+
+    explicit AudioVerifier(QObject *parent = nullptr);
+    ~AudioVerifier();
+
+    void setMaxThreads(int count);
+    int maxThreads() const;
+
+    bool isRunning() const;
+
+    // Starts verifying files in the background. Ignored while already running.
+    void start(const QStringList &filePaths);
+    // Stops after the files being decoded right now
+    void cancel();
+    void waitForDone();
+
+    static bool canVerify(const QString &filePath);
+    // Decodes filePath and compares its audio with the stored MD5. Aborts
+    // early once cancelled becomes true.
+    static Result verifyFile(const QString &filePath, const std::atomic<bool> *cancelled = nullptr);
+    static QString statusText(Status status);
+
+signals:
+    void fileVerified(const QString &filePath, AudioVerifier::Status status, const QString &errorString);
+    void progress(int done, int total);
+    // Skipped files have no checksum to compare (NoSignature, Unsupported)
+    void finished(int passed, int failed, int skipped, qint64 bytes, qint64 elapsedMs);
+
+private:
+    void runWorker();
+
+    QThreadPool m_pool;
+
+    QStringList m_filePaths;
+    std::atomic<int> m_next;
+    std::atomic<int> m_done;
+    std::atomic<int> m_passed;
+    std::atomic<int> m_failed;
+    std::atomic<qint64> m_bytes;
+    std::atomic<int> m_activeWorkers;
+    std::atomic<bool> m_cancelled;
+    QElapsedTimer m_timer;
+};
+
+#endif // AUDIOVERIFIER_H
@@ -0,0 +1,412 @@
+#include "batchrunner.h"
+#include "commitpipeline.h"
+#include "audioverifier.h"
+
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+double filesPerSecond(int files, qint64 elapsedMs)
+{
+    return elapsedMs > 0 ? files * 1000.0 / elapsedMs : 0.0;
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 elapsedMs)
+{
+    return elapsedMs > 0 ? bytes / 1000.0 / elapsedMs : 0.0;
+}
+
+QString csvField(const QString &value)
+{
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"'))
+        && !value.contains(QLatin1Char('\n'))) {
+        return value;
+    }
+
+    QString escaped = value;
+    escaped.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+} // namespace
+
+BatchRunner::BatchRunner()
+    : m_nameFilters(TagEngine::supportedNameFilters())
+    , m_scan(false)
+    , m_verify(false)
+    , m_checkAudio(false)
+    , m_threadCount(QThread::idealThreadCount())
+    , m_writersPerDevice(2)
+{
+}
+
+bool BatchRunner::isBatchInvocation(int argc, char *argv[])
+{
+    static const char *const batchOptions[] = {"--scan", "--set", "--export", "--verify"};
+
+    for (int i = 1; i < argc; ++i) {
+        for (const char *option : batchOptions) {
+            const size_t length = std::strlen(option);
+            if (std::strncmp(argv[i], option, length) == 0
+                && (argv[i][length] == '\0' || argv[i][length] == '=')) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+int BatchRunner::run(const QStringList &arguments)
+{
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Mp3Tag Qt batch mode"));
+    parser.addHelpOption();
+
+    QCommandLineOption scanOption(QStringLiteral("scan"),
+        QStringLiteral("Read the tags of all files and report throughput."));
+    QCommandLineOption setOption(QStringLiteral("set"),
+        QStringLiteral("Set a property, e.g. ARTIST=Name. An empty value removes it. Can be repeated."),
+        QStringLiteral("KEY=VALUE"));
+    QCommandLineOption globOption(QStringLiteral("glob"),
+        QStringLiteral("File name pattern used when descending into directories. Can be repeated."),
+        QStringLiteral("pattern"));
+    QCommandLineOption exportOption(QStringLiteral("export"),
+        QStringLiteral("Write the tags of all files as CSV to file ('-' for stdout)."),
+        QStringLiteral("file"));
+    QCommandLineOption verifyOption(QStringLiteral("verify"),
+        QStringLiteral("Decode FLAC files and check their audio against the MD5 in STREAMINFO. "
+                       "Runs after --set, so retagged files are checked right away."));
+    QCommandLineOption checkAudioOption(QStringLiteral("check-audio"),
+        QStringLiteral("Hash the audio data of each file before and after --set and report files "
+                       "whose audio the save changed. Works for all supported formats."));
+    QCommandLineOption threadsOption(QStringList() << QStringLiteral("j") << QStringLiteral("threads"),
+        QStringLiteral("Number of worker threads."),
+        QStringLiteral("N"), QString::number(m_threadCount));
+    QCommandLineOption writersOption(QStringLiteral("writers-per-device"),
+        QStringLiteral("Maximum number of concurrent --set writers per storage device."),
+        QStringLiteral("N"), QString::number(m_writersPerDevice));
+    QCommandLineOption benchmarkOption(QStringLiteral("benchmark"),
+        QStringLiteral("Repeat the --set commit for 1, 2, 4... writers per device up to --threads "
+                       "and report the throughput of each run. Use on a scratch copy."));
+
+    parser.addOption(scanOption);
+    parser.addOption(setOption);
+    parser.addOption(globOption);
+    parser.addOption(exportOption);
+    parser.addOption(verifyOption);
+    parser.addOption(checkAudioOption);
+    parser.addOption(threadsOption);
+    parser.addOption(writersOption);
+    parser.addOption(benchmarkOption);
+    parser.addPositionalArgument(QStringLiteral("paths"),
+        QStringLiteral("Files or directories to process (default: current directory)."),
+        QStringLiteral("[paths...]"));
+    parser.process(arguments);
+
+    m_scan = parser.isSet(scanOption);
+    m_exportPath = parser.value(exportOption);
+    m_verify = parser.isSet(verifyOption);
+    m_checkAudio = parser.isSet(checkAudioOption);
+
+    for (const QString &assignment : parser.values(setOption)) {
+        const int separator = assignment.indexOf(QLatin1Char('='));
+        if (separator <= 0) {
+            err << "Invalid --set argument, expected KEY=VALUE: " << assignment << Qt::endl;
+            return 2;
+        }
+        m_changes.insert(assignment.left(separator).trimmed().toUpper(), assignment.mid(separator + 1));
+    }
+
+    if (parser.isSet(globOption)) {
+        m_nameFilters = parser.values(globOption);
+    }
+
+    bool threadsOk = false;
+    m_threadCount = parser.value(threadsOption).toInt(&threadsOk);
+    if (!threadsOk || m_threadCount < 1) {
+        err << "Invalid thread count: " << parser.value(threadsOption) << Qt::endl;
+        return 2;
+    }
+
+    bool writersOk = false;
+    m_writersPerDevice = parser.value(writersOption).toInt(&writersOk);
+    if (!writersOk || m_writersPerDevice < 1) {
+        err << "Invalid writer count: " << parser.value(writersOption) << Qt::endl;
+        return 2;
+    }
+
+    const bool benchmark = parser.isSet(benchmarkOption);
+    if (benchmark && m_changes.isEmpty()) {
+        err << "--benchmark requires at least one --set" << Qt::endl;
+        return 2;
+    }
+
+    QStringList paths = parser.positionalArguments();
+    if (paths.isEmpty()) {
+        paths << QDir::currentPath();
+    }
+
+    const QStringList files = collectFiles(paths);
+    int failed = 0;
+
+    if (benchmark) {
+        for (int writers = 1; writers <= m_threadCount; writers *= 2) {
+            failed += commitChanges(files, writers);
+        }
+    } else if (!m_changes.isEmpty()) {
+        failed = commitChanges(files, m_writersPerDevice);
+    }
+
+    if (m_scan || !m_exportPath.isEmpty()) {
+        failed += readFiles(files);
+    }
+
+    if (m_verify) {
+        failed += verifyFiles(files);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+int BatchRunner::commitChanges(const QStringList &files, int writersPerDevice) const
+{
+    if (files.isEmpty()) {
+        return 0;
+    }
+
+    QTextStream err(stderr);
+
+    QVector<CommitJob> jobs;
+    jobs.reserve(files.size());
+    for (const QString &filePath : files) {
+        jobs.append({filePath, m_changes});
+    }
+
+    CommitPipeline pipeline;
+    pipeline.setMaxThreads(m_threadCount);
+    pipeline.setMaxWritersPerDevice(writersPerDevice);
+    pipeline.setCheckAudioPayload(m_checkAudio);
+
+    // The pipeline reports from worker threads, so run a local event loop to
+    // receive the queued signals in this thread
+    QEventLoop loop;
+    int failed = 0;
+    qint64 elapsed = 0;
+    QObject::connect(&pipeline, &CommitPipeline::fileCommitted, &loop,
+                     [&err](const QString &filePath, bool ok, const QString &errorString) {
+                         if (!ok) {
+                             err << filePath << ": " << errorString << Qt::endl;
+                         }
+                     });
+    QObject::connect(&pipeline, &CommitPipeline::finished, &loop,
+                     [&](int, int failedCount, qint64 elapsedMs) {
+                         failed = failedCount;
+                         elapsed = elapsedMs;
+                         loop.quit();
+                     });
+
+    pipeline.start(jobs);
+    loop.exec();
+
+    err << QStringLiteral("Committed %1 files in %2 s (%3 files/s) with %4 threads, "
+                          "%5 writers per device, %6 failed")
+               .arg(files.size())
+               .arg(elapsed / 1000.0, 0, 'f', 3)
+               .arg(filesPerSecond(files.size(), elapsed), 0, 'f', 1)
+               .arg(m_threadCount)
+               .arg(writersPerDevice)
+               .arg(failed)
+        << Qt::endl;
+
+    return failed;
+}
+
+int BatchRunner::readFiles(const QStringList &files) const
+{
+    QTextStream err(stderr);
+
+    QVector<FileResult> results(files.size());
+    FileResult *resultData = results.data();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_threadCount);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < files.size(); ++i) {
+        pool.start([&files, resultData, i]() {
+            resultData[i] = readFile(files.at(i));
+        });
+    }
+    pool.waitForDone();
+
+    const qint64 elapsed = timer.elapsed();
+
+    int failed = 0;
+    for (const FileResult &result : results) {
+        if (!result.ok) {
+            err << result.record.filePath << ": " << result.error << Qt::endl;
+            ++failed;
+        }
+    }
+
+    if (!m_exportPath.isEmpty() && !exportRecords(results)) {
+        err << "Could not write export file: " << m_exportPath << Qt::endl;
+        return failed + 1;
+    }
+
+    err << QStringLiteral("Read %1 files in %2 s (%3 files/s) with %4 threads, %5 failed")
+               .arg(files.size())
+               .arg(elapsed / 1000.0, 0, 'f', 3)
+               .arg(filesPerSecond(files.size(), elapsed), 0, 'f', 1)
+               .arg(m_threadCount)
+               .arg(failed)
+        << Qt::endl;
+
+    return failed;
+}
+
+int BatchRunner::verifyFiles(const QStringList &files) const
+{
+    if (files.isEmpty()) {
+        return 0;
+    }
+
+    QTextStream err(stderr);
+
+    AudioVerifier verifier;
+    verifier.setMaxThreads(m_threadCount);
+
+    QEventLoop loop;
+    int failed = 0;
+    int skipped = 0;
+    qint64 bytes = 0;
+    qint64 elapsed = 0;
+    QObject::connect(&verifier, &AudioVerifier::fileVerified, &loop,
+                     [&err](const QString &filePath, AudioVerifier::Status status, const QString &errorString) {
+                         if (status == AudioVerifier::Mismatch || status == AudioVerifier::Failed) {
+                             err << filePath << ": " << AudioVerifier::statusText(status);
+                             if (!errorString.isEmpty()) {
+                                 err << " (" << errorString << ")";
+                             }
+                             err << Qt::endl;
+                         }
+                     });
+    QObject::connect(&verifier, &AudioVerifier::finished, &loop,
+                     [&](int, int failedCount, int skippedCount, qint64 totalBytes, qint64 elapsedMs) {
+                         failed = failedCount;
+                         skipped = skippedCount;
+                         bytes = totalBytes;
+                         elapsed = elapsedMs;
+                         loop.quit();
+                     });
+
+    verifier.start(files);
+    loop.exec();
+
+    err << QStringLiteral("Verified %1 files (%2 MB) in %3 s (%4 MB/s) with %5 threads, "
+                          "%6 failed, %7 without checksum")
+               .arg(files.size() - skipped)
+               .arg(bytes / 1000000.0, 0, 'f', 1)
+               .arg(elapsed / 1000.0, 0, 'f', 3)
+               .arg(megabytesPerSecond(bytes, elapsed), 0, 'f', 1)
+               .arg(m_threadCount)
+               .arg(failed)
+               .arg(skipped)
+        << Qt::endl;
+
+    return failed;
+}
+
+QStringList BatchRunner::collectFiles(const QStringList &paths) const
+{
+    QStringList files;
+
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            QStringList directoryFiles;
+            QDirIterator it(info.absoluteFilePath(), m_nameFilters, QDir::Files,
+                            QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+            while (it.hasNext()) {
+                directoryFiles << it.next();
+            }
+            directoryFiles.sort();
+            files << directoryFiles;
+        } else {
+            // Explicitly named files are processed even if they do not match --glob
+            files << info.absoluteFilePath();
+        }
+    }
+
+    return files;
+}
+
+BatchRunner::FileResult BatchRunner::readFile(const QString &filePath)
+{
+    FileResult result;
+    result.ok = TagEngine::readTags(filePath, result.record, &result.error);
+    result.record.filePath = filePath;
+    return result;
+}
+
+bool BatchRunner::exportRecords(const QVector<FileResult> &results) const
+{
+    QFile file;
+    bool opened = false;
+    if (m_exportPath == QLatin1String("-")) {
+        opened = file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(m_exportPath);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    }
+
+    if (!opened) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "path,title,artist,album,year,genre,comment,track,disc,composer,albumartist,"
+           "length,bitrate,samplerate,channels\n";
+
+    for (const FileResult &result : results) {
+        if (!result.ok) {
+            continue;
+        }
+
+        const TagRecord &record = result.record;
+        const QStringList fields = {
+            record.filePath, record.title, record.artist, record.album, record.year,
+            record.genre, record.comment, record.track, record.disc, record.composer,
+            record.albumArtist, QString::number(record.lengthInSeconds),
+            QString::number(record.bitrate), QString::number(record.sampleRate),
+            QString::number(record.channels)
+        };
+
+        QStringList escaped;
+        for (const QString &field : fields) {
+            escaped << csvField(field);
+        }
+        out << escaped.join(QLatin1Char(',')) << '\n';
+    }
+
+    out.flush();
+    return file.error() == QFileDevice::NoError;
+}
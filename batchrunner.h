@@ -0,0 +1,50 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+
+#include "tagengine.h"
+
+// Headless command-line mode: scans, retags, exports or verifies files without
+// the GUI. Retagging goes through CommitPipeline, the same path the editor uses.
+class BatchRunner
+{
+public:
+    BatchRunner();
+
+    // True if the arguments request batch mode (--scan, --set, --export or --verify)
+    static bool isBatchInvocation(int argc, char *argv[]);
+
+    // Runs the batch described by arguments and returns the process exit code.
+    // Requires a QCoreApplication instance.
+    int run(const QStringList &arguments);
+
+private:
+    struct FileResult
+    {
+        TagRecord record;
+        bool ok = false;
+        QString error;
+    };
+
+    QStringList collectFiles(const QStringList &paths) const;
+    int commitChanges(const QStringList &files, int writersPerDevice) const;
+    int readFiles(const QStringList &files) const;
+    int verifyFiles(const QStringList &files) const;
+    static FileResult readFile(const QString &filePath);
+    bool exportRecords(const QVector<FileResult> &results) const;
+
+    QStringList m_nameFilters;
+    QMap<QString, QString> m_changes;
+    QString m_exportPath;
+    bool m_scan;
+    bool m_verify;
+    bool m_checkAudio;
+    int m_threadCount;
+    int m_writersPerDevice;
+};
+
+#endif // BATCHRUNNER_H
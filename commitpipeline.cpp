@@ -0,0 +1,196 @@
+#include "commitpipeline.h"
+#include "tagengine.h"
+#include "payloadhasher.h"
+
+#include <QFileInfo>
+#include <QHash>
+#include <QStorageInfo>
+#include <QThread>
+
+#include <algorithm>
+
+CommitPipeline::CommitPipeline(QObject *parent)
+    : QObject(parent)
+    , m_maxWritersPerDevice(2)
+    , m_checkAudioPayload(false)
+    , m_done(0)
+    , m_failed(0)
+    , m_activeLanes(0)
+    , m_cancelled(false)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+CommitPipeline::~CommitPipeline()
+{
+    cancel();
+    waitForDone();
+}
+
+void CommitPipeline::setMaxThreads(int count)
+{
+    m_pool.setMaxThreadCount(std::max(1, count));
+}
+
+int CommitPipeline::maxThreads() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void CommitPipeline::setMaxWritersPerDevice(int count)
+{
+    m_maxWritersPerDevice = std::max(1, count);
+}
+
+int CommitPipeline::maxWritersPerDevice() const
+{
+    return m_maxWritersPerDevice;
+}
+
+void CommitPipeline::setCheckAudioPayload(bool check)
+{
+    m_checkAudioPayload = check;
+}
+
+bool CommitPipeline::checkAudioPayload() const
+{
+    return m_checkAudioPayload;
+}
+
+bool CommitPipeline::isRunning() const
+{
+    return m_activeLanes.load() > 0;
+}
+
+QString CommitPipeline::deviceKey(const QString &filePath)
+{
+    const QStorageInfo storage(QFileInfo(filePath).absolutePath());
+    if (!storage.isValid()) {
+        return QString();
+    }
+
+    const QByteArray device = storage.device();
+    return device.isEmpty() ? storage.rootPath() : QString::fromLocal8Bit(device);
+}
+
+void CommitPipeline::start(const QVector<CommitJob> &jobs)
+{
+    if (isRunning()) {
+        return;
+    }
+
+    m_jobs = jobs;
+    m_groups.clear();
+    m_done = 0;
+    m_failed = 0;
+    m_cancelled = false;
+    m_timer.start();
+
+    if (m_jobs.isEmpty()) {
+        emit finished(0, 0, 0);
+        return;
+    }
+
+    // Group by device; the lookup is cached per directory since a batch
+    // usually spans a handful of folders
+    QHash<QString, QString> deviceByDirectory;
+    QHash<QString, int> groupByDevice;
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        const QString directory = QFileInfo(m_jobs.at(i).filePath).absolutePath();
+        auto cached = deviceByDirectory.constFind(directory);
+        if (cached == deviceByDirectory.constEnd()) {
+            cached = deviceByDirectory.insert(directory, deviceKey(m_jobs.at(i).filePath));
+        }
+
+        auto group = groupByDevice.constFind(cached.value());
+        if (group == groupByDevice.constEnd()) {
+            group = groupByDevice.insert(cached.value(), m_groups.size());
+            m_groups.append(QVector<int>());
+        }
+        m_groups[group.value()].append(i);
+    }
+
+    m_nextInGroup.reset(new std::atomic<int>[m_groups.size()]);
+    int lanes = 0;
+    for (int group = 0; group < m_groups.size(); ++group) {
+        m_nextInGroup[group] = 0;
+        lanes += std::min(m_maxWritersPerDevice, static_cast<int>(m_groups.at(group).size()));
+    }
+
+    // One more than the lanes, held until the last lane has read the results
+    m_activeLanes = lanes + 1;
+    for (int group = 0; group < m_groups.size(); ++group) {
+        const int writers = std::min(m_maxWritersPerDevice, static_cast<int>(m_groups.at(group).size()));
+        for (int writer = 0; writer < writers; ++writer) {
+            m_pool.start([this, group]() { runLane(group); });
+        }
+    }
+}
+
+void CommitPipeline::cancel()
+{
+    m_cancelled = true;
+}
+
+void CommitPipeline::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void CommitPipeline::runLane(int group)
+{
+    const QVector<int> &indexes = m_groups.at(group);
+    const int total = m_jobs.size();
+
+    while (!m_cancelled.load()) {
+        const int position = m_nextInGroup[group].fetch_add(1);
+        if (position >= indexes.size()) {
+            break;
+        }
+
+        const CommitJob &job = m_jobs.at(indexes.at(position));
+        QString errorString;
+        const bool ok = m_checkAudioPayload ? writeChecked(job, &errorString)
+                                            : TagEngine::writeProperties(job.filePath, job.changes, &errorString);
+        if (!ok) {
+            ++m_failed;
+        }
+
+        const int done = ++m_done;
+        emit fileCommitted(job.filePath, ok, errorString);
+        emit progress(done, total);
+    }
+
+    // The last lane reads the results before it releases the extra count
+    // taken by start(): once none is left, start() may reset the counters
+    // and restart the timer for the next batch
+    if (--m_activeLanes == 1) {
+        const int done = m_done.load();
+        const int failed = m_failed.load();
+        const qint64 elapsedMs = m_timer.elapsed();
+        m_activeLanes = 0;
+        emit finished(done - failed, failed, elapsedMs);
+    }
+}
+
+bool CommitPipeline::writeChecked(const CommitJob &job, QString *errorString)
+{
+    const PayloadHasher::Result before = PayloadHasher::hashFile(job.filePath);
+
+    if (!TagEngine::writeProperties(job.filePath, job.changes, errorString)) {
+        return false;
+    }
+
+    // Files whose layout the hasher does not understand are saved unchecked
+    if (!before.ok) {
+        return true;
+    }
+
+    const PayloadHasher::Result after = PayloadHasher::hashFile(job.filePath);
+    if (!after.ok || after.hash != before.hash) {
+        *errorString = QStringLiteral("The save changed the audio data");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef COMMITPIPELINE_H
+#define COMMITPIPELINE_H
+
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QVector>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <memory>
+
+// Property changes to write to a single file
+struct CommitJob
+{
+    QString filePath;
+    QMap<QString, QString> changes;
+};
+
+// Saves tag changes to many files on a bounded worker pool.
+//
+// Files are grouped by the storage device they live on and each device gets at
+// most maxWritersPerDevice concurrent writers, so a batch spanning several
+// disks keeps all of them busy without thrashing any single one. Signals are
+// emitted from worker threads; receivers in the GUI thread get them queued.
+//
+// With checkAudioPayload set, each worker hashes the audio payload of its file
+// before and after the write (see PayloadHasher) and reports the file as
+// failed if the save changed it.
+class CommitPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CommitPipeline(QObject *parent = nullptr);
+    ~CommitPipeline();
+
+    void setMaxThreads(int count);
+    int maxThreads() const;
+    void setMaxWritersPerDevice(int count);
+    int maxWritersPerDevice() const;
+    void setCheckAudioPayload(bool check);
+    bool checkAudioPayload() const;
+
+    bool isRunning() const;
+
+    // Starts committing jobs in the background. Ignored while already running.
+    void start(const QVector<CommitJob> &jobs);
+    // Skips all jobs that have not started yet
+    void cancel();
+    void waitForDone();
+
+    // Identifies the storage device holding filePath
+    static QString deviceKey(const QString &filePath);
+
+signals:
+    void fileCommitted(const QString &filePath, bool ok, const QString &errorString);
+    void progress(int done, int total);
+    void finished(int succeeded, int failed, qint64 elapsedMs);
+
+private:
+    void runLane(int group);
+    static bool writeChecked(const CommitJob &job, QString *errorString);
+
+    QThreadPool m_pool;
+    int m_maxWritersPerDevice;
+    bool m_checkAudioPayload;
+
+    QVector<CommitJob> m_jobs;
+    QVector<QVector<int>> m_groups;
+    std::unique_ptr<std::atomic<int>[]> m_nextInGroup;
+    std::atomic<int> m_done;
+    std::atomic<int> m_failed;
+    std::atomic<int> m_activeLanes;
+    std::atomic<bool> m_cancelled;
+    QElapsedTimer m_timer;
+};
+
+#endif // COMMITPIPELINE_H
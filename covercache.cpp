@@ -0,0 +1,167 @@
+#include "covercache.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+CoverCache::CoverCache(QObject *parent)
+    : QObject(parent)
+    , m_diskCacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/covers")
+{
+    m_pool.setMaxThreadCount(2);
+
+    // Cost is in KiB of decoded pixels
+    m_memoryCache.setMaxCost(32 * 1024);
+
+    QDir().mkpath(m_diskCacheDir);
+
+    // Counts the existing entries and trims a cache left over the limit
+    m_pool.start([this]() { pruneDiskCache(); });
+}
+
+CoverCache::~CoverCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString CoverCache::cacheKey(const QByteArray &coverData, const QSize &size)
+{
+    const QByteArray hash = QCryptographicHash::hash(coverData, QCryptographicHash::Sha1).toHex();
+    return QString("%1-%2x%3").arg(QString::fromLatin1(hash)).arg(size.width()).arg(size.height());
+}
+
+void CoverCache::requestThumbnail(const QString &owner, const QByteArray &coverData, const QSize &size)
+{
+    if (coverData.isEmpty()) {
+        emit thumbnailReady(owner, QImage());
+        return;
+    }
+
+    m_pool.start([this, owner, coverData, size]() {
+        const QImage image = thumbnail(coverData, size);
+        QMetaObject::invokeMethod(this, [this, owner, image]() {
+            emit thumbnailReady(owner, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QImage CoverCache::thumbnail(const QByteArray &coverData, const QSize &size)
+{
+    const QString key = cacheKey(coverData, size);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QImage *cached = m_memoryCache.object(key)) {
+            return *cached;
+        }
+    }
+
+    const QString diskPath = diskCachePath(key);
+    QImage image(diskPath);
+
+    if (!image.isNull()) {
+        // Marks the entry as recently used for pruning
+        QFile file(diskPath);
+        if (file.open(QIODevice::ReadOnly)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+    } else {
+        QBuffer buffer;
+        buffer.setData(coverData);
+        buffer.open(QIODevice::ReadOnly);
+
+        // Decode straight to the target size instead of scaling a full-size image
+        QImageReader reader(&buffer);
+        const QSize originalSize = reader.size();
+        if (originalSize.isValid()
+            && (originalSize.width() > size.width() || originalSize.height() > size.height())) {
+            reader.setScaledSize(originalSize.scaled(size, Qt::KeepAspectRatio));
+        }
+
+        if (!reader.read(&image)) {
+            return QImage();
+        }
+
+        // Written atomically since another worker may read the same entry
+        QSaveFile file(diskPath);
+        if (file.open(QIODevice::WriteOnly) && image.save(&file, image.hasAlphaChannel() ? "PNG" : "JPG")) {
+            const qint64 written = file.size();
+            if (file.commit()) {
+                addDiskCacheBytes(written);
+            }
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_memoryCache.insert(key, new QImage(image), 1 + static_cast<int>(image.sizeInBytes() / 1024));
+    return image;
+}
+
+QString CoverCache::diskCachePath(const QString &key) const
+{
+    return m_diskCacheDir + QLatin1Char('/') + key;
+}
+
+void CoverCache::addDiskCacheBytes(qint64 bytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_diskCacheBytes < 0) {
+            return;
+        }
+        m_diskCacheBytes += bytes;
+        if (m_diskCacheBytes <= DiskCacheLimit) {
+            return;
+        }
+    }
+    pruneDiskCache();
+}
+
+void CoverCache::pruneDiskCache()
+{
+    qint64 countedBefore;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pruning) {
+            return;
+        }
+        m_pruning = true;
+        countedBefore = m_diskCacheBytes;
+    }
+
+    // Least recently used first
+    const QFileInfoList entries = QDir(m_diskCacheDir).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+    }
+
+    if (total > DiskCacheLimit) {
+        for (const QFileInfo &entry : entries) {
+            if (total <= DiskCacheLimit / 4 * 3) {
+                break;
+            }
+            if (QFile::remove(entry.filePath())) {
+                total -= entry.size();
+            }
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // Keeps what other workers added while the directory was listed
+    if (countedBefore >= 0) {
+        total += m_diskCacheBytes - countedBefore;
+    }
+    m_diskCacheBytes = total;
+    m_pruning = false;
+}
@@ -0,0 +1,59 @@
+#ifndef COVERCACHE_H
+#define COVERCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QSize>
+#include <QImage>
+#include <QCache>
+#include <QMutex>
+#include <QThreadPool>
+
+// Decodes cover art into thumbnails on worker threads.
+//
+// Pictures are decoded straight to the requested size with
+// QImageReader::setScaledSize and kept in an in-memory LRU cache and an
+// on-disk cache, both keyed by a hash of the encoded picture and the size.
+// The same cover shared by a whole album is therefore decoded once, and any
+// view (editor, player, a grid of albums) can ask for it by owner.
+//
+// The disk cache is capped at DiskCacheLimit bytes. Every hit refreshes the
+// modification time of its file, and when a new entry takes the cache over
+// the cap the least recently used files are removed down to three quarters
+// of it.
+class CoverCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CoverCache(QObject *parent = nullptr);
+    ~CoverCache();
+
+    // Requests a thumbnail of coverData that fits into size. thumbnailReady
+    // is emitted in the GUI thread with the same owner, e.g. a file path.
+    void requestThumbnail(const QString &owner, const QByteArray &coverData, const QSize &size);
+
+    static QString cacheKey(const QByteArray &coverData, const QSize &size);
+
+    static constexpr qint64 DiskCacheLimit = 64 * 1024 * 1024;
+
+signals:
+    void thumbnailReady(const QString &owner, const QImage &image);
+
+private:
+    QImage thumbnail(const QByteArray &coverData, const QSize &size);
+    QString diskCachePath(const QString &key) const;
+    void addDiskCacheBytes(qint64 bytes);
+    void pruneDiskCache();
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QCache<QString, QImage> m_memoryCache;
+    QString m_diskCacheDir;
+    // Estimated size of the disk cache, -1 until it has been counted
+    qint64 m_diskCacheBytes = -1;
+    bool m_pruning = false;
+};
+
+#endif // COVERCACHE_H
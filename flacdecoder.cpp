@@ -0,0 +1,647 @@
+#include "flacdecoder.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+unsigned int countLeadingZeros(std::uint64_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - index;
+#else
+    return static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+}
+
+std::uint64_t loadBigEndian64(const unsigned char *data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _byteswap_uint64(value);
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(value);
+#else
+    return value;
+#endif
+}
+
+template <typename T, unsigned int Bits, unsigned int Polynomial>
+constexpr std::array<T, 256> makeCrcTable()
+{
+    std::array<T, 256> table{};
+    for (unsigned int i = 0; i < 256; ++i) {
+        unsigned int crc = i << (Bits - 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & (1u << (Bits - 1))) ? (crc << 1) ^ Polynomial : crc << 1;
+        }
+        table[i] = static_cast<T>(crc);
+    }
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> crc8Table = makeCrcTable<std::uint8_t, 8, 0x07>();
+constexpr std::array<std::uint16_t, 256> crc16Table = makeCrcTable<std::uint16_t, 16, 0x8005>();
+
+unsigned int frameHeaderCrc(const unsigned char *data, std::size_t length)
+{
+    unsigned int crc = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = crc8Table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+unsigned int frameCrc(const unsigned char *data, std::size_t length)
+{
+    unsigned int crc = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = ((crc << 8) & 0xffff) ^ crc16Table[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+// Writes the channels of a frame as interleaved little-endian samples
+template <unsigned int Bytes>
+void interleave(const std::int64_t *channelData, unsigned int channels, unsigned int blockSize,
+                unsigned char *output)
+{
+    for (unsigned int i = 0; i < blockSize; ++i) {
+        for (unsigned int channel = 0; channel < channels; ++channel) {
+            const std::uint64_t sample = static_cast<std::uint64_t>(channelData[channel * blockSize + i]);
+            for (unsigned int byte = 0; byte < Bytes; ++byte) {
+                *output++ = static_cast<unsigned char>(sample >> (8 * byte));
+            }
+        }
+    }
+}
+
+} // namespace
+
+// Big-endian bit reader over one frame. Reads past the end return zero bits
+// and are reported by overrun(), so the hot loops need no bounds checks.
+class FlacDecoder::BitReader
+{
+public:
+    BitReader(const unsigned char *data, std::size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_bit(0)
+    {
+    }
+
+    // Reads up to 32 bits as an unsigned value
+    std::uint32_t read(unsigned int bits)
+    {
+        if (bits == 0) {
+            return 0;
+        }
+        const std::uint64_t value = window();
+        m_bit += bits;
+        return static_cast<std::uint32_t>(value >> (64 - bits));
+    }
+
+    // Reads up to 33 bits as a two's complement value; side channels of
+    // 32-bit streams need the extra bit
+    std::int64_t readSigned(unsigned int bits)
+    {
+        if (bits == 0) {
+            return 0;
+        }
+        std::uint64_t value;
+        if (bits > 32) {
+            value = static_cast<std::uint64_t>(read(bits - 32)) << 32;
+            value |= read(32);
+        } else {
+            value = read(bits);
+        }
+        return static_cast<std::int64_t>(value << (64 - bits)) >> (64 - bits);
+    }
+
+    // Counts zero bits up to and including the terminating one bit
+    std::uint32_t readUnary()
+    {
+        std::uint32_t zeros = 0;
+        for (;;) {
+            // At least 57 bits of the window are valid
+            const std::uint64_t value = window();
+            if (value != 0) {
+                const unsigned int leading = countLeadingZeros(value);
+                m_bit += leading + 1;
+                return zeros + leading;
+            }
+            m_bit += 56;
+            zeros += 56;
+            if (overrun()) {
+                return zeros;
+            }
+        }
+    }
+
+    // Reads a Rice coded value and folds it back to a signed residual. The
+    // quotient and remainder usually come out of a single window.
+    std::int64_t readRice(unsigned int parameter)
+    {
+        std::uint64_t value = window();
+        std::uint64_t quotient;
+        unsigned int leading;
+        if (value != 0 && (leading = countLeadingZeros(value)) + 1 + parameter <= 57) {
+            quotient = leading;
+            value <<= leading + 1;
+            m_bit += leading + 1 + parameter;
+        } else {
+            quotient = readUnary();
+            value = static_cast<std::uint64_t>(read(parameter)) << (64 - (parameter ? parameter : 1));
+        }
+        const std::uint64_t folded = (quotient << parameter) | (parameter ? value >> (64 - parameter) : 0);
+        return static_cast<std::int64_t>(folded >> 1) ^ -static_cast<std::int64_t>(folded & 1);
+    }
+
+    void alignToByte()
+    {
+        m_bit = (m_bit + 7) & ~static_cast<std::uint64_t>(7);
+    }
+
+    std::size_t bytePosition() const
+    {
+        return static_cast<std::size_t>(m_bit >> 3);
+    }
+
+    bool overrun() const
+    {
+        return m_bit > static_cast<std::uint64_t>(m_size) * 8;
+    }
+
+private:
+    // The next 64 bits starting at the current bit position, left aligned
+    std::uint64_t window() const
+    {
+        const std::size_t byte = static_cast<std::size_t>(m_bit >> 3);
+        std::uint64_t value = 0;
+        if (byte + 8 <= m_size) {
+            value = loadBigEndian64(m_data + byte);
+        } else {
+            for (std::size_t i = 0; i < 8; ++i) {
+                value = (value << 8) | (byte + i < m_size ? m_data[byte + i] : 0);
+            }
+        }
+        return value << (m_bit & 7);
+    }
+
+    const unsigned char *m_data;
+    std::size_t m_size;
+    std::uint64_t m_bit;
+};
+
+FlacDecoder::FlacDecoder(const unsigned char *data, std::size_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_position(0)
+    , m_audioOffset(0)
+    , m_decodedSamples(0)
+    , m_blockSize(0)
+    , m_atEnd(false)
+{
+}
+
+bool FlacDecoder::readHeader()
+{
+    m_position = 0;
+
+    // Tools that do not know better sometimes prepend ID3v2 tags
+    while (m_size - m_position >= 10 && std::memcmp(m_data + m_position, "ID3", 3) == 0) {
+        const unsigned char *header = m_data + m_position;
+        std::size_t tagSize = (static_cast<std::size_t>(header[6] & 0x7f) << 21)
+                              | (static_cast<std::size_t>(header[7] & 0x7f) << 14)
+                              | (static_cast<std::size_t>(header[8] & 0x7f) << 7)
+                              | static_cast<std::size_t>(header[9] & 0x7f);
+        tagSize += (header[5] & 0x10) ? 20 : 10;
+        if (tagSize > m_size - m_position) {
+            return fail("Truncated ID3v2 tag");
+        }
+        m_position += tagSize;
+    }
+
+    if (m_size - m_position < 4 || std::memcmp(m_data + m_position, "fLaC", 4) != 0) {
+        return fail("Not a FLAC stream");
+    }
+    m_position += 4;
+
+    bool haveStreamInfo = false;
+    bool last = false;
+    while (!last) {
+        if (m_size - m_position < 4) {
+            return fail("Truncated metadata");
+        }
+
+        const unsigned char *header = m_data + m_position;
+        last = (header[0] & 0x80) != 0;
+        const unsigned int type = header[0] & 0x7f;
+        const std::size_t length = (static_cast<std::size_t>(header[1]) << 16)
+                                   | (static_cast<std::size_t>(header[2]) << 8) | header[3];
+        m_position += 4;
+
+        if (length > m_size - m_position) {
+            return fail("Truncated metadata");
+        }
+
+        if (type == 0) {
+            if (length < 34) {
+                return fail("Invalid STREAMINFO block");
+            }
+
+            const unsigned char *block = m_data + m_position;
+            m_info.sampleRate = (static_cast<unsigned int>(block[10]) << 12)
+                                | (static_cast<unsigned int>(block[11]) << 4) | (block[12] >> 4);
+            m_info.channels = ((block[12] >> 1) & 0x07) + 1;
+            m_info.bitsPerSample = (((block[12] & 0x01) << 4) | (block[13] >> 4)) + 1;
+            m_info.totalSamples = (static_cast<std::uint64_t>(block[13] & 0x0f) << 32)
+                                  | (static_cast<std::uint64_t>(block[14]) << 24)
+                                  | (static_cast<std::uint64_t>(block[15]) << 16)
+                                  | (static_cast<std::uint64_t>(block[16]) << 8) | block[17];
+            std::memcpy(m_info.md5, block + 18, 16);
+            haveStreamInfo = true;
+        } else if (type == 127) {
+            return fail("Invalid metadata block");
+        }
+
+        m_position += length;
+    }
+
+    if (!haveStreamInfo) {
+        return fail("Missing STREAMINFO block");
+    }
+    if (m_info.bitsPerSample < 4) {
+        return fail("Unsupported sample size");
+    }
+
+    m_audioOffset = m_position;
+    return true;
+}
+
+const FlacDecoder::StreamInfo &FlacDecoder::streamInfo() const
+{
+    return m_info;
+}
+
+bool FlacDecoder::decodeFrame(std::vector<unsigned char> &out)
+{
+    out.clear();
+
+    if (m_atEnd || !m_error.empty()) {
+        return false;
+    }
+
+    if (m_info.totalSamples > 0 && m_decodedSamples >= m_info.totalSamples) {
+        m_atEnd = true;
+        return false;
+    }
+
+    const std::size_t remaining = m_size - m_position;
+    if (remaining < 2 || m_data[m_position] != 0xff || (m_data[m_position + 1] & 0xfe) != 0xf8) {
+        // Without a sample count the stream simply ends, possibly followed by
+        // an ID3v1 tag; otherwise samples are missing
+        if (m_info.totalSamples == 0) {
+            m_atEnd = true;
+            return false;
+        }
+        return fail(remaining < 2 ? "Audio data is truncated" : "Lost frame sync");
+    }
+
+    BitReader reader(m_data + m_position, remaining);
+    reader.read(16);
+
+    const unsigned int blockSizeCode = reader.read(4);
+    const unsigned int sampleRateCode = reader.read(4);
+    const unsigned int channelAssignment = reader.read(4);
+    const unsigned int sampleSizeCode = reader.read(3);
+    if (reader.read(1) != 0) {
+        return fail("Invalid frame header");
+    }
+
+    // Frame or sample number, UTF-8 style; only validated
+    const std::uint32_t first = reader.read(8);
+    if (first & 0x80) {
+        if (first == 0xff || (first & 0xc0) == 0x80) {
+            return fail("Invalid frame number");
+        }
+        for (std::uint32_t mask = 0x40; first & mask; mask >>= 1) {
+            if ((reader.read(8) & 0xc0) != 0x80) {
+                return fail("Invalid frame number");
+            }
+        }
+    }
+
+    unsigned int blockSize;
+    switch (blockSizeCode) {
+    case 0:
+        return fail("Invalid block size");
+    case 1:
+        blockSize = 192;
+        break;
+    case 2:
+    case 3:
+    case 4:
+    case 5:
+        blockSize = 576u << (blockSizeCode - 2);
+        break;
+    case 6:
+        blockSize = reader.read(8) + 1;
+        break;
+    case 7:
+        blockSize = reader.read(16) + 1;
+        break;
+    default:
+        blockSize = 256u << (blockSizeCode - 8);
+        break;
+    }
+
+    if (sampleRateCode == 12) {
+        reader.read(8);
+    } else if (sampleRateCode == 13 || sampleRateCode == 14) {
+        reader.read(16);
+    } else if (sampleRateCode == 15) {
+        return fail("Invalid sample rate");
+    }
+
+    unsigned int channels;
+    if (channelAssignment < 8) {
+        channels = channelAssignment + 1;
+    } else if (channelAssignment <= 10) {
+        channels = 2;
+    } else {
+        return fail("Invalid channel assignment");
+    }
+
+    static const unsigned int sampleSizes[] = {0, 8, 12, 0, 16, 20, 24, 32};
+    const unsigned int bitsPerSample = sampleSizeCode == 0 ? m_info.bitsPerSample : sampleSizes[sampleSizeCode];
+
+    // The MD5 layout is fixed by STREAMINFO, so frames must agree with it
+    if (channels != m_info.channels || bitsPerSample != m_info.bitsPerSample) {
+        return fail("Frame format differs from STREAMINFO");
+    }
+
+    const std::size_t headerLength = reader.bytePosition();
+    if (reader.overrun() || frameHeaderCrc(m_data + m_position, headerLength) != reader.read(8)) {
+        return fail("Frame header CRC mismatch");
+    }
+
+    m_blockSize = blockSize;
+    m_channelData.resize(static_cast<std::size_t>(channels) * blockSize);
+
+    for (unsigned int channel = 0; channel < channels; ++channel) {
+        // The side channel needs one more bit than the others
+        const bool side = (channelAssignment == 8 && channel == 1)
+                          || (channelAssignment == 9 && channel == 0)
+                          || (channelAssignment == 10 && channel == 1);
+        if (!decodeSubframe(reader, bitsPerSample + (side ? 1 : 0),
+                            m_channelData.data() + static_cast<std::size_t>(channel) * blockSize)) {
+            return false;
+        }
+    }
+
+    reader.alignToByte();
+    const std::size_t frameLength = reader.bytePosition();
+    if (reader.overrun() || frameLength + 2 > remaining) {
+        return fail("Audio data is truncated");
+    }
+
+    const unsigned int storedCrc = (static_cast<unsigned int>(m_data[m_position + frameLength]) << 8)
+                                   | m_data[m_position + frameLength + 1];
+    if (frameCrc(m_data + m_position, frameLength) != storedCrc) {
+        return fail("Frame CRC mismatch");
+    }
+
+    std::int64_t *left = m_channelData.data();
+    std::int64_t *right = left + blockSize;
+    switch (channelAssignment) {
+    case 8:
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            right[i] = left[i] - right[i];
+        }
+        break;
+    case 9:
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            left[i] += right[i];
+        }
+        break;
+    case 10:
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            const std::int64_t side = right[i];
+            const std::int64_t mid = left[i] * 2 + (side & 1);
+            left[i] = (mid + side) >> 1;
+            right[i] = (mid - side) >> 1;
+        }
+        break;
+    default:
+        break;
+    }
+
+    const unsigned int bytesPerSample = (bitsPerSample + 7) / 8;
+    out.resize(static_cast<std::size_t>(blockSize) * channels * bytesPerSample);
+    const std::int64_t *channelData = m_channelData.data();
+    switch (bytesPerSample) {
+    case 1:
+        interleave<1>(channelData, channels, blockSize, out.data());
+        break;
+    case 2:
+        interleave<2>(channelData, channels, blockSize, out.data());
+        break;
+    case 3:
+        interleave<3>(channelData, channels, blockSize, out.data());
+        break;
+    default:
+        interleave<4>(channelData, channels, blockSize, out.data());
+        break;
+    }
+
+    m_position += frameLength + 2;
+    m_decodedSamples += blockSize;
+    return true;
+}
+
+bool FlacDecoder::atEnd() const
+{
+    return m_atEnd;
+}
+
+std::string FlacDecoder::errorString() const
+{
+    return m_error;
+}
+
+std::size_t FlacDecoder::audioOffset() const
+{
+    return m_audioOffset;
+}
+
+std::uint64_t FlacDecoder::decodedSamples() const
+{
+    return m_decodedSamples;
+}
+
+bool FlacDecoder::fail(const char *message)
+{
+    m_error = message;
+    return false;
+}
+
+bool FlacDecoder::decodeSubframe(BitReader &reader, unsigned int bitsPerSample, std::int64_t *samples)
+{
+    if (reader.read(1) != 0) {
+        return fail("Invalid subframe header");
+    }
+
+    const unsigned int type = reader.read(6);
+
+    unsigned int wastedBits = 0;
+    if (reader.read(1)) {
+        wastedBits = reader.readUnary() + 1;
+        if (wastedBits >= bitsPerSample) {
+            return fail("Invalid wasted bits");
+        }
+        bitsPerSample -= wastedBits;
+    }
+
+    const unsigned int blockSize = m_blockSize;
+
+    if (type == 0) {
+        const std::int64_t value = reader.readSigned(bitsPerSample);
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            samples[i] = value;
+        }
+    } else if (type == 1) {
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            samples[i] = reader.readSigned(bitsPerSample);
+        }
+    } else if (type >= 8 && type <= 12) {
+        const unsigned int order = type - 8;
+        if (order > blockSize) {
+            return fail("Invalid predictor order");
+        }
+        for (unsigned int i = 0; i < order; ++i) {
+            samples[i] = reader.readSigned(bitsPerSample);
+        }
+        if (!decodeResidual(reader, order, samples)) {
+            return false;
+        }
+
+        switch (order) {
+        case 1:
+            for (unsigned int i = 1; i < blockSize; ++i) {
+                samples[i] += samples[i - 1];
+            }
+            break;
+        case 2:
+            for (unsigned int i = 2; i < blockSize; ++i) {
+                samples[i] += 2 * samples[i - 1] - samples[i - 2];
+            }
+            break;
+        case 3:
+            for (unsigned int i = 3; i < blockSize; ++i) {
+                samples[i] += 3 * samples[i - 1] - 3 * samples[i - 2] + samples[i - 3];
+            }
+            break;
+        case 4:
+            for (unsigned int i = 4; i < blockSize; ++i) {
+                samples[i] += 4 * samples[i - 1] - 6 * samples[i - 2] + 4 * samples[i - 3] - samples[i - 4];
+            }
+            break;
+        default:
+            break;
+        }
+    } else if (type >= 32) {
+        const unsigned int order = type - 31;
+        if (order > blockSize) {
+            return fail("Invalid predictor order");
+        }
+        for (unsigned int i = 0; i < order; ++i) {
+            samples[i] = reader.readSigned(bitsPerSample);
+        }
+
+        const unsigned int precision = reader.read(4) + 1;
+        const std::int64_t shift = reader.readSigned(5);
+        if (precision == 16 || shift < 0) {
+            return fail("Invalid LPC parameters");
+        }
+
+        std::int64_t coefficients[32];
+        for (unsigned int i = 0; i < order; ++i) {
+            coefficients[i] = reader.readSigned(precision);
+        }
+
+        if (!decodeResidual(reader, order, samples)) {
+            return false;
+        }
+
+        for (unsigned int i = order; i < blockSize; ++i) {
+            std::int64_t prediction = 0;
+            for (unsigned int j = 0; j < order; ++j) {
+                prediction += coefficients[j] * samples[i - 1 - j];
+            }
+            samples[i] += prediction >> shift;
+        }
+    } else {
+        return fail("Reserved subframe type");
+    }
+
+    if (wastedBits > 0) {
+        const std::int64_t factor = static_cast<std::int64_t>(1) << wastedBits;
+        for (unsigned int i = 0; i < blockSize; ++i) {
+            samples[i] *= factor;
+        }
+    }
+
+    if (reader.overrun()) {
+        return fail("Audio data is truncated");
+    }
+    return true;
+}
+
+bool FlacDecoder::decodeResidual(BitReader &reader, unsigned int predictorOrder, std::int64_t *samples)
+{
+    const unsigned int method = reader.read(2);
+    if (method > 1) {
+        return fail("Reserved residual coding method");
+    }
+
+    const unsigned int parameterBits = method == 0 ? 4 : 5;
+    const unsigned int escapeCode = method == 0 ? 15 : 31;
+    const unsigned int partitionOrder = reader.read(4);
+    const unsigned int partitions = 1u << partitionOrder;
+    const unsigned int partitionSize = m_blockSize >> partitionOrder;
+
+    if ((m_blockSize & (partitions - 1)) != 0 || partitionSize < predictorOrder) {
+        return fail("Invalid residual partition order");
+    }
+
+    std::int64_t *output = samples + predictorOrder;
+    for (unsigned int partition = 0; partition < partitions; ++partition) {
+        const unsigned int count = partition == 0 ? partitionSize - predictorOrder : partitionSize;
+        const unsigned int parameter = reader.read(parameterBits);
+
+        if (parameter == escapeCode) {
+            const unsigned int bits = reader.read(5);
+            for (unsigned int i = 0; i < count; ++i) {
+                *output++ = reader.readSigned(bits);
+            }
+        } else {
+            for (unsigned int i = 0; i < count; ++i) {
+                *output++ = reader.readRice(parameter);
+            }
+        }
+
+        if (reader.overrun()) {
+            return fail("Audio data is truncated");
+        }
+    }
+
+    return true;
+}
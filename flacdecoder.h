@@ -0,0 +1,65 @@
+#ifndef FLACDECODER_H
+#define FLACDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Decodes the audio frames of a FLAC stream held in memory (e.g. a mapped file).
+//
+// Frames are decoded one at a time into interleaved little-endian samples of
+// (bitsPerSample + 7) / 8 bytes, the layout the STREAMINFO MD5 is computed
+// over, so a caller can hash a whole file without ever holding more than one
+// frame of PCM. Only what is needed for verification is implemented: there is
+// no seeking and metadata other than STREAMINFO is skipped.
+class FlacDecoder
+{
+public:
+    struct StreamInfo
+    {
+        unsigned int sampleRate = 0;
+        unsigned int channels = 0;
+        unsigned int bitsPerSample = 0;
+        // 0 if the encoder did not know the length
+        std::uint64_t totalSamples = 0;
+        unsigned char md5[16] = {};
+    };
+
+    FlacDecoder(const unsigned char *data, std::size_t size);
+
+    // Skips leading ID3v2 tags and parses the metadata blocks up to the first
+    // frame. Must succeed before decodeFrame() is called.
+    bool readHeader();
+    const StreamInfo &streamInfo() const;
+
+    // Decodes the next frame into out, replacing its contents. Returns false
+    // at the end of the stream or on error; see atEnd() and errorString().
+    bool decodeFrame(std::vector<unsigned char> &out);
+    bool atEnd() const;
+    std::string errorString() const;
+
+    // Offset of the first frame, i.e. where the audio data starts
+    std::size_t audioOffset() const;
+    std::uint64_t decodedSamples() const;
+
+private:
+    class BitReader;
+
+    bool fail(const char *message);
+    bool decodeSubframe(BitReader &reader, unsigned int bitsPerSample, std::int64_t *samples);
+    bool decodeResidual(BitReader &reader, unsigned int predictorOrder, std::int64_t *samples);
+
+    const unsigned char *m_data;
+    std::size_t m_size;
+    std::size_t m_position;
+    std::size_t m_audioOffset;
+    StreamInfo m_info;
+    std::uint64_t m_decodedSamples;
+    unsigned int m_blockSize;
+    bool m_atEnd;
+    std::string m_error;
+    std::vector<std::int64_t> m_channelData;
+};
+
+#endif // FLACDECODER_H
@@ -1,9 +1,18 @@
 #include "mainwindow.h"
+#include "batchrunner.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    // Batch mode runs without a GUI so it works on headless machines
+    if (BatchRunner::isBatchInvocation(argc, argv)) {
+        QCoreApplication a(argc, argv);
+        BatchRunner runner;
+        return runner.run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -2,12 +2,16 @@
 #include "ui_mainwindow.h"
 #include "mediaplayer.h"
 #include "settingsdialog.h"
+#include "commitpipeline.h"
+#include "tagloader.h"
+#include "covercache.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QDir>
 #include <QFileInfo>
+#include <QItemSelectionModel>
 #include <QDateTime>
 #include <QMimeDatabase>
 #include <QMimeType>
@@ -16,15 +20,6 @@
 #include <QPixmap>
 #include <QDebug>
 
-#include "taglib/fileref.h"
-#include "taglib/tag.h"
-#include "taglib/audioproperties.h"
-#include "taglib/mpeg/mpegfile.h"
-#include "taglib/mpeg/id3v2/id3v2tag.h"
-#include "taglib/mpeg/id3v2/frames/attachedpictureframe.h"
-#include "taglib/mpeg/id3v2/frames/textidentificationframe.h"
-#include "taglib/toolkit/tpropertymap.h"
-
 #include <algorithm>
 #include <memory>
 
@@ -33,8 +28,14 @@ MainWindow::MainWindow(QWidget *parent)
     , ui(new Ui::MainWindow)
     , fileSystemModel(new QFileSystemModel(this))
     , mediaPlayer(new MediaPlayer(this))
+    , commitPipeline(new CommitPipeline(this))
+    , audioVerifier(new AudioVerifier(this))
+    , tagLoader(new TagLoader(this))
+    , coverCache(new CoverCache(this))
     , currentFilePath("")
+    , coverModified(false)
     , undoPerformed(false)
+    , restoringSelection(false)
     , settings(new QSettings("Mp3TagQt", "Settings", this))
 {
     ui->setupUi(this);
@@ -49,6 +50,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    commitPipeline->cancel();
+    commitPipeline->waitForDone();
+    audioVerifier->cancel();
+    audioVerifier->waitForDone();
     delete ui;
 }
 
@@ -85,6 +90,8 @@ void MainWindow::setupUI()
     actionExit = ui->actionExit;
     actionAbout = ui->actionAbout;
     actionSettings = new QAction(tr("Settings"), this);
+    actionVerify = new QAction(tr("Verify audio integrity"), this);
+    actionVerify->setToolTip(tr("Check the audio of the selected FLAC files against their stored MD5"));
     actionUndo = ui->actionUndo;
     actionRedo = ui->actionRedo;
 
@@ -103,6 +110,7 @@ void MainWindow::setupUI()
     ui->mainToolBar->addAction(actionSave);
     ui->mainToolBar->addAction(actionRemove);
     ui->mainToolBar->addAction(actionSettings);
+    ui->mainToolBar->addAction(actionVerify);
     ui->mainToolBar->addSeparator();
     ui->mainToolBar->addAction(actionUndo);
     ui->mainToolBar->addAction(actionRedo);
@@ -153,6 +161,12 @@ void MainWindow::setupUI()
     playbackPositionValue->setText("00:00");
     playbackDurationValue->setText("00:00");
 
+    // Set up batch commit progress
+    commitProgressBar = new QProgressBar(this);
+    commitProgressBar->setMaximumWidth(200);
+    commitProgressBar->setVisible(false);
+    statusBar()->addPermanentWidget(commitProgressBar);
+
     // Set up splitter sizes
     ui->mainSplitter->setStretchFactor(0, 1);
     ui->mainSplitter->setStretchFactor(1, 2);
@@ -163,7 +177,7 @@ void MainWindow::setupFileSystemModel()
     // Set up file system model
     fileSystemModel->setRootPath(QDir::homePath());
     fileSystemModel->setFilter(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
-    fileSystemModel->setNameFilters(QStringList() << "*.mp3" << "*.flac" << "*.ogg" << "*.wma" << "*.m4a");
+    fileSystemModel->setNameFilters(TagEngine::supportedNameFilters());
     fileSystemModel->setNameFilterDisables(false);
 
     // Set model to tree view
@@ -172,6 +186,7 @@ void MainWindow::setupFileSystemModel()
     fileTreeView->setColumnHidden(1, true); // Hide size column
     fileTreeView->setColumnHidden(2, true); // Hide type column
     fileTreeView->setColumnHidden(3, true); // Hide date column
+    fileTreeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
 
     // Set header
     fileSystemModel->setHeaderData(0, Qt::Horizontal, tr("Files"));
@@ -194,9 +209,12 @@ void MainWindow::setupConnections()
     connect(actionUndo, &QAction::triggered, this, &MainWindow::on_actionUndo_triggered);
     connect(actionRedo, &QAction::triggered, this, &MainWindow::on_actionRedo_triggered);
     connect(actionSettings, &QAction::triggered, this, &MainWindow::on_actionSettings_triggered);
+    connect(actionVerify, &QAction::triggered, this, &MainWindow::on_actionVerify_triggered);
 
     // Connect file tree view
-    connect(fileTreeView, &QTreeView::doubleClicked, this, &MainWindow::on_fileTreeView_doubleClicked);
+    connect(fileTreeView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::handle_fileSelection_changed);
+    connect(tagLoader, &TagLoader::loaded, this, &MainWindow::handle_tagLoader_loaded);
+    connect(coverCache, &CoverCache::thumbnailReady, this, &MainWindow::handle_coverCache_thumbnailReady);
 
     // Connect tag edit fields
     connect(titleEdit, &QLineEdit::textChanged, this, &MainWindow::on_titleEdit_textChanged);
@@ -224,6 +242,16 @@ void MainWindow::setupConnections()
     connect(mediaPlayer, &MediaPlayer::durationChanged, this, &MainWindow::handle_mediaPlayer_durationChanged);
     connect(mediaPlayer, &MediaPlayer::volumeChanged, this, &MainWindow::handle_mediaPlayer_volumeChanged);
     connect(mediaPlayer, &MediaPlayer::errorOccurred, this, &MainWindow::handle_mediaPlayer_errorOccurred);
+
+    // Connect batch commit pipeline
+    connect(commitPipeline, &CommitPipeline::fileCommitted, this, &MainWindow::handle_commitPipeline_fileCommitted);
+    connect(commitPipeline, &CommitPipeline::progress, this, &MainWindow::handle_commitPipeline_progress);
+    connect(commitPipeline, &CommitPipeline::finished, this, &MainWindow::handle_commitPipeline_finished);
+
+    // Connect audio verification
+    connect(audioVerifier, &AudioVerifier::fileVerified, this, &MainWindow::handle_audioVerifier_fileVerified);
+    connect(audioVerifier, &AudioVerifier::progress, this, &MainWindow::handle_audioVerifier_progress);
+    connect(audioVerifier, &AudioVerifier::finished, this, &MainWindow::handle_audioVerifier_finished);
 }
 
 void MainWindow::on_actionOpen_triggered()
@@ -234,7 +262,7 @@ void MainWindow::on_actionOpen_triggered()
         QStandardPaths::standardLocations(QStandardPaths::MusicLocation).value(0, QDir::homePath()),
         tr("Audio Files (*.mp3 *.flac *.ogg *.wma *.m4a);;All Files (*)"));
 
-    if (!filePaths.isEmpty()) {
+    if (!filePaths.isEmpty() && maybeSaveChanges()) {
         // For simplicity, just load the first file
         loadMp3File(filePaths.first());
     }
@@ -242,6 +270,11 @@ void MainWindow::on_actionOpen_triggered()
 
 void MainWindow::on_actionSave_triggered()
 {
+    if (!batchFilePaths.isEmpty()) {
+        commitBatch();
+        return;
+    }
+
     if (currentFilePath.isEmpty()) {
         return;
     }
@@ -256,12 +289,24 @@ void MainWindow::on_actionSave_triggered()
 
 void MainWindow::on_actionRemove_triggered()
 {
+    if (!batchFilePaths.isEmpty()) {
+        // Mark every field as edited so the commit removes it from all files
+        for (const auto &editor : propertyEditors()) {
+            editor.first->clear();
+            editor.first->setModified(true);
+        }
+        updateStatusBar(tr("Tags cleared"));
+        enableSaveActions(true);
+        return;
+    }
+
     if (currentFilePath.isEmpty()) {
         return;
     }
 
-    // Clear all tags
+    // Clear all tags, including the cover
     clearTags();
+    coverModified = true;
     updateUIWithTags();
     updateStatusBar(tr("Tags cleared"));
     enableSaveActions(true);
@@ -286,33 +331,41 @@ void MainWindow::on_actionSettings_triggered()
     }
 }
 
+void MainWindow::on_actionVerify_triggered()
+{
+    if (audioVerifier->isRunning() || commitPipeline->isRunning()) {
+        updateStatusBar(tr("Another batch operation is in progress"));
+        return;
+    }
+
+    QStringList filePaths = batchFilePaths;
+    if (filePaths.isEmpty() && !currentFilePath.isEmpty()) {
+        filePaths << currentFilePath;
+    }
+
+    if (filePaths.isEmpty()) {
+        updateStatusBar(tr("Select the files to verify"));
+        return;
+    }
+
+    verifyErrors.clear();
+    commitProgressBar->setRange(0, filePaths.size());
+    commitProgressBar->setValue(0);
+    commitProgressBar->setVisible(true);
+    actionVerify->setEnabled(false);
+
+    audioVerifier->start(filePaths);
+}
+
 void MainWindow::on_actionUndo_triggered()
 {
     // Simple undo - restore original values
     if (!undoPerformed && !currentFilePath.isEmpty()) {
         // Save current values for redo
-        undoneTitle = titleEdit->text();
-        undoneArtist = artistEdit->text();
-        undoneAlbum = albumEdit->text();
-        undoneYear = yearEdit->text();
-        undoneGenre = genreEdit->text();
-        undoneComment = commentEdit->text();
-        undoneTrack = trackEdit->text();
-        undoneDisc = discEdit->text();
-        undoneComposer = composerEdit->text();
-        undoneAlbumArtist = albumArtistEdit->text();
+        undoneTags = tagsFromEditors();
 
         // Restore to original
-        titleEdit->setText(originalTitle);
-        artistEdit->setText(originalArtist);
-        albumEdit->setText(originalAlbum);
-        yearEdit->setText(originalYear);
-        genreEdit->setText(originalGenre);
-        commentEdit->setText(originalComment);
-        trackEdit->setText(originalTrack);
-        discEdit->setText(originalDisc);
-        composerEdit->setText(originalComposer);
-        albumArtistEdit->setText(originalAlbumArtist);
+        setEditorTags(originalTags);
 
         undoPerformed = true;
         updateStatusBar(tr("Changes undone"));
@@ -325,16 +378,7 @@ void MainWindow::on_actionRedo_triggered()
 {
     if (undoPerformed && !currentFilePath.isEmpty()) {
         // Restore to undone values
-        titleEdit->setText(undoneTitle);
-        artistEdit->setText(undoneArtist);
-        albumEdit->setText(undoneAlbum);
-        yearEdit->setText(undoneYear);
-        genreEdit->setText(undoneGenre);
-        commentEdit->setText(undoneComment);
-        trackEdit->setText(undoneTrack);
-        discEdit->setText(undoneDisc);
-        composerEdit->setText(undoneComposer);
-        albumArtistEdit->setText(undoneAlbumArtist);
+        setEditorTags(undoneTags);
 
         undoPerformed = false;
         updateStatusBar(tr("Changes redone"));
@@ -343,68 +387,144 @@ void MainWindow::on_actionRedo_triggered()
     }
 }
 
-void MainWindow::on_fileTreeView_doubleClicked(const QModelIndex &index)
+// Files are loaded when they become selected, so double-clicks need no
+// handler of their own
+void MainWindow::handle_fileSelection_changed()
+{
+    if (restoringSelection) {
+        return;
+    }
+
+    QStringList filePaths;
+    const QModelIndexList selectedRows = fileTreeView->selectionModel()->selectedRows();
+    for (const QModelIndex &index : selectedRows) {
+        if (!fileSystemModel->isDir(index)) {
+            QString filePath = fileSystemModel->filePath(index);
+            if (TagEngine::isSupportedFile(filePath)) {
+                filePaths << filePath;
+            }
+        }
+    }
+
+    // Browsing with the keyboard loads each file as it becomes current, which
+    // would throw away unsaved edits of the file shown so far
+    bool replacesEditor = false;
+    if (filePaths.size() > 1) {
+        replacesEditor = filePaths != batchFilePaths;
+    } else if (filePaths.size() == 1) {
+        replacesEditor = filePaths.first() != currentFilePath && filePaths.first() != tagLoader->pendingFile();
+    } else {
+        replacesEditor = !batchFilePaths.isEmpty();
+    }
+
+    if (!replacesEditor) {
+        return;
+    }
+
+    if (!maybeSaveChanges()) {
+        restoreFileSelection();
+        return;
+    }
+
+    if (filePaths.size() > 1) {
+        tagLoader->cancel();
+        enterBatchMode(filePaths);
+    } else if (filePaths.size() == 1) {
+        loadMp3File(filePaths.first());
+    } else {
+        leaveBatchMode();
+    }
+}
+
+// Asks what to do with unsaved edits before the editor shows other files.
+// Returns false if the user chose to stay.
+bool MainWindow::maybeSaveChanges()
+{
+    if (!actionSave->isEnabled()) {
+        return true;
+    }
+
+    const QMessageBox::StandardButton answer = QMessageBox::question(
+        this, tr("Unsaved Changes"), tr("The tags have been modified. Do you want to save your changes?"),
+        QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Save);
+
+    if (answer == QMessageBox::Save) {
+        // A batch keeps saving in the background once its jobs are queued
+        return batchFilePaths.isEmpty() ? writeMp3Tags() : commitBatch();
+    }
+
+    return answer == QMessageBox::Discard;
+}
+
+// Selects the files the editor still shows
+void MainWindow::restoreFileSelection()
 {
-    if (!fileSystemModel->isDir(index)) {
-        QString filePath = fileSystemModel->filePath(index);
-        QFileInfo fileInfo(filePath);
+    const QStringList filePaths = batchFilePaths.isEmpty() ? QStringList{currentFilePath} : batchFilePaths;
 
-        // Check if it's an audio file
-        QStringList audioExtensions = {"mp3", "flac", "ogg", "wma", "m4a"};
-        if (audioExtensions.contains(fileInfo.suffix().toLower())) {
-            loadMp3File(filePath);
+    QItemSelection selection;
+    for (const QString &filePath : filePaths) {
+        const QModelIndex index = fileSystemModel->index(filePath);
+        if (index.isValid()) {
+            selection.select(index, index);
         }
     }
+
+    restoringSelection = true;
+    fileTreeView->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    if (!currentFilePath.isEmpty()) {
+        fileTreeView->selectionModel()->setCurrentIndex(fileSystemModel->index(currentFilePath), QItemSelectionModel::NoUpdate);
+    }
+    restoringSelection = false;
 }
 
 void MainWindow::on_titleEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalTitle);
+    updateModifiedState(text != originalTags.title);
 }
 
 void MainWindow::on_artistEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalArtist);
+    updateModifiedState(text != originalTags.artist);
 }
 
 void MainWindow::on_albumEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalAlbum);
+    updateModifiedState(text != originalTags.album);
 }
 
 void MainWindow::on_yearEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalYear);
+    updateModifiedState(text != originalTags.year);
 }
 
 void MainWindow::on_genreEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalGenre);
+    updateModifiedState(text != originalTags.genre);
 }
 
 void MainWindow::on_commentEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalComment);
+    updateModifiedState(text != originalTags.comment);
 }
 
 void MainWindow::on_trackEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalTrack);
+    updateModifiedState(text != originalTags.track);
 }
 
 void MainWindow::on_discEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalDisc);
+    updateModifiedState(text != originalTags.disc);
 }
 
 void MainWindow::on_composerEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalComposer);
+    updateModifiedState(text != originalTags.composer);
 }
 
 void MainWindow::on_albumArtistEdit_textChanged(const QString &text)
 {
-    enableSaveActions(text != originalAlbumArtist);
+    updateModifiedState(text != originalTags.albumArtist);
 }
 
 bool MainWindow::loadMp3File(const QString &filePath)
@@ -416,100 +536,89 @@ bool MainWindow::loadMp3File(const QString &filePath)
     }
 
     // Clear previous data
+    if (!batchFilePaths.isEmpty()) {
+        leaveBatchMode();
+    }
     clearTags();
+    currentFilePath.clear();
+    updatePlayerUI();
+    enableSaveActions(false);
 
-    try {
-        TagLib::FileRef fileRef(filePath.toUtf8().constData());
+    // Tags arrive in handle_tagLoader_loaded, from the cache if the file is unchanged
+    updateStatusBar(tr("Loading: %1").arg(fileInfo.fileName()));
+    tagLoader->load(filePath);
+    return true;
+}
 
-        if (fileRef.isNull()) {
-            QMessageBox::warning(this, tr("Error"), tr("Could not open file for reading"));
-            return false;
-        }
+void MainWindow::handle_tagLoader_loaded(const QString &filePath, const LoadedFile &file)
+{
+    if (!file.ok) {
+        // Loads run in the background while browsing, so a failure must not
+        // interrupt the user with a dialog; it stays until the next message
+        statusBar()->showMessage(tr("Failed to load %1: %2").arg(QFileInfo(filePath).fileName(), file.errorString));
+        return;
+    }
 
-        // Read tags
-        readMp3Tags(fileRef);
+    originalTags = file.tags;
 
-        // Update UI
-        currentFilePath = filePath;
-        updateUIWithTags();
-        updateFileInfo(filePath);
-        updatePlayerUI(); // Update player UI when file is loaded
+    // Update UI
+    currentFilePath = filePath;
+    coverArt = file.cover;
+    coverModified = false;
+    showCoverArt(coverArt);
+    updateUIWithTags();
+    updateFileInfo(filePath);
+    updatePlayerUI(); // Update player UI when file is loaded
 
-        updateStatusBar(tr("Loaded: %1").arg(fileInfo.fileName()));
-        enableSaveActions(false);
-        undoPerformed = false;
+    updateStatusBar(tr("Loaded: %1").arg(QFileInfo(filePath).fileName()));
+    enableSaveActions(false);
+    undoPerformed = false;
 
-        return true;
-    } catch (const std::exception &e) {
-        QMessageBox::warning(this, tr("Error"), tr("Failed to load file: %1").arg(e.what()));
-        return false;
-    }
+    prefetchNeighbours(filePath);
 }
 
-void MainWindow::readMp3Tags(TagLib::FileRef &fileRef)
+// Decoding happens on a worker; the thumbnail arrives in handle_coverCache_thumbnailReady
+void MainWindow::showCoverArt(const CoverArt &cover)
 {
-    TagLib::Tag *tag = fileRef.tag();
-
-    // Store original values
-    originalTitle = QString::fromWCharArray(tag->title().toCWString());
-    originalArtist = QString::fromWCharArray(tag->artist().toCWString());
-    originalAlbum = QString::fromWCharArray(tag->album().toCWString());
-    originalYear = QString::number(tag->year());
-    originalGenre = QString::fromWCharArray(tag->genre().toCWString());
-    originalComment = QString::fromWCharArray(tag->comment().toCWString());
-
-    // Try to get additional tags from ID3v2 if available
-    TagLib::MPEG::File *mpegFile = dynamic_cast<TagLib::MPEG::File*>(fileRef.file());
-    if (mpegFile && mpegFile->ID3v2Tag()) {
-        TagLib::ID3v2::Tag *id3v2Tag = mpegFile->ID3v2Tag();
-
-        // Get track number
-        TagLib::ID3v2::FrameList frameList = id3v2Tag->frameList("TRCK");
-        if (!frameList.isEmpty()) {
-            TagLib::ID3v2::TextIdentificationFrame *frame =
-                static_cast<TagLib::ID3v2::TextIdentificationFrame*>(frameList.front());
-            originalTrack = QString::fromUtf8(frame->toString().to8Bit(true));
-        }
+    if (!cover.isNull()) {
+        coverCache->requestThumbnail(currentFilePath, cover.data, QSize(250, 250));
+    }
+}
 
-        // Get disc number
-        frameList = id3v2Tag->frameList("TPOS");
-        if (!frameList.isEmpty()) {
-            TagLib::ID3v2::TextIdentificationFrame *frame =
-                static_cast<TagLib::ID3v2::TextIdentificationFrame*>(frameList.front());
-            originalDisc = QString::fromUtf8(frame->toString().to8Bit(true));
-        }
+void MainWindow::handle_coverCache_thumbnailReady(const QString &owner, const QImage &image)
+{
+    // Ignore covers of files the user has already moved away from
+    if (owner != currentFilePath || image.isNull()) {
+        return;
+    }
 
-        // Get composer
-        frameList = id3v2Tag->frameList("TCOM");
-        if (!frameList.isEmpty()) {
-            TagLib::ID3v2::TextIdentificationFrame *frame =
-                static_cast<TagLib::ID3v2::TextIdentificationFrame*>(frameList.front());
-            originalComposer = QString::fromUtf8(frame->toString().to8Bit(true));
-        }
+    // Both labels show the same size, so one pixmap serves both
+    QPixmap pixmap = QPixmap::fromImage(image);
+    coverLabel->setPixmap(pixmap);
+    playerCoverLabel->setPixmap(pixmap);
+}
 
-        // Get album artist
-        frameList = id3v2Tag->frameList("TPE2");
-        if (!frameList.isEmpty()) {
-            TagLib::ID3v2::TextIdentificationFrame *frame =
-                static_cast<TagLib::ID3v2::TextIdentificationFrame*>(frameList.front());
-            originalAlbumArtist = QString::fromUtf8(frame->toString().to8Bit(true));
-        }
+// Reads the previous and next audio files in the same folder ahead of time
+void MainWindow::prefetchNeighbours(const QString &filePath)
+{
+    QModelIndex index = fileSystemModel->index(filePath);
+    if (!index.isValid()) {
+        return;
+    }
 
-            // Get cover art
-            frameList = id3v2Tag->frameList("APIC");
-            if (!frameList.isEmpty()) {
-                TagLib::ID3v2::AttachedPictureFrame *pictureFrame =
-                    static_cast<TagLib::ID3v2::AttachedPictureFrame*>(frameList.front());
-
-                QImage image;
-                if (image.loadFromData(reinterpret_cast<const uchar*>(pictureFrame->picture().data()),
-                                     pictureFrame->picture().size())) {
-                    QPixmap pixmap = QPixmap::fromImage(image);
-                    coverLabel->setPixmap(pixmap.scaled(250, 250, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                    playerCoverLabel->setPixmap(pixmap.scaled(250, 250, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                }
+    QStringList neighbours;
+    for (int step : {1, -1}) {
+        for (int row = index.row() + step; row >= 0 && row < fileSystemModel->rowCount(index.parent()); row += step) {
+            QModelIndex sibling = index.sibling(row, 0);
+            QString siblingPath = fileSystemModel->filePath(sibling);
+            if (!fileSystemModel->isDir(sibling) && TagEngine::isSupportedFile(siblingPath)) {
+                neighbours << siblingPath;
+                break;
             }
+        }
     }
+
+    tagLoader->prefetch(neighbours);
 }
 
 bool MainWindow::writeMp3Tags()
@@ -518,162 +627,270 @@ bool MainWindow::writeMp3Tags()
         return false;
     }
 
-    try {
-        TagLib::FileRef fileRef(currentFilePath.toUtf8().constData());
+    QMap<QString, QString> changes;
+    for (const auto &editor : propertyEditors()) {
+        changes.insert(editor.second, editor.first->text());
+    }
 
-        if (fileRef.isNull()) {
-            QMessageBox::warning(this, tr("Error"), tr("Could not open file for writing"));
-            return false;
-        }
+    // Pictures are only rewritten when the cover changed, and then from the
+    // original encoded bytes, never from the scaled-down preview
+    QString errorString;
+    if (!TagEngine::writeProperties(currentFilePath, changes, &errorString,
+                                    coverModified ? &coverArt : nullptr)) {
+        QMessageBox::warning(this, tr("Error"), tr("Failed to save tags: %1").arg(errorString));
+        return false;
+    }
+    tagLoader->invalidate(currentFilePath);
 
-        TagLib::Tag *tag = fileRef.tag();
-
-        // Set standard tags
-        tag->setTitle(titleEdit->text().toStdWString());
-        tag->setArtist(artistEdit->text().toStdWString());
-        tag->setAlbum(albumEdit->text().toStdWString());
-        tag->setYear(yearEdit->text().toInt());
-        tag->setGenre(genreEdit->text().toStdWString());
-        tag->setComment(commentEdit->text().toStdWString());
-
-        // Try to set additional tags in ID3v2 if available
-        TagLib::MPEG::File *mpegFile = dynamic_cast<TagLib::MPEG::File*>(fileRef.file());
-        if (mpegFile && mpegFile->ID3v2Tag()) {
-            TagLib::ID3v2::Tag *id3v2Tag = mpegFile->ID3v2Tag();
-
-            // Set track number
-            if (!trackEdit->text().isEmpty()) {
-                TagLib::ID3v2::TextIdentificationFrame *frame =
-                    new TagLib::ID3v2::TextIdentificationFrame(TagLib::ByteVector("TRCK"), TagLib::String::UTF8);
-                frame->setText(trackEdit->text().toUtf8().constData());
-                id3v2Tag->addFrame(frame);
-            }
+    // Update original values
+    originalTags = tagsFromEditors();
+    coverModified = false;
+    undoPerformed = false;
 
-            // Set disc number
-            if (!discEdit->text().isEmpty()) {
-                TagLib::ID3v2::TextIdentificationFrame *frame =
-                    new TagLib::ID3v2::TextIdentificationFrame(TagLib::ByteVector("TPOS"), TagLib::String::UTF8);
-                frame->setText(discEdit->text().toUtf8().constData());
-                id3v2Tag->addFrame(frame);
-            }
+    return true;
+}
 
-            // Set composer
-            if (!composerEdit->text().isEmpty()) {
-                TagLib::ID3v2::TextIdentificationFrame *frame =
-                    new TagLib::ID3v2::TextIdentificationFrame(TagLib::ByteVector("TCOM"), TagLib::String::UTF8);
-                frame->setText(composerEdit->text().toUtf8().constData());
-                id3v2Tag->addFrame(frame);
-            }
+void MainWindow::updateUIWithTags()
+{
+    setEditorTags(originalTags);
+}
 
-            // Set album artist
-            if (!albumArtistEdit->text().isEmpty()) {
-                TagLib::ID3v2::TextIdentificationFrame *frame =
-                    new TagLib::ID3v2::TextIdentificationFrame(TagLib::ByteVector("TPE2"), TagLib::String::UTF8);
-                frame->setText(albumArtistEdit->text().toUtf8().constData());
-                id3v2Tag->addFrame(frame);
-            }
+TagRecord MainWindow::tagsFromEditors() const
+{
+    TagRecord tags = originalTags;
+    tags.title = titleEdit->text();
+    tags.artist = artistEdit->text();
+    tags.album = albumEdit->text();
+    tags.year = yearEdit->text();
+    tags.genre = genreEdit->text();
+    tags.comment = commentEdit->text();
+    tags.track = trackEdit->text();
+    tags.disc = discEdit->text();
+    tags.composer = composerEdit->text();
+    tags.albumArtist = albumArtistEdit->text();
+    return tags;
+}
 
-        // Save cover image if available
-        QPixmap currentPixmap = coverLabel->pixmap();
-        if (currentPixmap.isNull()) {
-            // Remove existing cover art if any
-            TagLib::ID3v2::FrameList frameList = id3v2Tag->frameList("APIC");
-            if (!frameList.isEmpty()) {
-                id3v2Tag->removeFrame(frameList.front());
-            }
-        } else {
-            // Save the current cover image
-            QImage image = currentPixmap.toImage();
-
-            if (!image.isNull()) {
-                // Convert QImage to byte array
-                QByteArray byteArray;
-                QBuffer buffer(&byteArray);
-                buffer.open(QIODevice::WriteOnly);
-                image.save(&buffer, "JPEG"); // Save as JPEG
-
-                // Create and add the picture frame
-                TagLib::ID3v2::AttachedPictureFrame *pictureFrame =
-                    new TagLib::ID3v2::AttachedPictureFrame();
-                pictureFrame->setPicture(TagLib::ByteVector(byteArray.constData(), byteArray.size()));
-                pictureFrame->setType(TagLib::ID3v2::AttachedPictureFrame::FrontCover);
-                pictureFrame->setMimeType("image/jpeg");
-
-                // Remove existing cover art first
-                TagLib::ID3v2::FrameList frameList = id3v2Tag->frameList("APIC");
-                if (!frameList.isEmpty()) {
-                    id3v2Tag->removeFrame(frameList.front());
-                }
-
-                id3v2Tag->addFrame(pictureFrame);
-            }
+void MainWindow::setEditorTags(const TagRecord &tags)
+{
+    titleEdit->setText(tags.title);
+    artistEdit->setText(tags.artist);
+    albumEdit->setText(tags.album);
+    yearEdit->setText(tags.year);
+    genreEdit->setText(tags.genre);
+    commentEdit->setText(tags.comment);
+    trackEdit->setText(tags.track);
+    discEdit->setText(tags.disc);
+    composerEdit->setText(tags.composer);
+    albumArtistEdit->setText(tags.albumArtist);
+}
+
+// Tag editors and the TagLib property each of them maps to
+QVector<QPair<QLineEdit *, QString>> MainWindow::propertyEditors() const
+{
+    return {
+        {titleEdit, "TITLE"},
+        {artistEdit, "ARTIST"},
+        {albumEdit, "ALBUM"},
+        {yearEdit, "DATE"},
+        {genreEdit, "GENRE"},
+        {commentEdit, "COMMENT"},
+        {trackEdit, "TRACKNUMBER"},
+        {discEdit, "DISCNUMBER"},
+        {composerEdit, "COMPOSER"},
+        {albumArtistEdit, "ALBUMARTIST"}
+    };
+}
+
+void MainWindow::updateModifiedState(bool changed)
+{
+    // In batch mode only fields the user touched are written, so any edited
+    // field counts as a change even if it was cleared
+    if (!batchFilePaths.isEmpty()) {
+        changed = false;
+        for (const auto &editor : propertyEditors()) {
+            changed = changed || editor.first->isModified();
         }
+    }
+
+    enableSaveActions(changed);
+}
 
+void MainWindow::enterBatchMode(const QStringList &filePaths)
+{
+    clearTags();
+    currentFilePath.clear();
+    batchFilePaths = filePaths;
+
+    for (const auto &editor : propertyEditors()) {
+        editor.first->setPlaceholderText(tr("<keep>"));
+    }
+
+    fileNameValue->setText(tr("%1 files selected").arg(filePaths.size()));
+    filePathValue->setText("-");
+    fileSizeValue->setText("-");
+    fileTypeValue->setText("-");
+    fileDurationValue->setText("-");
+    fileBitrateValue->setText("-");
+    fileSampleRateValue->setText("-");
+    fileChannelsValue->setText("-");
+
+    updatePlayerUI();
+    enableSaveActions(false);
+    updateStatusBar(tr("Editing %1 files").arg(filePaths.size()));
+}
+
+void MainWindow::leaveBatchMode()
+{
+    batchFilePaths.clear();
+
+    for (const auto &editor : propertyEditors()) {
+        editor.first->setPlaceholderText(QString());
     }
 
-    // Save changes
-    if (!fileRef.save()) {
-        QMessageBox::warning(this, tr("Error"), tr("Failed to save tags"));
+    clearTags();
+    fileNameValue->setText("-");
+    enableSaveActions(false);
+}
+
+bool MainWindow::commitBatch()
+{
+    if (commitPipeline->isRunning() || audioVerifier->isRunning()) {
+        updateStatusBar(tr("A save is already in progress"));
         return false;
     }
 
-    // Update original values
-    originalTitle = titleEdit->text();
-    originalArtist = artistEdit->text();
-    originalAlbum = albumEdit->text();
-    originalYear = yearEdit->text();
-    originalGenre = genreEdit->text();
-    originalComment = commentEdit->text();
-    originalTrack = trackEdit->text();
-    originalDisc = discEdit->text();
-    originalComposer = composerEdit->text();
-    originalAlbumArtist = albumArtistEdit->text();
-    undoPerformed = false;
+    QMap<QString, QString> changes;
+    for (const auto &editor : propertyEditors()) {
+        if (editor.first->isModified()) {
+            changes.insert(editor.second, editor.first->text());
+        }
+    }
 
-    return true;
-    } catch (const std::exception &e) {
-        QMessageBox::warning(this, tr("Error"), tr("Failed to save tags: %1").arg(e.what()));
+    if (changes.isEmpty()) {
         return false;
     }
+
+    QVector<CommitJob> jobs;
+    jobs.reserve(batchFilePaths.size());
+    for (const QString &filePath : batchFilePaths) {
+        jobs.append({filePath, changes});
+    }
+    committedFilePaths = batchFilePaths;
+    committedChanges = changes;
+
+    commitErrors.clear();
+    commitProgressBar->setRange(0, jobs.size());
+    commitProgressBar->setValue(0);
+    commitProgressBar->setVisible(true);
+    enableSaveActions(false);
+
+    commitPipeline->setCheckAudioPayload(settings->value("checkAudioPayload", true).toBool());
+    commitPipeline->start(jobs);
+    return true;
 }
 
-void MainWindow::updateUIWithTags()
+void MainWindow::handle_commitPipeline_fileCommitted(const QString &filePath, bool ok, const QString &errorString)
 {
-    titleEdit->setText(originalTitle);
-    artistEdit->setText(originalArtist);
-    albumEdit->setText(originalAlbum);
-    yearEdit->setText(originalYear);
-    genreEdit->setText(originalGenre);
-    commentEdit->setText(originalComment);
-    trackEdit->setText(originalTrack);
-    discEdit->setText(originalDisc);
-    composerEdit->setText(originalComposer);
-    albumArtistEdit->setText(originalAlbumArtist);
+    tagLoader->invalidate(filePath);
+
+    QString fileName = QFileInfo(filePath).fileName();
+    if (ok) {
+        statusBar()->showMessage(tr("Saved %1").arg(fileName));
+    } else {
+        commitErrors << QString("%1: %2").arg(fileName, errorString);
+    }
+}
+
+void MainWindow::handle_commitPipeline_progress(int done, int total)
+{
+    commitProgressBar->setMaximum(total);
+    commitProgressBar->setValue(done);
+}
+
+void MainWindow::handle_commitPipeline_finished(int succeeded, int failed, qint64 elapsedMs)
+{
+    commitProgressBar->setVisible(false);
+
+    // The editors stay editable during the commit. Fields edited since then,
+    // or an editor that moved on to other files, keep their pending changes.
+    if (batchFilePaths == committedFilePaths) {
+        for (const auto &editor : propertyEditors()) {
+            const auto committed = committedChanges.constFind(editor.second);
+            if (committed != committedChanges.constEnd() && committed.value() == editor.first->text()) {
+                editor.first->setModified(false);
+            }
+        }
+        updateModifiedState(false);
+    }
+    committedFilePaths.clear();
+    committedChanges.clear();
+
+    updateStatusBar(tr("Saved %1 files in %2 s, %3 failed")
+                        .arg(succeeded)
+                        .arg(elapsedMs / 1000.0, 0, 'f', 1)
+                        .arg(failed));
+
+    if (!commitErrors.isEmpty()) {
+        const int maxShown = 20;
+        QStringList shown = commitErrors.mid(0, maxShown);
+        if (commitErrors.size() > maxShown) {
+            shown << tr("... and %1 more").arg(commitErrors.size() - maxShown);
+        }
+        QMessageBox::warning(this, tr("Error"), tr("Failed to save tags:\n%1").arg(shown.join("\n")));
+    }
+}
+
+void MainWindow::handle_audioVerifier_fileVerified(const QString &filePath, AudioVerifier::Status status, const QString &errorString)
+{
+    if (status == AudioVerifier::Mismatch || status == AudioVerifier::Failed) {
+        QString message = QString("%1: %2").arg(QFileInfo(filePath).fileName(), AudioVerifier::statusText(status));
+        if (!errorString.isEmpty()) {
+            message += QString(" (%1)").arg(errorString);
+        }
+        verifyErrors << message;
+    }
+}
+
+void MainWindow::handle_audioVerifier_progress(int done, int total)
+{
+    commitProgressBar->setMaximum(total);
+    commitProgressBar->setValue(done);
+}
+
+void MainWindow::handle_audioVerifier_finished(int passed, int failed, int skipped, qint64 bytes, qint64 elapsedMs)
+{
+    commitProgressBar->setVisible(false);
+    actionVerify->setEnabled(true);
+
+    const double megabytes = bytes / 1000000.0;
+    const double megabytesPerSecond = elapsedMs > 0 ? bytes / 1000.0 / elapsedMs : 0.0;
+
+    // Shown until the next message, the summary is the point of the check
+    statusBar()->showMessage(tr("Verified %1 files (%2 MB, %3 MB/s): %4 intact, %5 failed, %6 without checksum")
+                                 .arg(passed + failed)
+                                 .arg(megabytes, 0, 'f', 1)
+                                 .arg(megabytesPerSecond, 0, 'f', 1)
+                                 .arg(passed)
+                                 .arg(failed)
+                                 .arg(skipped));
+
+    if (!verifyErrors.isEmpty()) {
+        const int maxShown = 20;
+        QStringList shown = verifyErrors.mid(0, maxShown);
+        if (verifyErrors.size() > maxShown) {
+            shown << tr("... and %1 more").arg(verifyErrors.size() - maxShown);
+        }
+        QMessageBox::warning(this, tr("Error"), tr("Audio verification failed:\n%1").arg(shown.join("\n")));
+    }
 }
 
 void MainWindow::clearTags()
 {
-    originalTitle.clear();
-    originalArtist.clear();
-    originalAlbum.clear();
-    originalYear.clear();
-    originalGenre.clear();
-    originalComment.clear();
-    originalTrack.clear();
-    originalDisc.clear();
-    originalComposer.clear();
-    originalAlbumArtist.clear();
-
-    titleEdit->clear();
-    artistEdit->clear();
-    albumEdit->clear();
-    yearEdit->clear();
-    genreEdit->clear();
-    commentEdit->clear();
-    trackEdit->clear();
-    discEdit->clear();
-    composerEdit->clear();
-    albumArtistEdit->clear();
+    originalTags = TagRecord();
+    setEditorTags(originalTags);
+    coverArt = CoverArt();
+    coverModified = false;
 
     coverLabel->setText("No Cover");
     coverLabel->setPixmap(QPixmap());
@@ -693,35 +910,25 @@ void MainWindow::updateFileInfo(const QString &filePath)
     filePathValue->setText(fileInfo.absolutePath());
     fileSizeValue->setText(QString::number(fileInfo.size() / 1024) + " KB");
 
-    // Get file type
+    // Get file type (by extension, so slow storage isn't read again here)
     QMimeDatabase mimeDatabase;
-    QMimeType mimeType = mimeDatabase.mimeTypeForFile(filePath);
+    QMimeType mimeType = mimeDatabase.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension);
     fileTypeValue->setText(mimeType.name());
 
-    try {
-        TagLib::FileRef fileRef(filePath.toUtf8().constData());
-        if (!fileRef.isNull()) {
-            TagLib::AudioProperties *properties = fileRef.audioProperties();
-            if (properties) {
-                // Duration
-                int duration = properties->lengthInSeconds();
-                int minutes = duration / 60;
-                int seconds = duration % 60;
-                fileDurationValue->setText(QString("%1:%2").arg(minutes, 2, 10, QLatin1Char('0')).arg(seconds, 2, 10, QLatin1Char('0')));
-
-                // Bitrate
-                fileBitrateValue->setText(QString::number(properties->bitrate()) + " kbps");
-
-                // Sample rate
-                fileSampleRateValue->setText(QString::number(properties->sampleRate()) + " Hz");
-
-                // Channels
-                fileChannelsValue->setText(QString::number(properties->channels()));
-            }
-        }
-    } catch (const std::exception &e) {
-        qWarning() << "Failed to get audio properties:" << e.what();
-    }
+    // Duration
+    int duration = originalTags.lengthInSeconds;
+    int minutes = duration / 60;
+    int seconds = duration % 60;
+    fileDurationValue->setText(QString("%1:%2").arg(minutes, 2, 10, QLatin1Char('0')).arg(seconds, 2, 10, QLatin1Char('0')));
+
+    // Bitrate
+    fileBitrateValue->setText(QString::number(originalTags.bitrate) + " kbps");
+
+    // Sample rate
+    fileSampleRateValue->setText(QString::number(originalTags.sampleRate) + " Hz");
+
+    // Channels
+    fileChannelsValue->setText(QString::number(originalTags.channels));
 }
 
 void MainWindow::updateStatusBar(const QString &message)
@@ -755,9 +962,7 @@ void MainWindow::on_playButton_clicked()
     }
 
     // Check if file is an audio file
-    QStringList audioExtensions = {"mp3", "flac", "ogg", "wma", "m4a"};
-    QFileInfo fileInfo(currentFilePath);
-    if (!audioExtensions.contains(fileInfo.suffix().toLower())) {
+    if (!TagEngine::isSupportedFile(currentFilePath)) {
         QMessageBox::warning(this, tr("Error"), tr("Selected file is not a supported audio format"));
         return;
     }
@@ -899,19 +1104,29 @@ void MainWindow::on_changeCoverButton_clicked()
         return; // User cancelled
     }
 
-    // Load the selected image
-    QImage image(imagePath);
-    if (image.isNull()) {
+    // Keep the file's bytes as they are; they are embedded unchanged on save
+    QFile imageFile(imagePath);
+    if (!imageFile.open(QIODevice::ReadOnly)) {
         QMessageBox::warning(this, tr("Error"), tr("Failed to load image file"));
         return;
     }
+    QByteArray imageData = imageFile.readAll();
 
-    // Scale and display the image
-    QPixmap pixmap = QPixmap::fromImage(image);
-    pixmap = pixmap.scaled(200, 200, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QBuffer buffer(&imageData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    if (!reader.canRead()) {
+        QMessageBox::warning(this, tr("Error"), tr("Failed to load image file"));
+        return;
+    }
 
-    coverLabel->setPixmap(pixmap);
-    playerCoverLabel->setPixmap(pixmap);
+    QMimeDatabase mimeDatabase;
+    coverArt.data = imageData;
+    coverArt.mimeType = mimeDatabase.mimeTypeForData(imageData).name();
+    coverModified = true;
+
+    // Display a thumbnail decoded in the background
+    showCoverArt(coverArt);
 
     // Mark as modified
     enableSaveActions(true);
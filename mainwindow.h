@@ -22,13 +22,18 @@
 #include <QStandardPaths>
 #include <QMediaPlayer>
 #include <QSettings>
+#include <QProgressBar>
+#include <QVector>
+#include <QPair>
 
-// Forward declaration for TagLib
-namespace TagLib {
-    class FileRef;
-}
+#include "tagengine.h"
+#include "audioverifier.h"
 
 class MediaPlayer;
+class CommitPipeline;
+class TagLoader;
+class CoverCache;
+struct LoadedFile;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -51,10 +56,13 @@ private slots:
     void on_actionExit_triggered();
     void on_actionAbout_triggered();
     void on_actionSettings_triggered();
+    void on_actionVerify_triggered();
     void on_actionUndo_triggered();
     void on_actionRedo_triggered();
 
-    void on_fileTreeView_doubleClicked(const QModelIndex &index);
+    void handle_fileSelection_changed();
+    void handle_tagLoader_loaded(const QString &filePath, const LoadedFile &file);
+    void handle_coverCache_thumbnailReady(const QString &owner, const QImage &image);
     void on_titleEdit_textChanged(const QString &text);
     void on_artistEdit_textChanged(const QString &text);
     void on_albumEdit_textChanged(const QString &text);
@@ -81,6 +89,16 @@ private slots:
     void handle_mediaPlayer_volumeChanged(int volume);
     void handle_mediaPlayer_errorOccurred(const QString &errorString);
 
+    // Batch commit signal handlers
+    void handle_commitPipeline_fileCommitted(const QString &filePath, bool ok, const QString &errorString);
+    void handle_commitPipeline_progress(int done, int total);
+    void handle_commitPipeline_finished(int succeeded, int failed, qint64 elapsedMs);
+
+    // Audio verification signal handlers
+    void handle_audioVerifier_fileVerified(const QString &filePath, AudioVerifier::Status status, const QString &errorString);
+    void handle_audioVerifier_progress(int done, int total);
+    void handle_audioVerifier_finished(int passed, int failed, int skipped, qint64 bytes, qint64 elapsedMs);
+
     // Helper methods
     void updatePlayerUI();
 
@@ -89,30 +107,20 @@ private:
 
     // Current file and tags
     QString currentFilePath;
-    QString originalTitle;
-    QString originalArtist;
-    QString originalAlbum;
-    QString originalYear;
-    QString originalGenre;
-    QString originalComment;
-    QString originalTrack;
-    QString originalDisc;
-    QString originalComposer;
-    QString originalAlbumArtist;
+    TagRecord originalTags;
+
+    // Encoded cover as read from the file or picked by the user; only
+    // written back when coverModified is set
+    CoverArt coverArt;
+    bool coverModified;
 
     // Undone state for undo/redo
-    QString undoneTitle;
-    QString undoneArtist;
-    QString undoneAlbum;
-    QString undoneYear;
-    QString undoneGenre;
-    QString undoneComment;
-    QString undoneTrack;
-    QString undoneDisc;
-    QString undoneComposer;
-    QString undoneAlbumArtist;
+    TagRecord undoneTags;
     bool undoPerformed;
 
+    // Set while the file tree selection is put back after a cancelled switch
+    bool restoringSelection;
+
     QSettings *settings;
 
     // File system model
@@ -158,6 +166,23 @@ private:
     // Media player
     MediaPlayer *mediaPlayer;
 
+    // Multi-selection editing; empty when a single file is loaded
+    QStringList batchFilePaths;
+    QStringList commitErrors;
+    // Files and field values of the commit in progress
+    QStringList committedFilePaths;
+    QMap<QString, QString> committedChanges;
+    CommitPipeline *commitPipeline;
+    QProgressBar *commitProgressBar;
+
+    // Audio MD5 checks of the selected files; shares commitProgressBar
+    AudioVerifier *audioVerifier;
+    QStringList verifyErrors;
+
+    // Background tag reading with prefetch
+    TagLoader *tagLoader;
+    CoverCache *coverCache;
+
     // Actions
     QAction *actionOpen;
     QAction *actionSave;
@@ -165,14 +190,25 @@ private:
     QAction *actionExit;
     QAction *actionAbout;
     QAction *actionSettings;
+    QAction *actionVerify;
     QAction *actionUndo;
     QAction *actionRedo;
 
     // MP3 tag functions
     bool loadMp3File(const QString &filePath);
-    void readMp3Tags(TagLib::FileRef &fileRef);
+    bool maybeSaveChanges();
+    void restoreFileSelection();
+    void showCoverArt(const CoverArt &cover);
+    void prefetchNeighbours(const QString &filePath);
     bool writeMp3Tags();
     void updateUIWithTags();
+    TagRecord tagsFromEditors() const;
+    void setEditorTags(const TagRecord &tags);
+    QVector<QPair<QLineEdit *, QString>> propertyEditors() const;
+    void updateModifiedState(bool changed);
+    void enterBatchMode(const QStringList &filePaths);
+    void leaveBatchMode();
+    bool commitBatch();
     void clearTags();
     void setupUI();
     void setupFileSystemModel();
@@ -0,0 +1,406 @@
+#include "payloadhasher.h"
+
+#include <QFile>
+#include <QPair>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Byte ranges of a file, as (offset, length)
+using Ranges = QVector<QPair<qint64, qint64>>;
+
+// Streaming XXH64 with seed 0
+class Xxh64
+{
+public:
+    Xxh64()
+        : m_total(0)
+        , m_buffered(0)
+    {
+        m_accumulators[0] = Prime1 + Prime2;
+        m_accumulators[1] = Prime2;
+        m_accumulators[2] = 0;
+        m_accumulators[3] = 0 - Prime1;
+    }
+
+    void update(const uchar *data, qint64 length)
+    {
+        m_total += static_cast<quint64>(length);
+
+        if (m_buffered > 0) {
+            const qint64 fill = std::min<qint64>(length, 32 - m_buffered);
+            std::memcpy(m_buffer + m_buffered, data, static_cast<size_t>(fill));
+            m_buffered += static_cast<int>(fill);
+            data += fill;
+            length -= fill;
+            if (m_buffered < 32) {
+                return;
+            }
+            consume(m_buffer);
+            m_buffered = 0;
+        }
+
+        for (; length >= 32; data += 32, length -= 32) {
+            consume(data);
+        }
+
+        if (length > 0) {
+            std::memcpy(m_buffer, data, static_cast<size_t>(length));
+            m_buffered = static_cast<int>(length);
+        }
+    }
+
+    quint64 digest() const
+    {
+        quint64 hash;
+        if (m_total >= 32) {
+            hash = rotate(m_accumulators[0], 1) + rotate(m_accumulators[1], 7)
+                   + rotate(m_accumulators[2], 12) + rotate(m_accumulators[3], 18);
+            for (quint64 accumulator : m_accumulators) {
+                hash = (hash ^ round(0, accumulator)) * Prime1 + Prime4;
+            }
+        } else {
+            hash = Prime5;
+        }
+        hash += m_total;
+
+        const uchar *data = m_buffer;
+        int length = m_buffered;
+        for (; length >= 8; data += 8, length -= 8) {
+            hash ^= round(0, qFromLittleEndian<quint64>(data));
+            hash = rotate(hash, 27) * Prime1 + Prime4;
+        }
+        if (length >= 4) {
+            hash ^= static_cast<quint64>(qFromLittleEndian<quint32>(data)) * Prime1;
+            hash = rotate(hash, 23) * Prime2 + Prime3;
+            data += 4;
+            length -= 4;
+        }
+        for (; length > 0; ++data, --length) {
+            hash ^= *data * Prime5;
+            hash = rotate(hash, 11) * Prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    static constexpr quint64 Prime1 = 11400714785092373911ULL;
+    static constexpr quint64 Prime2 = 14029467366897019727ULL;
+    static constexpr quint64 Prime3 = 1609587929392839161ULL;
+    static constexpr quint64 Prime4 = 9650029242287828579ULL;
+    static constexpr quint64 Prime5 = 2870177450012600261ULL;
+
+    static quint64 rotate(quint64 value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static quint64 round(quint64 accumulator, quint64 input)
+    {
+        return rotate(accumulator + input * Prime2, 31) * Prime1;
+    }
+
+    void consume(const uchar *stripe)
+    {
+        for (int i = 0; i < 4; ++i) {
+            m_accumulators[i] = round(m_accumulators[i], qFromLittleEndian<quint64>(stripe + 8 * i));
+        }
+    }
+
+    quint64 m_accumulators[4];
+    quint64 m_total;
+    uchar m_buffer[32];
+    int m_buffered;
+};
+
+bool startsWith(const uchar *data, qint64 size, qint64 offset, const char *magic, qint64 length)
+{
+    return offset >= 0 && size - offset >= length && std::memcmp(data + offset, magic, static_cast<size_t>(length)) == 0;
+}
+
+// Offset behind any ID3v2 tags at the start of the file
+qint64 skipId3v2(const uchar *data, qint64 size)
+{
+    qint64 offset = 0;
+    while (startsWith(data, size, offset, "ID3", 3) && size - offset >= 10) {
+        const uchar *header = data + offset;
+        const qint64 tagSize = (static_cast<qint64>(header[6] & 0x7f) << 21) | ((header[7] & 0x7f) << 14)
+                               | ((header[8] & 0x7f) << 7) | (header[9] & 0x7f);
+        offset += tagSize + ((header[5] & 0x10) ? 20 : 10);
+    }
+    return std::min(offset, size);
+}
+
+// End of the data before any ID3v1, APE or appended ID3v2 tags
+qint64 stripTrailingTags(const uchar *data, qint64 begin, qint64 end)
+{
+    for (;;) {
+        if (end - begin >= 128 && startsWith(data, end, end - 128, "TAG", 3)) {
+            end -= 128;
+        } else if (end - begin >= 32 && startsWith(data, end, end - 32, "APETAGEX", 8)) {
+            // The size in the footer covers the items and the footer, but not
+            // the optional header
+            const uchar *footer = data + end - 32;
+            qint64 tagSize = qFromLittleEndian<quint32>(footer + 12);
+            if (qFromLittleEndian<quint32>(footer + 20) & 0x80000000u) {
+                tagSize += 32;
+            }
+            if (tagSize < 32 || tagSize > end - begin) {
+                return end;
+            }
+            end -= tagSize;
+        } else if (end - begin >= 10 && startsWith(data, end, end - 10, "3DI", 3)) {
+            const uchar *footer = data + end - 10;
+            const qint64 tagSize = ((static_cast<qint64>(footer[6] & 0x7f) << 21) | ((footer[7] & 0x7f) << 14)
+                                    | ((footer[8] & 0x7f) << 7) | (footer[9] & 0x7f)) + 20;
+            if (tagSize > end - begin) {
+                return end;
+            }
+            end -= tagSize;
+        } else {
+            return end;
+        }
+    }
+}
+
+bool mpegRanges(const uchar *data, qint64 size, Ranges &ranges, QString &)
+{
+    const qint64 begin = skipId3v2(data, size);
+    ranges.append(qMakePair(begin, stripTrailingTags(data, begin, size) - begin));
+    return true;
+}
+
+bool flacRanges(const uchar *data, qint64 size, Ranges &ranges, QString &errorString)
+{
+    qint64 offset = skipId3v2(data, size);
+    if (!startsWith(data, size, offset, "fLaC", 4)) {
+        errorString = QStringLiteral("Not a FLAC stream");
+        return false;
+    }
+    offset += 4;
+
+    bool last = false;
+    while (!last) {
+        if (size - offset < 4) {
+            errorString = QStringLiteral("Truncated FLAC metadata");
+            return false;
+        }
+        last = (data[offset] & 0x80) != 0;
+        offset += 4 + ((static_cast<qint64>(data[offset + 1]) << 16) | (data[offset + 2] << 8) | data[offset + 3]);
+    }
+
+    if (offset > size) {
+        errorString = QStringLiteral("Truncated FLAC metadata");
+        return false;
+    }
+
+    ranges.append(qMakePair(offset, stripTrailingTags(data, offset, size) - offset));
+    return true;
+}
+
+// Number of header packets before the audio of an Ogg stream, from its
+// first packet; 0 for unknown codecs
+int oggHeaderPackets(const uchar *packet, qint64 length)
+{
+    if (startsWith(packet, length, 0, "\x01vorbis", 7) || startsWith(packet, length, 0, "\x80theora", 7)) {
+        return 3;
+    }
+    if (startsWith(packet, length, 0, "OpusHead", 8)) {
+        return 2;
+    }
+    if (startsWith(packet, length, 0, "Speex   ", 8) && length >= 80) {
+        return 2 + static_cast<int>(qFromLittleEndian<quint32>(packet + 76));
+    }
+    if (startsWith(packet, length, 0, "\x7f" "FLAC", 5) && length >= 9) {
+        const int count = qFromBigEndian<quint16>(packet + 7);
+        return count > 0 ? 1 + count : 0;
+    }
+    return 0;
+}
+
+// Page headers carry sequence numbers and checksums that change whenever the
+// header packets are resized, so only page bodies are hashed, and of the
+// first stream only what follows its header packets
+bool oggRanges(const uchar *data, qint64 size, Ranges &ranges, QString &errorString)
+{
+    qint64 offset = 0;
+    quint32 firstSerial = 0;
+    int headerPackets = -1;
+    int completedPackets = 0;
+
+    while (offset < size) {
+        if (!startsWith(data, size, offset, "OggS", 4) || size - offset < 27) {
+            errorString = QStringLiteral("Invalid Ogg page at offset %1").arg(offset);
+            return false;
+        }
+
+        const uchar *header = data + offset;
+        const int segments = header[26];
+        if (size - offset < 27 + segments) {
+            errorString = QStringLiteral("Truncated Ogg page");
+            return false;
+        }
+
+        const qint64 bodyOffset = offset + 27 + segments;
+        qint64 bodyLength = 0;
+        for (int i = 0; i < segments; ++i) {
+            bodyLength += header[27 + i];
+        }
+        if (size - bodyOffset < bodyLength) {
+            errorString = QStringLiteral("Truncated Ogg page");
+            return false;
+        }
+
+        const quint32 serial = qFromLittleEndian<quint32>(header + 14);
+        if (headerPackets < 0) {
+            firstSerial = serial;
+            headerPackets = oggHeaderPackets(data + bodyOffset, bodyLength);
+            if (headerPackets == 0) {
+                errorString = QStringLiteral("Unknown Ogg codec");
+                return false;
+            }
+        }
+
+        qint64 skip = 0;
+        if (serial == firstSerial && completedPackets < headerPackets) {
+            // Skip the segments up to the end of the last header packet
+            int segment = 0;
+            for (; segment < segments && completedPackets < headerPackets; ++segment) {
+                skip += header[27 + segment];
+                if (header[27 + segment] < 255) {
+                    ++completedPackets;
+                }
+            }
+            if (completedPackets < headerPackets) {
+                skip = bodyLength;
+            }
+        }
+
+        if (bodyLength > skip) {
+            ranges.append(qMakePair(bodyOffset + skip, bodyLength - skip));
+        }
+        offset = bodyOffset + bodyLength;
+    }
+
+    if (headerPackets < 0 || completedPackets < headerPackets) {
+        errorString = QStringLiteral("Truncated Ogg headers");
+        return false;
+    }
+    return true;
+}
+
+// The media data lives in mdat boxes; moov, udta, free and so on are fair
+// game for a tag editor, and moov may also move around mdat
+bool mp4Ranges(const uchar *data, qint64 size, Ranges &ranges, QString &errorString)
+{
+    qint64 offset = 0;
+    while (size - offset >= 8) {
+        qint64 atomSize = qFromBigEndian<quint32>(data + offset);
+        qint64 headerSize = 8;
+        if (atomSize == 1) {
+            if (size - offset < 16) {
+                break;
+            }
+            atomSize = static_cast<qint64>(qFromBigEndian<quint64>(data + offset + 8));
+            headerSize = 16;
+        } else if (atomSize == 0) {
+            atomSize = size - offset;
+        }
+
+        if (atomSize < headerSize || atomSize > size - offset) {
+            errorString = QStringLiteral("Invalid MP4 atom at offset %1").arg(offset);
+            return false;
+        }
+
+        if (std::memcmp(data + offset + 4, "mdat", 4) == 0) {
+            ranges.append(qMakePair(offset + headerSize, atomSize - headerSize));
+        }
+        offset += atomSize;
+    }
+
+    if (ranges.isEmpty()) {
+        errorString = QStringLiteral("No mdat atom");
+        return false;
+    }
+    return true;
+}
+
+// Everything after the header object: the data object and the indexes
+bool asfRanges(const uchar *data, qint64 size, Ranges &ranges, QString &errorString)
+{
+    if (size < 24) {
+        errorString = QStringLiteral("Truncated ASF header");
+        return false;
+    }
+
+    const qint64 headerSize = static_cast<qint64>(qFromLittleEndian<quint64>(data + 16));
+    if (headerSize < 24 || headerSize > size) {
+        errorString = QStringLiteral("Invalid ASF header size");
+        return false;
+    }
+
+    ranges.append(qMakePair(headerSize, size - headerSize));
+    return true;
+}
+
+const char asfHeaderGuid[] = "\x30\x26\xb2\x75\x8e\x66\xcf\x11\xa6\xd9\x00\xaa\x00\x62\xce\x6c";
+
+} // namespace
+
+PayloadHasher::Result PayloadHasher::hashFile(const QString &filePath)
+{
+    Result result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.errorString = file.errorString();
+        return result;
+    }
+
+    const qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        result.errorString = size > 0 ? file.errorString() : QStringLiteral("File is empty");
+        return result;
+    }
+
+    // Picked by content rather than extension, so misnamed files still work
+    Ranges ranges;
+    bool ok;
+    const qint64 id3v2End = skipId3v2(data, size);
+    if (startsWith(data, size, id3v2End, "fLaC", 4)) {
+        ok = flacRanges(data, size, ranges, result.errorString);
+    } else if (startsWith(data, size, 0, "OggS", 4)) {
+        ok = oggRanges(data, size, ranges, result.errorString);
+    } else if (startsWith(data, size, 4, "ftyp", 4)) {
+        ok = mp4Ranges(data, size, ranges, result.errorString);
+    } else if (startsWith(data, size, 0, asfHeaderGuid, 16)) {
+        ok = asfRanges(data, size, ranges, result.errorString);
+    } else {
+        ok = mpegRanges(data, size, ranges, result.errorString);
+    }
+
+    if (!ok) {
+        return result;
+    }
+
+    Xxh64 hash;
+    for (const auto &range : ranges) {
+        hash.update(data + range.first, range.second);
+        result.bytes += range.second;
+    }
+
+    result.hash = hash.digest();
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef PAYLOADHASHER_H
+#define PAYLOADHASHER_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Hashes the audio payload of a file, i.e. everything a tag editor must
+// never change.
+//
+// Tags and container metadata are left out: ID3v2/ID3v1/APE tags, FLAC
+// metadata blocks, Ogg header packets and page headers, MP4 boxes other than
+// mdat and the ASF header object. Two hashes of the same file taken before
+// and after a save are therefore equal unless the save touched the audio.
+// The file is mapped and hashed with XXH64, so the cost is close to reading
+// the file once.
+class PayloadHasher
+{
+public:
+    struct Result
+    {
+        bool ok = false;
+        quint64 hash = 0;
+        // Size of the audio payload that went into the hash
+        qint64 bytes = 0;
+        QString errorString;
+    };
+
+    static Result hashFile(const QString &filePath);
+};
+
+#endif // PAYLOADHASHER_H
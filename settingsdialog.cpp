@@ -34,6 +34,17 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     themeLayout->addLayout(themeRow);
     mainLayout->addWidget(themeGroup);
 
+    // Saving group
+    QGroupBox *savingGroup = new QGroupBox(tr("Saving"), this);
+    QVBoxLayout *savingLayout = new QVBoxLayout(savingGroup);
+
+    checkAudioCheckBox = new QCheckBox(tr("Check that batch saves leave the audio untouched"), this);
+    checkAudioCheckBox->setToolTip(tr("Hashes the audio data of every file before and after saving it"));
+    checkAudioCheckBox->setChecked(settings->value("checkAudioPayload", true).toBool());
+
+    savingLayout->addWidget(checkAudioCheckBox);
+    mainLayout->addWidget(savingGroup);
+
     // Buttons
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     okButton = new QPushButton(tr("OK"), this);
@@ -62,6 +73,7 @@ QString SettingsDialog::getSelectedTheme() const
 void SettingsDialog::onAccept()
 {
     settings->setValue("theme", getSelectedTheme());
+    settings->setValue("checkAudioPayload", checkAudioCheckBox->isChecked());
     accept();
 }
 
@@ -6,6 +6,7 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QPushButton>
 #include <QGroupBox>
 #include <QSettings>
@@ -26,6 +27,7 @@ private slots:
 
 private:
     QComboBox *themeComboBox;
+    QCheckBox *checkAudioCheckBox;
     QPushButton *okButton;
     QPushButton *cancelButton;
 
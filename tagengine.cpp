@@ -0,0 +1,237 @@
+#include "tagengine.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+#include "taglib/fileref.h"
+#include "taglib/tag.h"
+#include "taglib/audioproperties.h"
+#include "taglib/toolkit/tpropertymap.h"
+#include "taglib/toolkit/tvariant.h"
+#include "taglib/flac/flacfile.h"
+#include "taglib/flac/flacpicture.h"
+
+#include <exception>
+#include <iterator>
+
+namespace {
+
+#ifdef Q_OS_WIN
+#define TAGENGINE_FILENAME(path) reinterpret_cast<const wchar_t *>((path).utf16())
+#else
+#define TAGENGINE_FILENAME(path) QFile::encodeName(path).constData()
+#endif
+
+QString toQString(const TagLib::String &string)
+{
+    return QString::fromUtf8(string.toCString(true));
+}
+
+TagLib::String toTagLibString(const QString &string)
+{
+    return TagLib::String(string.toUtf8().constData(), TagLib::String::UTF8);
+}
+
+QString firstProperty(const TagLib::PropertyMap &properties, const char *key)
+{
+    const TagLib::StringList values = properties.value(key);
+    return values.isEmpty() ? QString() : toQString(values.front());
+}
+
+bool isFrontCover(const TagLib::VariantMap &picture)
+{
+    return picture.value("pictureType").toString() == "Front Cover";
+}
+
+// Index of the picture shown as cover: the front cover, else the first one
+int coverIndex(const TagLib::List<TagLib::VariantMap> &pictures)
+{
+    int first = -1;
+    int index = 0;
+    for (const TagLib::VariantMap &picture : pictures) {
+        if (!picture.value("data").toByteVector().isEmpty()) {
+            if (isFrontCover(picture)) {
+                return index;
+            }
+            if (first < 0) {
+                first = index;
+            }
+        }
+        ++index;
+    }
+    return first;
+}
+
+// FLAC pictures read their image data on demand, so only the cover is loaded
+// instead of every embedded picture
+void readFlacCover(TagLib::FLAC::File *file, CoverArt *cover)
+{
+    TagLib::FLAC::Picture *chosen = nullptr;
+    for (TagLib::FLAC::Picture *picture : file->pictureList()) {
+        if (picture->type() == TagLib::FLAC::Picture::FrontCover) {
+            chosen = picture;
+            break;
+        }
+        if (!chosen) {
+            chosen = picture;
+        }
+    }
+
+    if (chosen) {
+        const TagLib::ByteVector data = chosen->data();
+        cover->data = QByteArray(data.data(), static_cast<int>(data.size()));
+        cover->mimeType = toQString(chosen->mimeType());
+    }
+}
+
+void setError(QString *errorString, const QString &message)
+{
+    if (errorString) {
+        *errorString = message;
+    }
+}
+
+} // namespace
+
+QStringList TagEngine::supportedExtensions()
+{
+    return {"mp3", "flac", "ogg", "wma", "m4a"};
+}
+
+QStringList TagEngine::supportedNameFilters()
+{
+    QStringList filters;
+    for (const QString &extension : supportedExtensions()) {
+        filters << "*." + extension;
+    }
+    return filters;
+}
+
+bool TagEngine::isSupportedFile(const QString &filePath)
+{
+    return supportedExtensions().contains(QFileInfo(filePath).suffix().toLower());
+}
+
+bool TagEngine::readTags(const QString &filePath, TagRecord &record, QString *errorString,
+                         CoverArt *cover)
+{
+    record = TagRecord();
+    record.filePath = filePath;
+
+    try {
+        TagLib::FileRef fileRef(TAGENGINE_FILENAME(filePath));
+        if (fileRef.isNull()) {
+            setError(errorString, QStringLiteral("Could not open file for reading"));
+            return false;
+        }
+
+        if (TagLib::Tag *tag = fileRef.tag()) {
+            record.title = toQString(tag->title());
+            record.artist = toQString(tag->artist());
+            record.album = toQString(tag->album());
+            record.year = tag->year() > 0 ? QString::number(tag->year()) : QString();
+            record.genre = toQString(tag->genre());
+            record.comment = toQString(tag->comment());
+        }
+
+        const TagLib::PropertyMap properties = fileRef.properties();
+        record.track = firstProperty(properties, "TRACKNUMBER");
+        record.disc = firstProperty(properties, "DISCNUMBER");
+        record.composer = firstProperty(properties, "COMPOSER");
+        record.albumArtist = firstProperty(properties, "ALBUMARTIST");
+
+        if (TagLib::AudioProperties *audioProperties = fileRef.audioProperties()) {
+            record.lengthInSeconds = audioProperties->lengthInSeconds();
+            record.bitrate = audioProperties->bitrate();
+            record.sampleRate = audioProperties->sampleRate();
+            record.channels = audioProperties->channels();
+        }
+
+        if (cover) {
+            *cover = CoverArt();
+            if (auto *flacFile = dynamic_cast<TagLib::FLAC::File *>(fileRef.file())) {
+                readFlacCover(flacFile, cover);
+            }
+        }
+
+        if (cover && cover->isNull()) {
+            const TagLib::List<TagLib::VariantMap> pictures = fileRef.complexProperties("PICTURE");
+            const int index = coverIndex(pictures);
+            if (index >= 0) {
+                const TagLib::VariantMap &picture = pictures[static_cast<unsigned int>(index)];
+                const TagLib::ByteVector data = picture.value("data").toByteVector();
+                cover->data = QByteArray(data.data(), static_cast<int>(data.size()));
+                cover->mimeType = toQString(picture.value("mimeType").toString());
+            }
+        }
+
+        return true;
+    } catch (const std::exception &e) {
+        setError(errorString, QString::fromLocal8Bit(e.what()));
+        return false;
+    }
+}
+
+bool TagEngine::writeProperties(const QString &filePath, const QMap<QString, QString> &changes,
+                                QString *errorString, const CoverArt *cover)
+{
+    try {
+        TagLib::FileRef fileRef(TAGENGINE_FILENAME(filePath));
+        if (fileRef.isNull()) {
+            setError(errorString, QStringLiteral("Could not open file for writing"));
+            return false;
+        }
+
+        TagLib::PropertyMap properties = fileRef.properties();
+        for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+            const TagLib::String key = toTagLibString(it.key().toUpper());
+            if (it.value().isEmpty()) {
+                properties.erase(key);
+            } else {
+                properties.replace(key, TagLib::StringList(toTagLibString(it.value())));
+            }
+        }
+
+        const TagLib::PropertyMap rejected = fileRef.setProperties(properties);
+        if (!rejected.isEmpty()) {
+            setError(errorString, QStringLiteral("Unsupported properties: %1")
+                                      .arg(toQString(rejected.toString()).trimmed()));
+            return false;
+        }
+
+        if (cover) {
+            // Replace only the cover and keep any other pictures as they are.
+            // The new picture is embedded from its original encoded bytes.
+            TagLib::List<TagLib::VariantMap> pictures = fileRef.complexProperties("PICTURE");
+            const int index = coverIndex(pictures);
+            if (index >= 0) {
+                pictures.erase(std::next(pictures.begin(), index));
+            }
+
+            if (!cover->isNull()) {
+                TagLib::VariantMap picture;
+                picture.insert("data", TagLib::ByteVector(cover->data.constData(),
+                                                          static_cast<unsigned int>(cover->data.size())));
+                picture.insert("mimeType", toTagLibString(cover->mimeType));
+                picture.insert("pictureType", "Front Cover");
+                picture.insert("description", "");
+                pictures.prepend(picture);
+            }
+
+            if (!fileRef.setComplexProperties("PICTURE", pictures)) {
+                setError(errorString, QStringLiteral("Cover art is not supported for this file"));
+                return false;
+            }
+        }
+
+        if (!fileRef.save()) {
+            setError(errorString, QStringLiteral("Failed to save tags"));
+            return false;
+        }
+
+        return true;
+    } catch (const std::exception &e) {
+        setError(errorString, QString::fromLocal8Bit(e.what()));
+        return false;
+    }
+}
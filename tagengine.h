@@ -0,0 +1,66 @@
+#ifndef TAGENGINE_H
+#define TAGENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QByteArray>
+
+// Tags and audio properties of a single file, as shown in the editor
+struct TagRecord
+{
+    QString filePath;
+    QString title;
+    QString artist;
+    QString album;
+    QString year;
+    QString genre;
+    QString comment;
+    QString track;
+    QString disc;
+    QString composer;
+    QString albumArtist;
+
+    int lengthInSeconds = 0;
+    int bitrate = 0;
+    int sampleRate = 0;
+    int channels = 0;
+};
+
+// Encoded cover picture exactly as stored in (or to be embedded into) a file.
+// QByteArray is implicitly shared, so passing covers around never copies them.
+struct CoverArt
+{
+    QByteArray data;
+    QString mimeType;
+
+    bool isNull() const { return data.isEmpty(); }
+};
+
+// GUI-free access to TagLib. Worker threads may use it at the same time as
+// long as no two of them work on the same file: TagLib's shared state, such
+// as the frame and item factories, is only read once it has been built.
+class TagEngine
+{
+public:
+    static QStringList supportedExtensions();
+    static QStringList supportedNameFilters();
+    static bool isSupportedFile(const QString &filePath);
+
+    // Read tags and audio properties of filePath into record. If cover is
+    // given it receives the encoded front cover (or first picture), if any.
+    static bool readTags(const QString &filePath, TagRecord &record, QString *errorString = nullptr,
+                         CoverArt *cover = nullptr);
+
+    // Apply property changes (PropertyMap keys such as ARTIST, ALBUMARTIST)
+    // to filePath and save it. An empty value removes the property.
+    // If cover is given it replaces the front cover (a null cover removes it);
+    // otherwise the pictures in the file are left untouched.
+    // Returns true only if every change was applied and saved. If the format
+    // does not support some of the properties nothing is saved, and
+    // errorString lists the rejected ones.
+    static bool writeProperties(const QString &filePath, const QMap<QString, QString> &changes,
+                                QString *errorString = nullptr, const CoverArt *cover = nullptr);
+};
+
+#endif // TAGENGINE_H
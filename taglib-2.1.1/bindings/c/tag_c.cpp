@@ -21,10 +21,14 @@
 
 #include "tag_c.h"
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -85,9 +89,81 @@ using namespace TagLib;
 
 namespace
 {
-  List<char *> strings;
-  bool unicodeStrings = true;
-  bool stringManagementEnabled = true;
+  std::atomic<bool> unicodeStrings { true };
+  std::atomic<bool> stringManagementEnabled { true };
+
+  // Keeps the strings returned by the taglib_tag_*() getters until
+  // taglib_tag_free_strings() is called.  Strings are packed into blocks and
+  // the first block is kept when the arena is cleared, so reading the tags of
+  // file after file does not allocate once the block is large enough.
+
+  class StringArena
+  {
+  public:
+    StringArena() = default;
+
+    ~StringArena()
+    {
+      clear();
+      for(auto &block : blocks)
+        free(block);
+    }
+
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+
+    char *copy(const std::string &s)
+    {
+      const size_t size = s.size() + 1;
+
+      char *data;
+      if(size > BlockSize) {
+        data = static_cast<char *>(malloc(size));
+        if(!data)
+          return nullptr;
+        largeStrings.push_back(data);
+      }
+      else {
+        if(blocks.empty() || used + size > BlockSize) {
+          auto block = static_cast<char *>(malloc(BlockSize));
+          if(!block)
+            return nullptr;
+          blocks.push_back(block);
+          used = 0;
+        }
+        data = blocks.back() + used;
+        used += size;
+      }
+
+      ::memcpy(data, s.c_str(), size);
+      return data;
+    }
+
+    void clear()
+    {
+      for(auto &string : largeStrings)
+        free(string);
+      largeStrings.clear();
+
+      if(blocks.size() > 1) {
+        for(auto it = blocks.begin() + 1; it != blocks.end(); ++it)
+          free(*it);
+        blocks.resize(1);
+      }
+      used = 0;
+    }
+
+  private:
+    static constexpr size_t BlockSize = 4096;
+
+    std::vector<char *> blocks;
+    std::vector<char *> largeStrings;
+    size_t used { 0 };
+  };
+
+  // Every thread has its own arena, so threads neither race on it nor free
+  // each other's strings.
+  thread_local StringArena strings;
 
   char *stringToCharArray(const String &s)
   {
@@ -104,10 +180,125 @@ namespace
 #endif
   }
 
+  char *tagStringToCharArray(const String &s)
+  {
+    if(!stringManagementEnabled)
+      return stringToCharArray(s);
+
+    return strings.copy(s.to8Bit(unicodeStrings));
+  }
+
   String charArrayToString(const char *s)
   {
     return String(s, unicodeStrings ? String::UTF8 : String::Latin1);
   }
+
+  // UTF-8 copy of the properties of a file.  All strings are stored in one
+  // buffer, which does not change once the snapshot is built, so the slices
+  // can be handed out without copying.
+
+  class PropertySnapshot
+  {
+  public:
+    struct Entry
+    {
+      TagLib_String_Slice key;
+      unsigned int firstValue;
+      unsigned int valueCount;
+    };
+
+    explicit PropertySnapshot(const PropertyMap &map)
+    {
+      std::vector<std::pair<size_t, size_t>> keyOffsets;
+      std::vector<std::pair<size_t, size_t>> valueOffsets;
+
+      entries.reserve(map.size());
+      keyOffsets.reserve(map.size());
+      for(const auto &[key, values] : map) {
+        keyOffsets.push_back(append(key));
+        entries.push_back({ { nullptr, 0 },
+                            static_cast<unsigned int>(valueOffsets.size()),
+                            values.size() });
+        for(const auto &value : values)
+          valueOffsets.push_back(append(value));
+      }
+
+      for(size_t i = 0; i < entries.size(); ++i)
+        entries[i].key = slice(keyOffsets[i]);
+
+      this->values.reserve(valueOffsets.size());
+      for(const auto &offset : valueOffsets)
+        this->values.push_back(slice(offset));
+    }
+
+    std::vector<Entry> entries;
+    std::vector<TagLib_String_Slice> values;
+
+  private:
+    std::pair<size_t, size_t> append(const String &s)
+    {
+      const size_t offset = buffer.size();
+      buffer += s.to8Bit(true);
+      const size_t size = buffer.size() - offset;
+      buffer += '\0';
+      return { offset, size };
+    }
+
+    TagLib_String_Slice slice(const std::pair<size_t, size_t> &offset) const
+    {
+      return { buffer.data() + offset.first, static_cast<unsigned int>(offset.second) };
+    }
+
+    std::string buffer;
+  };
+
+  // The object behind a TagLib_File.
+
+  class FileHandle
+  {
+  public:
+    explicit FileHandle(const FileRef &ref) :
+      ref(ref)
+    {
+    }
+
+    // Builds the snapshot on first use and after the properties have been
+    // changed.  Only one is kept: slices into it are documented to be valid
+    // until the next taglib_property_set().
+    const PropertySnapshot &properties() const
+    {
+      if(!snapshot) {
+        snapshot = std::make_unique<PropertySnapshot>(
+          ref.isNull() ? PropertyMap() : ref.properties());
+      }
+      return *snapshot;
+    }
+
+    void propertiesChanged()
+    {
+      snapshot.reset();
+    }
+
+    FileRef ref;
+
+  private:
+    mutable std::unique_ptr<PropertySnapshot> snapshot;
+  };
+
+  TagLib_File *newFileHandle(const FileRef &ref)
+  {
+    return reinterpret_cast<TagLib_File *>(new FileHandle(ref));
+  }
+
+  FileHandle *fileHandle(TagLib_File *file)
+  {
+    return reinterpret_cast<FileHandle *>(file);
+  }
+
+  const FileHandle *fileHandle(const TagLib_File *file)
+  {
+    return reinterpret_cast<const FileHandle *>(file);
+  }
 }  // namespace
 
 void taglib_set_strings_unicode(BOOL unicode)
@@ -146,13 +337,13 @@ void taglib_iostream_free(TagLib_IOStream *stream)
 
 TagLib_File *taglib_file_new(const char *filename)
 {
-  return reinterpret_cast<TagLib_File *>(new FileRef(filename));
+  return newFileHandle(FileRef(filename));
 }
 
 #ifdef _WIN32
 TagLib_File *taglib_file_new_wchar(const wchar_t *filename)
 {
-  return reinterpret_cast<TagLib_File *>(new FileRef(filename));
+  return newFileHandle(FileRef(filename));
 }
 #endif
 
@@ -245,7 +436,7 @@ TagLib_File *taglib_file_new_type_any_char(const T *filename, TagLib_File_Type t
   default:
     break;
   }
-  return file ? reinterpret_cast<TagLib_File *>(new FileRef(file)) : NULL;
+  return file ? newFileHandle(FileRef(file)) : NULL;
 }
 
 TagLib_File *taglib_file_new_type(const char *filename, TagLib_File_Type type)
@@ -262,35 +453,93 @@ TagLib_File *taglib_file_new_type_wchar(const wchar_t *filename, TagLib_File_Typ
 
 TagLib_File *taglib_file_new_iostream(TagLib_IOStream *stream)
 {
-  return reinterpret_cast<TagLib_File *>(
-    new FileRef(reinterpret_cast<IOStream *>(stream)));
+  return newFileHandle(FileRef(reinterpret_cast<IOStream *>(stream)));
 }
 
 void taglib_file_free(TagLib_File *file)
 {
-  delete reinterpret_cast<FileRef *>(file);
+  delete fileHandle(file);
 }
 
 BOOL taglib_file_is_valid(const TagLib_File *file)
 {
-  return !reinterpret_cast<const FileRef *>(file)->isNull();
+  return !fileHandle(file)->ref.isNull();
 }
 
 TagLib_Tag *taglib_file_tag(const TagLib_File *file)
 {
-  auto f = reinterpret_cast<const FileRef *>(file);
+  auto f = &fileHandle(file)->ref;
   return reinterpret_cast<TagLib_Tag *>(f->tag());
 }
 
 const TagLib_AudioProperties *taglib_file_audioproperties(const TagLib_File *file)
 {
-  auto f = reinterpret_cast<const FileRef *>(file);
+  auto f = &fileHandle(file)->ref;
   return reinterpret_cast<const TagLib_AudioProperties *>(f->audioProperties());
 }
 
 BOOL taglib_file_save(TagLib_File *file)
 {
-  return reinterpret_cast<FileRef *>(file)->save();
+  return fileHandle(file)->ref.save();
+}
+
+TagLib_Tag_Fields *taglib_file_tag_fields(const TagLib_File *file)
+{
+  if(file == NULL)
+    return NULL;
+
+  auto f = &fileHandle(file)->ref;
+  if(f->isNull())
+    return NULL;
+
+  const Tag *tag = f->tag();
+  const bool unicode = unicodeStrings;
+  const std::string values[] = {
+    tag->title().to8Bit(unicode),
+    tag->artist().to8Bit(unicode),
+    tag->album().to8Bit(unicode),
+    tag->comment().to8Bit(unicode),
+    tag->genre().to8Bit(unicode)
+  };
+
+  // The strings follow the struct in the same allocation.
+
+  size_t size = sizeof(TagLib_Tag_Fields);
+  for(const auto &value : values)
+    size += value.size() + 1;
+
+  auto fields = static_cast<TagLib_Tag_Fields *>(malloc(size));
+  if(!fields)
+    return NULL;
+
+  char **targets[] = {
+    &fields->title, &fields->artist, &fields->album, &fields->comment, &fields->genre
+  };
+
+  auto data = reinterpret_cast<char *>(fields + 1);
+  for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+    ::memcpy(data, values[i].c_str(), values[i].size() + 1);
+    *targets[i] = data;
+    data += values[i].size() + 1;
+  }
+
+  fields->year = tag->year();
+  fields->track = tag->track();
+
+  if(const AudioProperties *properties = f->audioProperties()) {
+    fields->length = properties->lengthInSeconds();
+    fields->bitrate = properties->bitrate();
+    fields->samplerate = properties->sampleRate();
+    fields->channels = properties->channels();
+  }
+  else {
+    fields->length = 0;
+    fields->bitrate = 0;
+    fields->samplerate = 0;
+    fields->channels = 0;
+  }
+
+  return fields;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -300,46 +549,31 @@ BOOL taglib_file_save(TagLib_File *file)
 char *taglib_tag_title(const TagLib_Tag *tag)
 {
   auto t = reinterpret_cast<const Tag *>(tag);
-  char *s = stringToCharArray(t->title());
-  if(stringManagementEnabled)
-    strings.append(s);
-  return s;
+  return tagStringToCharArray(t->title());
 }
 
 char *taglib_tag_artist(const TagLib_Tag *tag)
 {
   auto t = reinterpret_cast<const Tag *>(tag);
-  char *s = stringToCharArray(t->artist());
-  if(stringManagementEnabled)
-    strings.append(s);
-  return s;
+  return tagStringToCharArray(t->artist());
 }
 
 char *taglib_tag_album(const TagLib_Tag *tag)
 {
   auto t = reinterpret_cast<const Tag *>(tag);
-  char *s = stringToCharArray(t->album());
-  if(stringManagementEnabled)
-    strings.append(s);
-  return s;
+  return tagStringToCharArray(t->album());
 }
 
 char *taglib_tag_comment(const TagLib_Tag *tag)
 {
   auto t = reinterpret_cast<const Tag *>(tag);
-  char *s = stringToCharArray(t->comment());
-  if(stringManagementEnabled)
-    strings.append(s);
-  return s;
+  return tagStringToCharArray(t->comment());
 }
 
 char *taglib_tag_genre(const TagLib_Tag *tag)
 {
   auto t = reinterpret_cast<const Tag *>(tag);
-  char *s = stringToCharArray(t->genre());
-  if(stringManagementEnabled)
-    strings.append(s);
-  return s;
+  return tagStringToCharArray(t->genre());
 }
 
 unsigned int taglib_tag_year(const TagLib_Tag *tag)
@@ -401,8 +635,6 @@ void taglib_tag_free_strings()
   if(!stringManagementEnabled)
     return;
 
-  for(auto &string : std::as_const(strings))
-    free(string);
   strings.clear();
 }
 
@@ -468,7 +700,8 @@ void _taglib_property_set(TagLib_File *file, const char* prop, const char* value
   if(file == NULL || prop == NULL)
     return;
 
-  auto tfile = reinterpret_cast<FileRef *>(file);
+  FileHandle *handle = fileHandle(file);
+  FileRef *tfile = &handle->ref;
   PropertyMap map = tfile->tag()->properties();
 
   if(value) {
@@ -490,6 +723,7 @@ void _taglib_property_set(TagLib_File *file, const char* prop, const char* value
   }
 
   tfile->setProperties(map);
+  handle->propertiesChanged();
 }
 
 }  // namespace
@@ -509,7 +743,7 @@ char** taglib_property_keys(const TagLib_File *file)
   if(file == NULL)
     return NULL;
 
-  const PropertyMap map = reinterpret_cast<const FileRef *>(file)->properties();
+  const PropertyMap map = fileHandle(file)->ref.properties();
   if(map.isEmpty())
     return NULL;
 
@@ -529,7 +763,7 @@ char **taglib_property_get(const TagLib_File *file, const char *prop)
   if(file == NULL || prop == NULL)
     return NULL;
 
-  const PropertyMap map = reinterpret_cast<const FileRef *>(file)->properties();
+  const PropertyMap map = fileHandle(file)->ref.properties();
 
   auto property = map.find(prop);
   if(property == map.end())
@@ -558,6 +792,53 @@ void taglib_property_free(char **props)
   free(props);
 }
 
+unsigned int taglib_property_foreach(const TagLib_File *file,
+                                     TagLib_Property_Visitor visitor, void *userData)
+{
+  if(file == NULL || visitor == NULL)
+    return 0;
+
+  const PropertySnapshot &snapshot = fileHandle(file)->properties();
+
+  unsigned int visited = 0;
+  for(const auto &entry : snapshot.entries) {
+    ++visited;
+    if(!visitor(&entry.key, snapshot.values.data() + entry.firstValue,
+                entry.valueCount, userData))
+      break;
+  }
+  return visited;
+}
+
+unsigned int taglib_property_count(const TagLib_File *file)
+{
+  if(file == NULL)
+    return 0;
+
+  return static_cast<unsigned int>(fileHandle(file)->properties().entries.size());
+}
+
+BOOL taglib_property_at(const TagLib_File *file, unsigned int index,
+                        TagLib_String_Slice *key,
+                        const TagLib_String_Slice **values, unsigned int *valueCount)
+{
+  if(file == NULL)
+    return false;
+
+  const PropertySnapshot &snapshot = fileHandle(file)->properties();
+  if(index >= snapshot.entries.size())
+    return false;
+
+  const PropertySnapshot::Entry &entry = snapshot.entries[index];
+  if(key)
+    *key = entry.key;
+  if(values)
+    *values = snapshot.values.data() + entry.firstValue;
+  if(valueCount)
+    *valueCount = entry.valueCount;
+  return true;
+}
+
 
 /******************************************************************************
  * Complex Properties API
@@ -572,7 +853,7 @@ bool _taglib_complex_property_set(
   if(file == NULL || key == NULL)
     return false;
 
-  auto tfile = reinterpret_cast<FileRef *>(file);
+  auto tfile = &fileHandle(file)->ref;
 
   if(value == NULL) {
     return tfile->setComplexProperties(key, {});
@@ -653,7 +934,7 @@ char** taglib_complex_property_keys(const TagLib_File *file)
     return NULL;
   }
 
-  const StringList strs = reinterpret_cast<const FileRef *>(file)->complexPropertyKeys();
+  const StringList strs = fileHandle(file)->ref.complexPropertyKeys();
   if(strs.isEmpty()) {
     return NULL;
   }
@@ -676,7 +957,7 @@ TagLib_Complex_Property_Attribute*** taglib_complex_property_get(
     return NULL;
   }
 
-  const auto variantMaps = reinterpret_cast<const FileRef *>(file)->complexProperties(key);
+  const auto variantMaps = fileHandle(file)->ref.complexProperties(key);
   if(variantMaps.isEmpty()) {
     return NULL;
   }
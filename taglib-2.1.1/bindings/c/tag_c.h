@@ -75,14 +75,19 @@ typedef struct { int dummy; } TagLib_IOStream;
  * By default all strings coming into or out of TagLib's C API are in UTF8.
  * However, it may be desirable for TagLib to operate on Latin1 (ISO-8859-1)
  * strings in which case this should be set to FALSE.
+ *
+ * This setting applies to all threads.
  */
 TAGLIB_C_EXPORT void taglib_set_strings_unicode(BOOL unicode);
 
 /*!
  * TagLib can keep track of strings that are created when outputting tag values
- * and clear them using taglib_tag_clear_strings().  This is enabled by default.
+ * and clear them using taglib_tag_free_strings().  This is enabled by default.
  * However if you wish to do more fine grained management of strings, you can do
  * so by setting \a management to FALSE.
+ *
+ * The tracked strings are kept per thread, so several threads can read tags
+ * and free their strings independently.  This setting applies to all threads.
  */
 TAGLIB_C_EXPORT void taglib_set_string_management_enabled(BOOL management);
 
@@ -195,6 +200,37 @@ TAGLIB_C_EXPORT const TagLib_AudioProperties *taglib_file_audioproperties(const
  */
 TAGLIB_C_EXPORT BOOL taglib_file_save(TagLib_File *file);
 
+/*!
+ * The standard tag fields and audio properties of a file, as returned by
+ * taglib_file_tag_fields().
+ */
+typedef struct {
+  char *title;
+  char *artist;
+  char *album;
+  char *comment;
+  char *genre;
+  unsigned int year;
+  unsigned int track;
+  /* Audio properties, 0 if they were not read */
+  int length;
+  int bitrate;
+  int samplerate;
+  int channels;
+} TagLib_Tag_Fields;
+
+/*!
+ * Returns the standard tag fields and audio properties of \a file in a single
+ * allocation, which has to be freed using taglib_free().
+ *
+ * The strings are encoded as set with taglib_set_strings_unicode() and are
+ * not affected by taglib_tag_free_strings().  Unlike the taglib_tag_*()
+ * getters this does not touch any state shared between threads.
+ *
+ * \returns NULL if \a file is not valid or the memory could not be allocated.
+ */
+TAGLIB_C_EXPORT TagLib_Tag_Fields *taglib_file_tag_fields(const TagLib_File *file);
+
 /******************************************************************************
  * Tag API
  ******************************************************************************/
@@ -295,7 +331,9 @@ TAGLIB_C_EXPORT void taglib_tag_set_year(TagLib_Tag *tag, unsigned int year);
 TAGLIB_C_EXPORT void taglib_tag_set_track(TagLib_Tag *tag, unsigned int track);
 
 /*!
- * Frees all of the strings that have been created by the tag.
+ * Frees all of the strings that have been created by the tag in the calling
+ * thread.  Strings which have not been freed are released when their thread
+ * exits.
  */
 TAGLIB_C_EXPORT void taglib_tag_free_strings(void);
 
@@ -377,6 +415,60 @@ TAGLIB_C_EXPORT char** taglib_property_get(const TagLib_File *file, const char *
  */
 TAGLIB_C_EXPORT void taglib_property_free(char **props);
 
+/*!
+ * A UTF-8 string owned by TagLib.  \a data is NUL-terminated, \a size does
+ * not include the terminator.
+ */
+typedef struct {
+  const char *data;
+  unsigned int size;
+} TagLib_String_Slice;
+
+/*!
+ * Called by taglib_property_foreach() with the \a key of a property and its
+ * \a count \a values.  Return FALSE to stop the iteration.
+ */
+typedef BOOL (*TagLib_Property_Visitor)(const TagLib_String_Slice *key,
+                                        const TagLib_String_Slice *values,
+                                        unsigned int count, void *userData);
+
+/*!
+ * Calls \a visitor for every property of \a file, in the order of
+ * taglib_property_keys(), passing \a userData along.
+ *
+ * The properties are read and converted once per file.  The slices are always
+ * UTF-8 and nothing has to be copied or freed by the caller.  They stay valid
+ * until the next taglib_property_set() or taglib_property_set_append() on
+ * \a file, which must therefore not be called from \a visitor, or until the
+ * file is freed.  The properties are read again on the next call after such
+ * a change.  Changes made through the taglib_tag_set_*() functions after the
+ * first call are not seen.
+ *
+ * \return The number of properties passed to \a visitor.
+ */
+TAGLIB_C_EXPORT unsigned int taglib_property_foreach(const TagLib_File *file,
+                                                     TagLib_Property_Visitor visitor,
+                                                     void *userData);
+
+/*!
+ * Returns the number of properties of \a file, for use with
+ * taglib_property_at().
+ */
+TAGLIB_C_EXPORT unsigned int taglib_property_count(const TagLib_File *file);
+
+/*!
+ * Sets \a key, \a values and \a valueCount to the property at \a index,
+ * which must be less than taglib_property_count().  Any of the output
+ * pointers may be NULL.  The slices are owned by TagLib and stay valid just
+ * as long as those of taglib_property_foreach().
+ *
+ * \return FALSE if \a index is out of range.
+ */
+TAGLIB_C_EXPORT BOOL taglib_property_at(const TagLib_File *file, unsigned int index,
+                                        TagLib_String_Slice *key,
+                                        const TagLib_String_Slice **values,
+                                        unsigned int *valueCount);
+
 /******************************************************************************
  * Complex Properties API
  ******************************************************************************/
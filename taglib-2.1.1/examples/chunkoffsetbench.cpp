@@ -0,0 +1,163 @@
+/* Copyright (C) 2026 by the TagLib developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measures how long saving a tag takes in MP4 files with large chunk offset
+// tables, such as audiobooks, e.g.
+//
+//   chunkoffsetbench -n 20 -c 200000
+//   chunkoffsetbench -n 20 book.m4b
+//
+// Without files it builds files in memory with the given number of chunks,
+// one with a 32 bit (stco) and one with a 64 bit (co64) table, and one
+// without chunks as the baseline.  Every save adds a tag too large for the
+// existing padding, so the media data moves and every entry of the table has
+// to be updated.  Files are copied to memory first and are not changed.
+//
+// Prints the average time per save in milliseconds.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "tbytevector.h"
+#include "tbytevectorstream.h"
+#include "mp4file.h"
+#include "mp4tag.h"
+
+using namespace TagLib;
+
+namespace
+{
+  ByteVector atom(const char *name, const ByteVector &data)
+  {
+    return ByteVector::fromUInt(static_cast<unsigned int>(data.size() + 8)) +
+           ByteVector(name) + data;
+  }
+
+  // A file with a single track whose chunks all point into mdat, behind moov
+  ByteVector makeFile(unsigned int chunks, bool co64)
+  {
+    ByteVector table = ByteVector(4, '\0') + ByteVector::fromUInt(chunks);
+    for(unsigned int i = 0; i < chunks; ++i) {
+      if(co64)
+        table.append(ByteVector::fromLongLong(0x100000000LL + i));
+      else
+        table.append(ByteVector::fromUInt(0x10000000U + i));
+    }
+
+    const ByteVector moov = atom("moov", atom("trak", atom("mdia", atom("minf",
+      atom("stbl", atom(co64 ? "co64" : "stco", table))))));
+    return atom("ftyp", ByteVector("M4B \0\0\0\0", 8)) + moov +
+           atom("mdat", ByteVector(16, '\0'));
+  }
+
+  ByteVector readFile(const char *fileName)
+  {
+    std::ifstream in(fileName, std::ios::binary);
+    const std::vector<char> data { std::istreambuf_iterator<char>(in),
+                                   std::istreambuf_iterator<char>() };
+    return ByteVector(data.data(), static_cast<unsigned int>(data.size()));
+  }
+
+  double saveMilliseconds(const ByteVector &data, int iterations)
+  {
+    const String comment(std::string(64 * 1024, 'x'));
+
+    double total = 0.0;
+    for(int i = 0; i < iterations; ++i) {
+      ByteVectorStream stream(data);
+      MP4::File f(&stream, false);
+      if(!f.isValid())
+        return -1.0;
+      f.tag()->setComment(comment);
+
+      const auto start = std::chrono::steady_clock::now();
+      const bool saved = f.save();
+      const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+      if(!saved)
+        return -1.0;
+      total += elapsed.count();
+    }
+    return total / iterations;
+  }
+
+  void printRow(const std::string &label, double milliseconds)
+  {
+    std::cout << std::left << std::setw(40) << label << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3)
+              << milliseconds << std::endl;
+  }
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+  int iterations = 10;
+  unsigned int chunks = 200000;
+  int first = 1;
+  while(first + 1 < argc) {
+    if(std::strcmp(argv[first], "-n") == 0)
+      iterations = std::max(1, std::atoi(argv[first + 1]));
+    else if(std::strcmp(argv[first], "-c") == 0)
+      chunks = static_cast<unsigned int>(std::max(0, std::atoi(argv[first + 1])));
+    else
+      break;
+    first += 2;
+  }
+
+  if(first < argc && argv[first][0] == '-') {
+    std::cout << "usage: " << argv[0] << " [-n iterations] [-c chunks] [file...]" << std::endl;
+    return 1;
+  }
+
+  std::cout << std::left << std::setw(40) << "file" << std::right
+            << std::setw(12) << "ms per save" << std::endl;
+
+  if(first >= argc) {
+    printRow("no chunks", saveMilliseconds(makeFile(0, false), iterations));
+    printRow(std::to_string(chunks) + " chunks, stco",
+             saveMilliseconds(makeFile(chunks, false), iterations));
+    printRow(std::to_string(chunks) + " chunks, co64",
+             saveMilliseconds(makeFile(chunks, true), iterations));
+    return 0;
+  }
+
+  for(int i = first; i < argc; ++i) {
+    const double milliseconds = saveMilliseconds(readFile(argv[i]), iterations);
+    if(milliseconds < 0.0) {
+      std::cerr << argv[i] << ": could not be saved" << std::endl;
+      continue;
+    }
+    printRow(argv[i], milliseconds);
+  }
+
+  return 0;
+}
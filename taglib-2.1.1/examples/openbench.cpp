@@ -0,0 +1,154 @@
+/* Copyright (C) 2026 by the TagLib developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measures how long opening a file through FileRef takes with each audio
+// properties read style, e.g.
+//
+//   openbench -n 200 music/*.mp3 music/*.ogg music/*.wv
+//
+// Prints the average time per open, in microseconds, for every file and for
+// every file extension.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "fileref.h"
+#include "tag.h"
+
+namespace
+{
+  struct Mode
+  {
+    const char *name;
+    bool readAudioProperties;
+    TagLib::AudioProperties::ReadStyle style;
+  };
+
+  constexpr Mode modes[] = {
+    { "none",     false, TagLib::AudioProperties::Average  },
+    { "tagsonly", true,  TagLib::AudioProperties::TagsOnly },
+    { "fast",     true,  TagLib::AudioProperties::Fast     },
+    { "average",  true,  TagLib::AudioProperties::Average  },
+    { "accurate", true,  TagLib::AudioProperties::Accurate }
+  };
+
+  constexpr int modeCount = sizeof(modes) / sizeof(modes[0]);
+
+  double openMicroseconds(const char *fileName, const Mode &mode, int iterations)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) {
+      TagLib::FileRef f(fileName, mode.readAudioProperties, mode.style);
+      if(f.isNull())
+        return -1.0;
+      // Touch the values a list view would show
+      static_cast<void>(f.tag()->title());
+      if(f.audioProperties())
+        static_cast<void>(f.audioProperties()->lengthInMilliseconds());
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+  }
+
+  std::string extensionOf(const std::string &fileName)
+  {
+    const auto dot = fileName.rfind('.');
+    return dot == std::string::npos ? std::string() : fileName.substr(dot + 1);
+  }
+
+  void printRow(const std::string &label, const double *values)
+  {
+    std::cout << std::left << std::setw(40) << label << std::right;
+    for(int m = 0; m < modeCount; ++m)
+      std::cout << std::setw(10) << std::fixed << std::setprecision(1) << values[m];
+    std::cout << std::endl;
+  }
+
+  void printHeader(const char *title)
+  {
+    std::cout << std::left << std::setw(40) << title << std::right;
+    for(const auto &mode : modes)
+      std::cout << std::setw(10) << mode.name;
+    std::cout << std::endl;
+  }
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+  int iterations = 100;
+  int first = 1;
+  if(argc > 2 && std::strcmp(argv[1], "-n") == 0) {
+    iterations = std::max(1, std::atoi(argv[2]));
+    first = 3;
+  }
+
+  if(first >= argc) {
+    std::cout << "usage: " << argv[0] << " [-n iterations] file..." << std::endl;
+    return 1;
+  }
+
+  struct Totals
+  {
+    double values[modeCount] {};
+    int files { 0 };
+  };
+  std::map<std::string, Totals> byExtension;
+
+  printHeader("file (us per open)");
+  for(int i = first; i < argc; ++i) {
+    double values[modeCount];
+    bool ok = true;
+    for(int m = 0; m < modeCount && ok; ++m) {
+      values[m] = openMicroseconds(argv[i], modes[m], iterations);
+      ok = values[m] >= 0.0;
+    }
+    if(!ok) {
+      std::cerr << argv[i] << ": could not be opened" << std::endl;
+      continue;
+    }
+    printRow(argv[i], values);
+
+    Totals &totals = byExtension[extensionOf(argv[i])];
+    for(int m = 0; m < modeCount; ++m)
+      totals.values[m] += values[m];
+    ++totals.files;
+  }
+
+  std::cout << std::endl;
+  printHeader("extension (us per open)");
+  for(auto &[extension, totals] : byExtension) {
+    for(double &value : totals.values)
+      value /= totals.files;
+    printRow(extension + " (" + std::to_string(totals.files) + ")", totals.values);
+  }
+
+  return 0;
+}
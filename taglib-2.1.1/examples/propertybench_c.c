@@ -0,0 +1,142 @@
+/* Copyright (C) 2026 by the TagLib developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Compares walking all properties of a file with taglib_property_keys() and
+ * taglib_property_get() against taglib_property_foreach(), e.g.
+ *
+ *   propertybench_c -n 1000 a.flac b.mp3 c.m4a
+ *
+ * Prints the average time per walk over an open file, in microseconds.
+ */
+
+#include "tag_c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* The pattern the C API used to require */
+static size_t walkKeysAndGet(const TagLib_File *file)
+{
+  size_t bytes = 0;
+  char **keys = taglib_property_keys(file);
+  char **key;
+
+  if(keys == NULL)
+    return 0;
+
+  for(key = keys; *key; ++key) {
+    char **values = taglib_property_get(file, *key);
+    char **value;
+    bytes += strlen(*key);
+    for(value = values; value && *value; ++value)
+      bytes += strlen(*value);
+    taglib_property_free(values);
+  }
+  taglib_property_free(keys);
+  return bytes;
+}
+
+static BOOL addSizes(const TagLib_String_Slice *key, const TagLib_String_Slice *values,
+                     unsigned int count, void *userData)
+{
+  size_t *bytes = (size_t *)userData;
+  unsigned int i;
+
+  *bytes += key->size;
+  for(i = 0; i < count; ++i)
+    *bytes += values[i].size;
+  return 1;
+}
+
+static size_t walkForeach(const TagLib_File *file)
+{
+  size_t bytes = 0;
+  taglib_property_foreach(file, addSizes, &bytes);
+  return bytes;
+}
+
+int main(int argc, char *argv[])
+{
+  int iterations = 1000;
+  int first = 1;
+  int i;
+
+  if(argc > 2 && strcmp(argv[1], "-n") == 0) {
+    iterations = atoi(argv[2]);
+    if(iterations < 1)
+      iterations = 1;
+    first = 3;
+  }
+
+  if(first >= argc) {
+    printf("usage: %s [-n iterations] file...\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-40s %8s %12s %12s\n", "file (us per walk)", "props", "keys+get", "foreach");
+
+  for(i = first; i < argc; ++i) {
+    TagLib_File *file = taglib_file_new(argv[i]);
+    size_t oldBytes = 0;
+    size_t newBytes = 0;
+    double start, oldTime, newTime;
+    int n;
+
+    if(file == NULL || !taglib_file_is_valid(file)) {
+      fprintf(stderr, "%s: could not be opened\n", argv[i]);
+      if(file)
+        taglib_file_free(file);
+      continue;
+    }
+
+    start = now();
+    for(n = 0; n < iterations; ++n)
+      oldBytes += walkKeysAndGet(file);
+    oldTime = (now() - start) / iterations;
+
+    start = now();
+    for(n = 0; n < iterations; ++n)
+      newBytes += walkForeach(file);
+    newTime = (now() - start) / iterations;
+
+    if(oldBytes != newBytes)
+      fprintf(stderr, "%s: the walks saw different data\n", argv[i]);
+
+    printf("%-40s %8u %12.2f %12.2f\n", argv[i], taglib_property_count(file),
+           oldTime, newTime);
+
+    taglib_file_free(file);
+  }
+
+  return 0;
+}
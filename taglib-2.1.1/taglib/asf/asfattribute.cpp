@@ -162,30 +162,30 @@ ASF::Picture ASF::Attribute::toPicture() const
   return d->pictureValue;
 }
 
-String ASF::Attribute::parse(ASF::File &file, int kind)
+String ASF::Attribute::parse(const ByteVector &data, unsigned int &pos, int kind)
 {
   unsigned int size, nameLength;
   String name;
   d->pictureValue = Picture::fromInvalid();
   // extended content descriptor
   if(kind == 0) {
-    nameLength = readWORD(&file);
-    name = readString(&file, nameLength);
-    d->type = static_cast<ASF::Attribute::AttributeTypes>(readWORD(&file));
-    size = readWORD(&file);
+    nameLength = readWORD(data, pos);
+    name = readString(data, pos, nameLength);
+    d->type = static_cast<ASF::Attribute::AttributeTypes>(readWORD(data, pos));
+    size = readWORD(data, pos);
   }
   // metadata & metadata library
   else {
-    int temp = readWORD(&file);
+    int temp = readWORD(data, pos);
     // metadata library
     if(kind == 2) {
       d->language = temp;
     }
-    d->stream = readWORD(&file);
-    nameLength = readWORD(&file);
-    d->type = static_cast<ASF::Attribute::AttributeTypes>(readWORD(&file));
-    size = readDWORD(&file);
-    name = readString(&file, nameLength);
+    d->stream = readWORD(data, pos);
+    nameLength = readWORD(data, pos);
+    d->type = static_cast<ASF::Attribute::AttributeTypes>(readWORD(data, pos));
+    size = readDWORD(data, pos);
+    name = readString(data, pos, nameLength);
   }
 
   if(kind != 2 && size > 65535) {
@@ -194,33 +194,33 @@ String ASF::Attribute::parse(ASF::File &file, int kind)
 
   switch(d->type) {
   case WordType:
-    d->numericValue = readWORD(&file);
+    d->numericValue = readWORD(data, pos);
     break;
 
   case BoolType:
     if(kind == 0) {
-      d->numericValue = readDWORD(&file) != 0;
+      d->numericValue = readDWORD(data, pos) != 0;
     }
     else {
-      d->numericValue = readWORD(&file) != 0;
+      d->numericValue = readWORD(data, pos) != 0;
     }
     break;
 
   case DWordType:
-    d->numericValue = readDWORD(&file);
+    d->numericValue = readDWORD(data, pos);
     break;
 
   case QWordType:
-    d->numericValue = readQWORD(&file);
+    d->numericValue = readQWORD(data, pos);
     break;
 
   case UnicodeType:
-    d->stringValue = readString(&file, size);
+    d->stringValue = readString(data, pos, size);
     break;
 
   case BytesType:
   case GuidType:
-    d->byteVectorValue = file.readBlock(size);
+    d->byteVectorValue = readBlock(data, pos, size);
     break;
   }
 
@@ -25,6 +25,7 @@
 
 #include "asffile.h"
 
+#include <cstring>
 #include <utility>
 
 #include "tdebug.h"
@@ -89,6 +90,35 @@ namespace
   const ByteVector contentEncryptionGuid("\xFB\xB3\x11\x22\x23\xBD\xD2\x11\xB4\xB7\x00\xA0\xC9\x55\xFC\x6E", 16);
   const ByteVector extendedContentEncryptionGuid("\x14\xE6\x8A\x29\x22\x26 \x17\x4C\xB9\x35\xDA\xE0\x7E\xE9\x28\x9C", 16);
   const ByteVector advancedContentEncryptionGuid("\xB6\x9B\x07\x7A\xA4\xDA\x12\x4E\xA5\xCA\x91\xD3\x8D\xC1\x1A\x8D", 16);
+
+  // A GUID loaded as two 64-bit words, so that finding the type of an object
+  // in the header costs two integer compares instead of a ByteVector.
+  struct Guid
+  {
+    explicit Guid(const char *data)
+    {
+      ::memcpy(words, data, sizeof(words));
+    }
+
+    bool operator==(const Guid &other) const
+    {
+      return words[0] == other.words[0] && words[1] == other.words[1];
+    }
+
+    unsigned long long words[2];
+  };
+
+  const Guid filePropertiesId(filePropertiesGuid.data());
+  const Guid streamPropertiesId(streamPropertiesGuid.data());
+  const Guid contentDescriptionId(contentDescriptionGuid.data());
+  const Guid extendedContentDescriptionId(extendedContentDescriptionGuid.data());
+  const Guid headerExtensionId(headerExtensionGuid.data());
+  const Guid metadataId(metadataGuid.data());
+  const Guid metadataLibraryId(metadataLibraryGuid.data());
+  const Guid codecListId(codecListGuid.data());
+  const Guid contentEncryptionId(contentEncryptionGuid.data());
+  const Guid extendedContentEncryptionId(extendedContentEncryptionGuid.data());
+  const Guid advancedContentEncryptionId(advancedContentEncryptionGuid.data());
 }  // namespace
 
 class ASF::File::FilePrivate::BaseObject
@@ -97,7 +127,7 @@ public:
   ByteVector data;
   virtual ~BaseObject() = default;
   virtual ByteVector guid() const = 0;
-  virtual void parse(ASF::File *file, long long size);
+  virtual void parse(ASF::File *file, const ByteVector &objectData);
   virtual ByteVector render(ASF::File *file);
 };
 
@@ -113,21 +143,21 @@ class ASF::File::FilePrivate::FilePropertiesObject : public ASF::File::FilePriva
 {
 public:
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
 };
 
 class ASF::File::FilePrivate::StreamPropertiesObject : public ASF::File::FilePrivate::BaseObject
 {
 public:
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
 };
 
 class ASF::File::FilePrivate::ContentDescriptionObject : public ASF::File::FilePrivate::BaseObject
 {
 public:
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
   ByteVector render(ASF::File *file) override;
 };
 
@@ -136,7 +166,7 @@ class ASF::File::FilePrivate::ExtendedContentDescriptionObject : public ASF::Fil
 public:
   ByteVectorList attributeData;
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
   ByteVector render(ASF::File *file) override;
 };
 
@@ -145,7 +175,7 @@ class ASF::File::FilePrivate::MetadataObject : public ASF::File::FilePrivate::Ba
 public:
   ByteVectorList attributeData;
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
   ByteVector render(ASF::File *file) override;
 };
 
@@ -154,7 +184,7 @@ class ASF::File::FilePrivate::MetadataLibraryObject : public ASF::File::FilePriv
 public:
   ByteVectorList attributeData;
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
   ByteVector render(ASF::File *file) override;
 };
 
@@ -164,7 +194,7 @@ public:
   List<ASF::File::FilePrivate::BaseObject *> objects;
   HeaderExtensionObject();
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
   ByteVector render(ASF::File *file) override;
 };
 
@@ -172,7 +202,7 @@ class ASF::File::FilePrivate::CodecListObject : public ASF::File::FilePrivate::B
 {
 public:
   ByteVector guid() const override;
-  void parse(ASF::File *file, long long size) override;
+  void parse(ASF::File *file, const ByteVector &objectData) override;
 
 private:
   enum CodecType
@@ -183,13 +213,9 @@ private:
   };
 };
 
-void ASF::File::FilePrivate::BaseObject::parse(ASF::File *file, long long size)
+void ASF::File::FilePrivate::BaseObject::parse(ASF::File * /*file*/, const ByteVector &objectData)
 {
-  data.clear();
-  if(size > 24 && size <= file->length())
-    data = file->readBlock(size - 24);
-  else
-    data = ByteVector();
+  data = objectData;
 }
 
 ByteVector ASF::File::FilePrivate::BaseObject::render(ASF::File * /*file*/)
@@ -211,9 +237,9 @@ ByteVector ASF::File::FilePrivate::FilePropertiesObject::guid() const
   return filePropertiesGuid;
 }
 
-void ASF::File::FilePrivate::FilePropertiesObject::parse(ASF::File *file, long long size)
+void ASF::File::FilePrivate::FilePropertiesObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  BaseObject::parse(file, size);
+  BaseObject::parse(file, objectData);
   if(data.size() < 64) {
     debug("ASF::File::FilePrivate::FilePropertiesObject::parse() -- data is too short.");
     return;
@@ -230,9 +256,9 @@ ByteVector ASF::File::FilePrivate::StreamPropertiesObject::guid() const
   return streamPropertiesGuid;
 }
 
-void ASF::File::FilePrivate::StreamPropertiesObject::parse(ASF::File *file, long long size)
+void ASF::File::FilePrivate::StreamPropertiesObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  BaseObject::parse(file, size);
+  BaseObject::parse(file, objectData);
   if(data.size() < 70) {
     debug("ASF::File::FilePrivate::StreamPropertiesObject::parse() -- data is too short.");
     return;
@@ -250,18 +276,19 @@ ByteVector ASF::File::FilePrivate::ContentDescriptionObject::guid() const
   return contentDescriptionGuid;
 }
 
-void ASF::File::FilePrivate::ContentDescriptionObject::parse(ASF::File *file, long long /*size*/)
+void ASF::File::FilePrivate::ContentDescriptionObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  const int titleLength     = readWORD(file);
-  const int artistLength    = readWORD(file);
-  const int copyrightLength = readWORD(file);
-  const int commentLength   = readWORD(file);
-  const int ratingLength    = readWORD(file);
-  file->d->tag->setTitle(readString(file,titleLength));
-  file->d->tag->setArtist(readString(file,artistLength));
-  file->d->tag->setCopyright(readString(file,copyrightLength));
-  file->d->tag->setComment(readString(file,commentLength));
-  file->d->tag->setRating(readString(file,ratingLength));
+  unsigned int pos = 0;
+  const int titleLength     = readWORD(objectData, pos);
+  const int artistLength    = readWORD(objectData, pos);
+  const int copyrightLength = readWORD(objectData, pos);
+  const int commentLength   = readWORD(objectData, pos);
+  const int ratingLength    = readWORD(objectData, pos);
+  file->d->tag->setTitle(readString(objectData, pos, titleLength));
+  file->d->tag->setArtist(readString(objectData, pos, artistLength));
+  file->d->tag->setCopyright(readString(objectData, pos, copyrightLength));
+  file->d->tag->setComment(readString(objectData, pos, commentLength));
+  file->d->tag->setRating(readString(objectData, pos, ratingLength));
 }
 
 ByteVector ASF::File::FilePrivate::ContentDescriptionObject::render(ASF::File *file)
@@ -290,12 +317,13 @@ ByteVector ASF::File::FilePrivate::ExtendedContentDescriptionObject::guid() cons
   return extendedContentDescriptionGuid;
 }
 
-void ASF::File::FilePrivate::ExtendedContentDescriptionObject::parse(ASF::File *file, long long /*size*/)
+void ASF::File::FilePrivate::ExtendedContentDescriptionObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  int count = readWORD(file);
+  unsigned int pos = 0;
+  int count = readWORD(objectData, pos);
   while(count--) {
     ASF::Attribute attribute;
-    String name = attribute.parse(*file);
+    String name = attribute.parse(objectData, pos);
     file->d->tag->addAttribute(name, attribute);
   }
 }
@@ -313,12 +341,13 @@ ByteVector ASF::File::FilePrivate::MetadataObject::guid() const
   return metadataGuid;
 }
 
-void ASF::File::FilePrivate::MetadataObject::parse(ASF::File *file, long long /*size*/)
+void ASF::File::FilePrivate::MetadataObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  int count = readWORD(file);
+  unsigned int pos = 0;
+  int count = readWORD(objectData, pos);
   while(count--) {
     ASF::Attribute attribute;
-    String name = attribute.parse(*file, 1);
+    String name = attribute.parse(objectData, pos, 1);
     file->d->tag->addAttribute(name, attribute);
   }
 }
@@ -336,12 +365,13 @@ ByteVector ASF::File::FilePrivate::MetadataLibraryObject::guid() const
   return metadataLibraryGuid;
 }
 
-void ASF::File::FilePrivate::MetadataLibraryObject::parse(ASF::File *file, long long /*size*/)
+void ASF::File::FilePrivate::MetadataLibraryObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  int count = readWORD(file);
+  unsigned int pos = 0;
+  int count = readWORD(objectData, pos);
   while(count--) {
     ASF::Attribute attribute;
-    String name = attribute.parse(*file, 2);
+    String name = attribute.parse(objectData, pos, 2);
     file->d->tag->addAttribute(name, attribute);
   }
 }
@@ -364,38 +394,42 @@ ByteVector ASF::File::FilePrivate::HeaderExtensionObject::guid() const
   return headerExtensionGuid;
 }
 
-void ASF::File::FilePrivate::HeaderExtensionObject::parse(ASF::File *file, long long /*size*/)
+void ASF::File::FilePrivate::HeaderExtensionObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  file->seek(18, File::Current);
-  long long dataSize = readDWORD(file);
-  long long dataPos = 0;
-  while(dataPos < dataSize) {
-    ByteVector uid = file->readBlock(16);
-    if(uid.size() != 16) {
+  unsigned int pos = 18;
+  const long long dataSize = readDWORD(objectData, pos);
+  if(dataSize > objectData.size() - pos) {
+    file->setValid(false);
+    return;
+  }
+  const unsigned int dataEnd = pos + static_cast<unsigned int>(dataSize);
+  while(pos < dataEnd) {
+    if(dataEnd - pos < 24) {
       file->setValid(false);
       break;
     }
-    bool ok;
-    long long size = readQWORD(file, &ok);
-    if(!ok || size < 0 || size > dataSize - dataPos) {
+    const Guid uid(objectData.data() + pos);
+    pos += 16;
+    const long long size = readQWORD(objectData, pos);
+    if(size < 24 || size - 24 > dataEnd - pos) {
       file->setValid(false);
       break;
     }
     BaseObject *obj;
-    if(uid == metadataGuid) {
+    if(uid == metadataId) {
       file->d->metadataObject = new MetadataObject();
       obj = file->d->metadataObject;
     }
-    else if(uid == metadataLibraryGuid) {
+    else if(uid == metadataLibraryId) {
       file->d->metadataLibraryObject = new MetadataLibraryObject();
       obj = file->d->metadataLibraryObject;
     }
     else {
-      obj = new UnknownObject(uid);
+      obj = new UnknownObject(objectData.mid(pos - 24, 16));
     }
-    obj->parse(file, size);
+    obj->parse(file, objectData.mid(pos, static_cast<unsigned int>(size - 24)));
     objects.append(obj);
-    dataPos += size;
+    pos += static_cast<unsigned int>(size - 24);
   }
 }
 
@@ -414,9 +448,9 @@ ByteVector ASF::File::FilePrivate::CodecListObject::guid() const
   return codecListGuid;
 }
 
-void ASF::File::FilePrivate::CodecListObject::parse(ASF::File *file, long long size)
+void ASF::File::FilePrivate::CodecListObject::parse(ASF::File *file, const ByteVector &objectData)
 {
-  BaseObject::parse(file, size);
+  BaseObject::parse(file, objectData);
   if(data.size() <= 20) {
     debug("ASF::File::FilePrivate::CodecListObject::parse() -- data is too short.");
     return;
@@ -608,7 +642,8 @@ void ASF::File::read()
   if(!isValid())
     return;
 
-  if(readBlock(16) != headerGuid) {
+  const ByteVector prefix = readBlock(30);
+  if(!prefix.startsWith(headerGuid)) {
     debug("ASF::File::read(): Not an ASF file.");
     setValid(false);
     return;
@@ -617,66 +652,73 @@ void ASF::File::read()
   d->tag = std::make_unique<ASF::Tag>();
   d->properties = std::make_unique<ASF::Properties>();
 
+  unsigned int pos = 16;
   bool ok;
-  d->headerSize = readQWORD(this, &ok);
-  if(!ok) {
+  d->headerSize = readQWORD(prefix, pos, &ok);
+  if(!ok || d->headerSize < 30 || d->headerSize > static_cast<unsigned long long>(length())) {
     setValid(false);
     return;
   }
-  int numObjects = readDWORD(this, &ok);
+  int numObjects = readDWORD(prefix, pos, &ok);
   if(!ok) {
     setValid(false);
     return;
   }
-  seek(2, Current);
+
+  // The header object holds all the metadata and is small, so it is read
+  // in one go and its objects are parsed from memory.
+  const ByteVector header = readBlock(static_cast<unsigned long>(d->headerSize - 30));
+  pos = 0;
 
   FilePrivate::FilePropertiesObject   *filePropertiesObject   = nullptr;
   FilePrivate::StreamPropertiesObject *streamPropertiesObject = nullptr;
   for(int i = 0; i < numObjects; i++) {
-    const ByteVector guid = readBlock(16);
-    if(guid.size() != 16) {
+    if(header.size() - pos < 24) {
       setValid(false);
       break;
     }
-    auto size = readQWORD(this, &ok);
-    if(!ok) {
+    const Guid guid(header.data() + pos);
+    pos += 16;
+    const long long size = readQWORD(header, pos);
+    if(size < 24 || size - 24 > header.size() - pos) {
       setValid(false);
       break;
     }
     FilePrivate::BaseObject *obj;
-    if(guid == filePropertiesGuid) {
+    if(guid == filePropertiesId) {
       filePropertiesObject = new FilePrivate::FilePropertiesObject();
       obj = filePropertiesObject;
     }
-    else if(guid == streamPropertiesGuid) {
+    else if(guid == streamPropertiesId) {
       streamPropertiesObject = new FilePrivate::StreamPropertiesObject();
       obj = streamPropertiesObject;
     }
-    else if(guid == contentDescriptionGuid) {
+    else if(guid == contentDescriptionId) {
       d->contentDescriptionObject = new FilePrivate::ContentDescriptionObject();
       obj = d->contentDescriptionObject;
     }
-    else if(guid == extendedContentDescriptionGuid) {
+    else if(guid == extendedContentDescriptionId) {
       d->extendedContentDescriptionObject = new FilePrivate::ExtendedContentDescriptionObject();
       obj = d->extendedContentDescriptionObject;
     }
-    else if(guid == headerExtensionGuid) {
+    else if(guid == headerExtensionId) {
       d->headerExtensionObject = new FilePrivate::HeaderExtensionObject();
       obj = d->headerExtensionObject;
     }
-    else if(guid == codecListGuid) {
+    else if(guid == codecListId) {
       obj = new FilePrivate::CodecListObject();
     }
     else {
-      if(guid == contentEncryptionGuid ||
-         guid == extendedContentEncryptionGuid ||
-         guid == advancedContentEncryptionGuid) {
+      if(guid == contentEncryptionId ||
+         guid == extendedContentEncryptionId ||
+         guid == advancedContentEncryptionId) {
         d->properties->setEncrypted(true);
       }
-      obj = new FilePrivate::UnknownObject(guid);
+      obj = new FilePrivate::UnknownObject(header.mid(pos - 24, 16));
     }
-    obj->parse(this, size);
+    obj->parse(this, header.mid(pos, static_cast<unsigned int>(size - 24)));
     d->objects.append(obj);
+    pos += static_cast<unsigned int>(size - 24);
   }
 
   if(!filePropertiesObject || !streamPropertiesObject) {
@@ -37,53 +37,73 @@ namespace TagLib
     namespace
     {
 
-      inline unsigned short readWORD(File *file, bool *ok = nullptr)
+      // The header object is read into memory in one go and parsed from
+      // there, so these read from data at pos and advance pos past the value.
+
+      inline ByteVector readBlock(const ByteVector &data, unsigned int &pos, unsigned int length)
       {
-        const ByteVector v = file->readBlock(2);
-        if(v.size() != 2) {
+        if(pos >= data.size()) {
+          return ByteVector();
+        }
+        const unsigned int available = data.size() - pos;
+        if(length > available) {
+          length = available;
+        }
+        const ByteVector v = data.mid(pos, length);
+        pos += length;
+        return v;
+      }
+
+      inline unsigned short readWORD(const ByteVector &data, unsigned int &pos, bool *ok = nullptr)
+      {
+        if(pos > data.size() || data.size() - pos < 2) {
+          pos = data.size();
           if(ok) *ok = false;
           return 0;
         }
         if(ok) *ok = true;
-        return v.toUShort(false);
+        const unsigned short value = data.toUShort(pos, false);
+        pos += 2;
+        return value;
       }
 
-      inline unsigned int readDWORD(File *file, bool *ok = nullptr)
+      inline unsigned int readDWORD(const ByteVector &data, unsigned int &pos, bool *ok = nullptr)
       {
-        const ByteVector v = file->readBlock(4);
-        if(v.size() != 4) {
+        if(pos > data.size() || data.size() - pos < 4) {
+          pos = data.size();
           if(ok) *ok = false;
           return 0;
         }
         if(ok) *ok = true;
-        return v.toUInt(false);
+        const unsigned int value = data.toUInt(pos, false);
+        pos += 4;
+        return value;
       }
 
-      inline long long readQWORD(File *file, bool *ok = nullptr)
+      inline long long readQWORD(const ByteVector &data, unsigned int &pos, bool *ok = nullptr)
       {
-        const ByteVector v = file->readBlock(8);
-        if(v.size() != 8) {
+        if(pos > data.size() || data.size() - pos < 8) {
+          pos = data.size();
           if(ok) *ok = false;
           return 0;
         }
         if(ok) *ok = true;
-        return v.toLongLong(false);
+        const long long value = data.toLongLong(pos, false);
+        pos += 8;
+        return value;
       }
 
-      inline String readString(File *file, int length)
+      inline String readString(const ByteVector &data, unsigned int &pos, unsigned int length)
       {
-        ByteVector data = file->readBlock(length);
-        unsigned int size = data.size();
+        const ByteVector v = readBlock(data, pos, length);
+        unsigned int size = v.size();
         while (size >= 2) {
-          if(data[size - 1] != '\0' || data[size - 2] != '\0') {
+          if(v[size - 1] != '\0' || v[size - 2] != '\0') {
             break;
           }
           size -= 2;
         }
-        if(size != data.size()) {
-          data.resize(size);
-        }
-        return String(data, String::UTF16LE);
+        return String(v.mid(0, size), String::UTF16LE);
       }
 
       inline ByteVector renderString(const String &str, bool includeLength = false)
@@ -59,7 +59,11 @@ namespace TagLib {
       //! Read more of the file and make better values guesses
       Average,
       //! Read as much of the file as needed to report accurate values
-      Accurate
+      Accurate,
+      //! Read the tags and only the audio properties given by the stream
+      //! headers; values that would need a scan of the audio stream, such as
+      //! the length of an Ogg stream, are estimated or left at zero
+      TagsOnly
     };
 
     /*!
@@ -32,6 +32,7 @@
 #include "tstringlist.h"
 #include "tpropertymap.h"
 #include "tdebug.h"
+#include "tfilecursor.h"
 #include "id3v2tag.h"
 #include "tagutils.h"
 #include "tagunion.h"
@@ -608,16 +609,21 @@ void DSDIFF::File::updateRootChunksStructure(unsigned int startingChunk)
 void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesStyle)
 {
   bool bigEndian = d->endianness == BigEndian;
+  const offset_t fileLength = length();
 
-  d->type = readBlock(4);
-  d->size = readBlock(8).toLongLong(bigEndian);
-  d->format = readBlock(4);
+  // The chunk tables are parsed from buffered windows of the file.
+
+  FileCursor cursor(this, tell());
+
+  d->type = cursor.readBlock(4);
+  d->size = cursor.readLongLong(bigEndian);
+  d->format = cursor.readBlock(4);
 
   // + 12: chunk header at least, fix for additional junk bytes
 
-  while(tell() + 12 <= length()) {
-    ByteVector chunkName = readBlock(4);
-    unsigned long long chunkSize = readBlock(8).toLongLong(bigEndian);
+  while(cursor.offset() + 12 <= fileLength) {
+    ByteVector chunkName = cursor.readBlock(4);
+    unsigned long long chunkSize = cursor.readLongLong(bigEndian);
 
     if(!isValidChunkID(chunkName)) {
       debug("DSDIFF::File::read() -- Chunk '" + chunkName + "' has invalid ID");
@@ -625,8 +631,8 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
       break;
     }
 
-    if(static_cast<unsigned long long>(tell()) + chunkSize >
-       static_cast<unsigned long long>(length())) {
+    if(static_cast<unsigned long long>(cursor.offset()) + chunkSize >
+       static_cast<unsigned long long>(fileLength)) {
       debug("DSDIFF::File::read() -- Chunk '" + chunkName
             + "' has invalid size (larger than the file size)");
       setValid(false);
@@ -636,18 +642,18 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
     Chunk64 chunk;
     chunk.name = chunkName;
     chunk.size = chunkSize;
-    chunk.offset = tell();
+    chunk.offset = cursor.offset();
 
-    seek(chunk.size, Current);
+    cursor.seek(cursor.offset() + chunk.size);
 
     // Check padding
 
     chunk.padding = 0;
-    if(offset_t uPosNotPadded = tell(); (uPosNotPadded & 0x01) != 0) {
-      if(ByteVector iByte = readBlock(1);
+    if(offset_t uPosNotPadded = cursor.offset(); (uPosNotPadded & 0x01) != 0) {
+      if(ByteVector iByte = cursor.readBlock(1);
          iByte.size() != 1 || iByte[0] != 0)
         // Not well formed, re-seek
-        seek(uPosNotPadded, Beginning);
+        cursor.seek(uPosNotPadded);
       else
         chunk.padding = 1;
     }
@@ -671,13 +677,13 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
     else if(d->chunks[i].name == "DST ") {
       // Now decode the chunks inside the DST chunk to read the DST Frame Information one
       long long dstChunkEnd = d->chunks[i].offset + d->chunks[i].size;
-      seek(d->chunks[i].offset);
+      cursor.seek(d->chunks[i].offset);
 
       audioDataSizeinBytes = d->chunks[i].size;
 
-      while(tell() + 12 <= dstChunkEnd) {
-        ByteVector dstChunkName = readBlock(4);
-        long long dstChunkSize = readBlock(8).toLongLong(bigEndian);
+      while(cursor.offset() + 12 <= dstChunkEnd) {
+        ByteVector dstChunkName = cursor.readBlock(4);
+        long long dstChunkSize = cursor.readLongLong(bigEndian);
 
         if(!isValidChunkID(dstChunkName)) {
           debug("DSDIFF::File::read() -- DST Chunk '" + dstChunkName + "' has invalid ID");
@@ -685,7 +691,7 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
           break;
         }
 
-        if(static_cast<long long>(tell()) + dstChunkSize > dstChunkEnd) {
+        if(static_cast<long long>(cursor.offset()) + dstChunkSize > dstChunkEnd) {
           debug("DSDIFF::File::read() -- DST Chunk '" + dstChunkName
                 + "' has invalid size (larger than the DST chunk)");
           setValid(false);
@@ -694,20 +700,20 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
 
         if(dstChunkName == "FRTE") {
           // Found the DST frame information chunk
-          dstNumFrames = readBlock(4).toUInt(bigEndian);
-          dstFrameRate = readBlock(2).toUShort(bigEndian);
+          dstNumFrames = cursor.readUInt(bigEndian);
+          dstFrameRate = cursor.readUShort(bigEndian);
           // Found the wanted one, no need to look at the others
           break;
         }
 
-        seek(dstChunkSize, Current);
+        cursor.seek(cursor.offset() + dstChunkSize);
 
         // Check padding
-        if(offset_t uPosNotPadded = tell(); (uPosNotPadded & 0x01) != 0) {
-          if(ByteVector iByte = readBlock(1);
+        if(offset_t uPosNotPadded = cursor.offset(); (uPosNotPadded & 0x01) != 0) {
+          if(ByteVector iByte = cursor.readBlock(1);
              iByte.size() != 1 || iByte[0] != 0)
             // Not well formed, re-seek
-            seek(uPosNotPadded, Beginning);
+            cursor.seek(uPosNotPadded);
         }
       }
     }
@@ -716,10 +722,10 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
       // Now decodes the chunks inside the PROP chunk
       long long propChunkEnd = d->chunks[i].offset + d->chunks[i].size;
       // +4 to remove the 'SND ' marker at beginning of 'PROP' chunk
-      seek(d->chunks[i].offset + 4);
-      while(tell() + 12 <= propChunkEnd) {
-        ByteVector propChunkName = readBlock(4);
-        long long propChunkSize = readBlock(8).toLongLong(bigEndian);
+      cursor.seek(d->chunks[i].offset + 4);
+      while(cursor.offset() + 12 <= propChunkEnd) {
+        ByteVector propChunkName = cursor.readBlock(4);
+        long long propChunkSize = cursor.readLongLong(bigEndian);
 
         if(!isValidChunkID(propChunkName)) {
           debug("DSDIFF::File::read() -- PROP Chunk '" + propChunkName + "' has invalid ID");
@@ -727,7 +733,7 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
           break;
         }
 
-        if(static_cast<long long>(tell()) + propChunkSize > propChunkEnd) {
+        if(static_cast<long long>(cursor.offset()) + propChunkSize > propChunkEnd) {
           debug("DSDIFF::File::read() -- PROP Chunk '" + propChunkName
                 + "' has invalid size (larger than the PROP chunk)");
           setValid(false);
@@ -737,17 +743,17 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
         Chunk64 chunk;
         chunk.name = propChunkName;
         chunk.size = propChunkSize;
-        chunk.offset = tell();
+        chunk.offset = cursor.offset();
 
-        seek(chunk.size, Current);
+        cursor.seek(cursor.offset() + chunk.size);
 
         // Check padding
         chunk.padding = 0;
-        if(offset_t uPosNotPadded = tell(); (uPosNotPadded & 0x01) != 0) {
-          if(ByteVector iByte = readBlock(1);
+        if(offset_t uPosNotPadded = cursor.offset(); (uPosNotPadded & 0x01) != 0) {
+          if(ByteVector iByte = cursor.readBlock(1);
              iByte.size() != 1 || iByte[0] != 0)
             // Not well formed, re-seek
-            seek(uPosNotPadded, Beginning);
+            cursor.seek(uPosNotPadded);
           else
             chunk.padding = 1;
         }
@@ -761,11 +767,11 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
       // Now decode the chunks inside the DIIN chunk
 
       long long diinChunkEnd = d->chunks[i].offset + d->chunks[i].size;
-      seek(d->chunks[i].offset);
+      cursor.seek(d->chunks[i].offset);
 
-      while(tell() + 12 <= diinChunkEnd) {
-        ByteVector diinChunkName = readBlock(4);
-        long long diinChunkSize = readBlock(8).toLongLong(bigEndian);
+      while(cursor.offset() + 12 <= diinChunkEnd) {
+        ByteVector diinChunkName = cursor.readBlock(4);
+        long long diinChunkSize = cursor.readLongLong(bigEndian);
 
         if(!isValidChunkID(diinChunkName)) {
           debug("DSDIFF::File::read() -- DIIN Chunk '" + diinChunkName + "' has invalid ID");
@@ -773,7 +779,7 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
           break;
         }
 
-        if(static_cast<long long>(tell()) + diinChunkSize > diinChunkEnd) {
+        if(static_cast<long long>(cursor.offset()) + diinChunkSize > diinChunkEnd) {
           debug("DSDIFF::File::read() -- DIIN Chunk '" + diinChunkName
                 + "' has invalid size (larger than the DIIN chunk)");
           setValid(false);
@@ -783,19 +789,19 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
         Chunk64 chunk;
         chunk.name = diinChunkName;
         chunk.size = diinChunkSize;
-        chunk.offset = tell();
+        chunk.offset = cursor.offset();
 
-        seek(chunk.size, Current);
+        cursor.seek(cursor.offset() + chunk.size);
 
         // Check padding
 
         chunk.padding = 0;
 
-        if(offset_t uPosNotPadded = tell(); (uPosNotPadded & 0x01) != 0) {
-          if(ByteVector iByte = readBlock(1);
+        if(offset_t uPosNotPadded = cursor.offset(); (uPosNotPadded & 0x01) != 0) {
+          if(ByteVector iByte = cursor.readBlock(1);
              iByte.size() != 1 || iByte[0] != 0)
             // Not well formed, re-seek
-            seek(uPosNotPadded, Beginning);
+            cursor.seek(uPosNotPadded);
           else
             chunk.padding = 1;
         }
@@ -841,13 +847,13 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
     }
     else if(d->childChunks[PROPChunk][i].name == "FS  ") {
       // Sample rate
-      seek(d->childChunks[PROPChunk][i].offset);
-      sampleRate = readBlock(4).toUInt(0, 4, bigEndian);
+      cursor.seek(d->childChunks[PROPChunk][i].offset);
+      sampleRate = cursor.readUInt(bigEndian);
     }
     else if(d->childChunks[PROPChunk][i].name == "CHNL") {
       // Channels
-      seek(d->childChunks[PROPChunk][i].offset);
-      channels = readBlock(2).toShort(0, bigEndian);
+      cursor.seek(d->childChunks[PROPChunk][i].offset);
+      channels = cursor.readUShort(bigEndian);
     }
   }
 
@@ -858,18 +864,18 @@ void DSDIFF::File::read(bool readProperties, Properties::ReadStyle propertiesSty
   if(d->hasDiin) {
     for(unsigned int i = 0; i < d->childChunks[DIINChunk].size(); i++) {
       if(d->childChunks[DIINChunk][i].name == "DITI") {
-        seek(d->childChunks[DIINChunk][i].offset);
-        if(unsigned int titleStrLength = readBlock(4).toUInt(0, 4, bigEndian);
+        cursor.seek(d->childChunks[DIINChunk][i].offset);
+        if(unsigned int titleStrLength = cursor.readUInt(bigEndian);
            titleStrLength <= d->childChunks[DIINChunk][i].size) {
-          ByteVector titleStr = readBlock(titleStrLength);
+          ByteVector titleStr = cursor.readBlock(titleStrLength);
           d->tag.access<DSDIFF::DIIN::Tag>(DIINIndex, false)->setTitle(titleStr);
         }
       }
       else if(d->childChunks[DIINChunk][i].name == "DIAR") {
-        seek(d->childChunks[DIINChunk][i].offset);
-        if(unsigned int artistStrLength = readBlock(4).toUInt(0, 4, bigEndian);
+        cursor.seek(d->childChunks[DIINChunk][i].offset);
+        if(unsigned int artistStrLength = cursor.readUInt(bigEndian);
            artistStrLength <= d->childChunks[DIINChunk][i].size) {
-          ByteVector artistStr = readBlock(artistStrLength);
+          ByteVector artistStr = cursor.readBlock(artistStrLength);
           d->tag.access<DSDIFF::DIIN::Tag>(DIINIndex, false)->setArtist(artistStr);
         }
       }
@@ -29,7 +29,13 @@
 
 #include "fileref.h"
 
+#include <algorithm>
 #include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "taglib_config.h"
@@ -90,7 +96,20 @@ class FileRef::StreamTypeResolver::StreamTypeResolverPrivate
 
 namespace
 {
-  List<const FileRef::FileTypeResolver *> fileTypeResolvers;
+  using ResolverList = List<const FileRef::FileTypeResolver *>;
+
+  // The registered resolvers.  A published list is never modified, adding or
+  // clearing resolvers replaces it, so a FileRef being constructed only holds
+  // the lock while it takes a reference to the current list.
+
+  std::mutex fileTypeResolversMutex;
+  std::shared_ptr<const ResolverList> fileTypeResolvers;
+
+  std::shared_ptr<const ResolverList> currentFileTypeResolvers()
+  {
+    std::lock_guard<std::mutex> lock(fileTypeResolversMutex);
+    return fileTypeResolvers;
+  }
 
   // Detect the file type by user-defined resolvers.
 
@@ -104,7 +123,11 @@ namespace
     if(::strlen(fileName) == 0)
       return nullptr;
 #endif
-    for(const auto &resolver : std::as_const(fileTypeResolvers)) {
+    const auto resolvers = currentFileTypeResolvers();
+    if(!resolvers)
+      return nullptr;
+
+    for(const auto &resolver : *resolvers) {
       File *file = resolver->createFile(fileName, readAudioProperties, audioPropertiesStyle);
       if(file)
         return file;
@@ -116,7 +139,11 @@ namespace
   File *detectByResolvers(IOStream* stream, bool readAudioProperties,
                           AudioProperties::ReadStyle audioPropertiesStyle)
   {
-    for(const auto &resolver : std::as_const(fileTypeResolvers)) {
+    const auto resolvers = currentFileTypeResolvers();
+    if(!resolvers)
+      return nullptr;
+
+    for(const auto &resolver : *resolvers) {
       if(auto streamResolver = dynamic_cast<const FileRef::StreamTypeResolver *>(resolver)) {
         if(File *file = streamResolver->createFileFromStream(
              stream, readAudioProperties, audioPropertiesStyle))
@@ -127,176 +154,334 @@ namespace
     return nullptr;
   }
 
-  // Detect the file type based on the file extension.
+  using FileFactory = File *(*)(IOStream *, bool, AudioProperties::ReadStyle);
 
-  File* detectByExtension(IOStream *stream, bool readAudioProperties,
-                          AudioProperties::ReadStyle audioPropertiesStyle)
+  template <class T>
+  File *createFile(IOStream *stream, bool readAudioProperties,
+                   AudioProperties::ReadStyle audioPropertiesStyle)
   {
-#ifdef _WIN32
-    const String s = stream->name().toString();
-#else
-    const String s(stream->name());
-#endif
-
-    String ext;
-    if(const int pos = s.rfind("."); pos != -1)
-      ext = s.substr(pos + 1).upper();
+    return new T(stream, readAudioProperties, audioPropertiesStyle);
+  }
 
-    // If this list is updated, the method defaultFileExtensions() should also be
-    // updated.  However at some point that list should be created at the same time
-    // that a default file type resolver is created.
+#ifdef TAGLIB_WITH_VORBIS
+  // .oga can be any audio in the Ogg container. First try FLAC, then Vorbis.
 
-    if(ext.isEmpty())
-      return nullptr;
+  File *createOggAudioFile(IOStream *stream, bool readAudioProperties,
+                           AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+    File *file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
+    if(!file->isValid()) {
+      delete file;
+      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
+    }
+    return file;
+  }
+#endif
 
-    // .oga can be any audio in the Ogg container. So leave it to content-based detection.
+  struct ExtensionFactory
+  {
+    const char *extension;
+    FileFactory factory;
+  };
 
-    File *file = nullptr;
+  // The supported extensions in the order of defaultFileExtensions().
 
-    if(ext == "MP3" || ext == "MP2" || ext == "AAC")
-      file = new MPEG::File(stream, readAudioProperties, audioPropertiesStyle);
+  constexpr ExtensionFactory extensionFactories[] = {
+    { "mp3",    &createFile<MPEG::File> },
+    { "mp2",    &createFile<MPEG::File> },
+    { "aac",    &createFile<MPEG::File> },
 #ifdef TAGLIB_WITH_VORBIS
-    else if(ext == "OGG")
-      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "OGA") {
-      /* .oga can be any audio in the Ogg container. First try FLAC, then Vorbis. */
-      file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-      if(!file->isValid()) {
-        delete file;
-        file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-      }
-    }
-    else if(ext == "FLAC")
-      file = new FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "SPX")
-      file = new Ogg::Speex::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "OPUS")
-      file = new Ogg::Opus::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "ogg",    &createFile<Ogg::Vorbis::File> },
+    { "flac",   &createFile<FLAC::File> },
+    { "oga",    &createOggAudioFile },
+    { "opus",   &createFile<Ogg::Opus::File> },
+    { "spx",    &createFile<Ogg::Speex::File> },
 #endif
 #ifdef TAGLIB_WITH_APE
-    else if(ext == "MPC")
-      file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "WV")
-      file = new WavPack::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "APE")
-      file = new APE::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "mpc",    &createFile<MPC::File> },
+    { "wv",     &createFile<WavPack::File> },
+    { "ape",    &createFile<APE::File> },
 #endif
 #ifdef TAGLIB_WITH_TRUEAUDIO
-    else if(ext == "TTA")
-      file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "tta",    &createFile<TrueAudio::File> },
 #endif
 #ifdef TAGLIB_WITH_MP4
-    else if(ext == "M4A" || ext == "M4R" || ext == "M4B" || ext == "M4P" || ext == "MP4" || ext == "3G2" || ext == "M4V")
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "m4a",    &createFile<MP4::File> },
+    { "m4r",    &createFile<MP4::File> },
+    { "m4b",    &createFile<MP4::File> },
+    { "m4p",    &createFile<MP4::File> },
+    { "3g2",    &createFile<MP4::File> },
+    { "mp4",    &createFile<MP4::File> },
+    { "m4v",    &createFile<MP4::File> },
 #endif
 #ifdef TAGLIB_WITH_ASF
-    else if(ext == "WMA" || ext == "ASF")
-      file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "wma",    &createFile<ASF::File> },
+    { "asf",    &createFile<ASF::File> },
 #endif
 #ifdef TAGLIB_WITH_RIFF
-    else if(ext == "AIF" || ext == "AIFF" || ext == "AFC" || ext == "AIFC")
-      file = new RIFF::AIFF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "WAV")
-      file = new RIFF::WAV::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "aif",    &createFile<RIFF::AIFF::File> },
+    { "aiff",   &createFile<RIFF::AIFF::File> },
+    { "afc",    &createFile<RIFF::AIFF::File> },
+    { "aifc",   &createFile<RIFF::AIFF::File> },
+    { "wav",    &createFile<RIFF::WAV::File> },
 #endif
 #ifdef TAGLIB_WITH_MOD
-    // module, nst and wow are possible but uncommon extensions
-    else if(ext == "MOD" || ext == "MODULE" || ext == "NST" || ext == "WOW")
-      file = new Mod::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "S3M")
-      file = new S3M::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "IT")
-      file = new IT::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "XM")
-      file = new XM::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "mod",    &createFile<Mod::File> },
+    { "module", &createFile<Mod::File> },  // alias for "mod"
+    { "nst",    &createFile<Mod::File> },  // alias for "mod"
+    { "wow",    &createFile<Mod::File> },  // alias for "mod"
+    { "s3m",    &createFile<S3M::File> },
+    { "it",     &createFile<IT::File> },
+    { "xm",     &createFile<XM::File> },
 #endif
 #ifdef TAGLIB_WITH_DSF
-    else if(ext == "DSF")
-      file = new DSF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "DFF" || ext == "DSDIFF")
-      file = new DSDIFF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "dsf",    &createFile<DSF::File> },
+    { "dff",    &createFile<DSDIFF::File> },
+    { "dsdiff", &createFile<DSDIFF::File> },  // alias for "dff"
 #endif
 #ifdef TAGLIB_WITH_SHORTEN
-    else if(ext == "SHN")
-      file = new Shorten::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "shn",    &createFile<Shorten::File> },
 #endif
+  };
 
-    // if file is not valid, leave it to content-based detection.
+  FileFactory findExtensionFactory(const std::string &extension)
+  {
+    static const std::unordered_map<std::string, FileFactory> factories = [] {
+      std::unordered_map<std::string, FileFactory> map;
+      for(const auto &[ext, factory] : extensionFactories)
+        map.emplace(ext, factory);
+      return map;
+    }();
+
+    const auto it = factories.find(extension);
+    return it != factories.end() ? it->second : nullptr;
+  }
 
-    if(file) {
-      if(file->isValid())
-        return file;
-      delete file;
+  // Detect the file type based on the file extension.
+
+  File* detectByExtension(IOStream *stream, bool readAudioProperties,
+                          AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+#ifdef _WIN32
+    const String s = stream->name().toString();
+#else
+    const String s(stream->name());
+#endif
+
+    const int pos = s.rfind(".");
+    if(pos == -1)
+      return nullptr;
+
+    // All known extensions are ASCII, so anything else can be rejected
+    // while lowering the case.
+
+    std::string ext;
+    for(auto it = s.begin() + pos + 1; it != s.end(); ++it) {
+      if(*it >= 0x80)
+        return nullptr;
+      ext += static_cast<char>(*it >= 'A' && *it <= 'Z' ? *it + ('a' - 'A') : *it);
     }
 
+    const FileFactory factory = findExtensionFactory(ext);
+    if(!factory)
+      return nullptr;
+
+    // if file is not valid, leave it to content-based detection.
+
+    File *file = factory(stream, readAudioProperties, audioPropertiesStyle);
+    if(file->isValid())
+      return file;
+    delete file;
+
     return nullptr;
   }
 
+  // Serves the reads of the isSupported() checks from memory.  They all look
+  // at the start of the stream or right behind an ID3v2 tag, so a window
+  // read there once answers all of them instead of each format reading its
+  // own header.
+
+  class HeaderProbe : public IOStream
+  {
+  public:
+    static constexpr unsigned int WindowSize = 16 * 1024;
+
+    explicit HeaderProbe(IOStream *stream) :
+      stream(stream),
+      originalPosition(stream->tell())
+    {
+    }
+
+    ~HeaderProbe() override
+    {
+      stream->seek(originalPosition);
+    }
+
+    HeaderProbe(const HeaderProbe &) = delete;
+    HeaderProbe &operator=(const HeaderProbe &) = delete;
+
+    FileName name() const override
+    {
+      return stream->name();
+    }
+
+    ByteVector readBlock(size_t length) override
+    {
+      ByteVector data;
+      while(length > 0) {
+        const ByteVector *window = windowAt(position);
+        if(!window)
+          break;
+        const unsigned int index = static_cast<unsigned int>(position - windowStart);
+        const unsigned int count = std::min<size_t>(length, window->size() - index);
+        data.append(window->mid(index, count));
+        position += count;
+        length -= count;
+      }
+      return data;
+    }
+
+    void writeBlock(const ByteVector &) override {}
+    void insert(const ByteVector &, offset_t, size_t) override {}
+    void removeBlock(offset_t, size_t) override {}
+    void truncate(offset_t) override {}
+
+    bool readOnly() const override
+    {
+      return true;
+    }
+
+    bool isOpen() const override
+    {
+      return stream->isOpen();
+    }
+
+    void seek(offset_t offset, Position p = Beginning) override
+    {
+      if(p == Current)
+        offset += position;
+      else if(p == End)
+        offset += length();
+      if(offset >= 0)
+        position = offset;
+    }
+
+    offset_t tell() const override
+    {
+      return position;
+    }
+
+    offset_t length() override
+    {
+      if(streamLength < 0)
+        streamLength = stream->length();
+      return streamLength;
+    }
+
+  private:
+    // Returns the window holding offset, reading a new one if needed, or
+    // nullptr if offset is at or past the end of the stream.
+    const ByteVector *windowAt(offset_t offset)
+    {
+      for(const auto &[start, data] : windows) {
+        if(offset >= start && offset < start + data.size()) {
+          windowStart = start;
+          return &data;
+        }
+      }
+
+      if(offset >= length())
+        return nullptr;
+
+      stream->seek(offset);
+      ByteVector data = stream->readBlock(WindowSize);
+      if(data.isEmpty())
+        return nullptr;
+
+      windows.emplace_back(offset, std::move(data));
+      windowStart = offset;
+      return &windows.back().second;
+    }
+
+    IOStream *const stream;
+    const offset_t originalPosition;
+    std::list<std::pair<offset_t, ByteVector>> windows;
+    offset_t windowStart { 0 };
+    offset_t position { 0 };
+    offset_t streamLength { -1 };
+  };
+
   // Detect the file type based on the actual content of the stream.
 
   File *detectByContent(IOStream *stream, bool readAudioProperties,
                         AudioProperties::ReadStyle audioPropertiesStyle)
   {
-    File *file = nullptr;
+    FileFactory factory = nullptr;
 
-    if(MPEG::File::isSupported(stream))
-      file = new MPEG::File(stream, readAudioProperties, audioPropertiesStyle);
+    {
+      HeaderProbe probe(stream);
+
+      if(MPEG::File::isSupported(&probe))
+        factory = &createFile<MPEG::File>;
 #ifdef TAGLIB_WITH_VORBIS
-    else if(Ogg::Vorbis::File::isSupported(stream))
-      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::FLAC::File::isSupported(stream))
-      file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(FLAC::File::isSupported(stream))
-      file = new FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::Speex::File::isSupported(stream))
-      file = new Ogg::Speex::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::Opus::File::isSupported(stream))
-      file = new Ogg::Opus::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(Ogg::Vorbis::File::isSupported(&probe))
+        factory = &createFile<Ogg::Vorbis::File>;
+      else if(Ogg::FLAC::File::isSupported(&probe))
+        factory = &createFile<Ogg::FLAC::File>;
+      else if(FLAC::File::isSupported(&probe))
+        factory = &createFile<FLAC::File>;
+      else if(Ogg::Speex::File::isSupported(&probe))
+        factory = &createFile<Ogg::Speex::File>;
+      else if(Ogg::Opus::File::isSupported(&probe))
+        factory = &createFile<Ogg::Opus::File>;
 #endif
 #ifdef TAGLIB_WITH_APE
-    else if(MPC::File::isSupported(stream))
-      file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(WavPack::File::isSupported(stream))
-      file = new WavPack::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(APE::File::isSupported(stream))
-      file = new APE::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(MPC::File::isSupported(&probe))
+        factory = &createFile<MPC::File>;
+      else if(WavPack::File::isSupported(&probe))
+        factory = &createFile<WavPack::File>;
+      else if(APE::File::isSupported(&probe))
+        factory = &createFile<APE::File>;
 #endif
 #ifdef TAGLIB_WITH_TRUEAUDIO
-    else if(TrueAudio::File::isSupported(stream))
-      file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(TrueAudio::File::isSupported(&probe))
+        factory = &createFile<TrueAudio::File>;
 #endif
 #ifdef TAGLIB_WITH_MP4
-    else if(MP4::File::isSupported(stream))
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(MP4::File::isSupported(&probe))
+        factory = &createFile<MP4::File>;
 #endif
 #ifdef TAGLIB_WITH_ASF
-    else if(ASF::File::isSupported(stream))
-      file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(ASF::File::isSupported(&probe))
+        factory = &createFile<ASF::File>;
 #endif
 #ifdef TAGLIB_WITH_RIFF
-    else if(RIFF::AIFF::File::isSupported(stream))
-      file = new RIFF::AIFF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(RIFF::WAV::File::isSupported(stream))
-      file = new RIFF::WAV::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(RIFF::AIFF::File::isSupported(&probe))
+        factory = &createFile<RIFF::AIFF::File>;
+      else if(RIFF::WAV::File::isSupported(&probe))
+        factory = &createFile<RIFF::WAV::File>;
 #endif
 #ifdef TAGLIB_WITH_DSF
-    else if(DSF::File::isSupported(stream))
-      file = new DSF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(DSDIFF::File::isSupported(stream))
-      file = new DSDIFF::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(DSF::File::isSupported(&probe))
+        factory = &createFile<DSF::File>;
+      else if(DSDIFF::File::isSupported(&probe))
+        factory = &createFile<DSDIFF::File>;
 #endif
 #ifdef TAGLIB_WITH_SHORTEN
-    else if(Shorten::File::isSupported(stream))
-      file = new Shorten::File(stream, readAudioProperties, audioPropertiesStyle);
+      else if(Shorten::File::isSupported(&probe))
+        factory = &createFile<Shorten::File>;
 #endif
+    }
+
+    if(!factory)
+      return nullptr;
 
     // isSupported() only does a quick check, so double check the file here.
 
-    if(file) {
-      if(file->isValid())
-        return file;
-      delete file;
-    }
+    File *file = factory(stream, readAudioProperties, audioPropertiesStyle);
+    if(file->isValid())
+      return file;
+    delete file;
 
     return nullptr;
   }
@@ -445,74 +630,29 @@ bool FileRef::save()
 
 const FileRef::FileTypeResolver *FileRef::addFileTypeResolver(const FileRef::FileTypeResolver *resolver) // static
 {
-  fileTypeResolvers.prepend(resolver);
+  std::lock_guard<std::mutex> lock(fileTypeResolversMutex);
+
+  ResolverList resolvers;
+  resolvers.append(resolver);
+  if(fileTypeResolvers)
+    resolvers.append(*fileTypeResolvers);
+
+  fileTypeResolvers = std::make_shared<const ResolverList>(resolvers);
   return resolver;
 }
 
 void FileRef::clearFileTypeResolvers() // static
 {
-  fileTypeResolvers.clear();
+  std::lock_guard<std::mutex> lock(fileTypeResolversMutex);
+  fileTypeResolvers.reset();
 }
 
 StringList FileRef::defaultFileExtensions()
 {
   StringList l;
 
-  l.append("mp3");
-  l.append("mp2");
-  l.append("aac");
-#ifdef TAGLIB_WITH_VORBIS
-  l.append("ogg");
-  l.append("flac");
-  l.append("oga");
-  l.append("opus");
-  l.append("spx");
-#endif
-#ifdef TAGLIB_WITH_APE
-  l.append("mpc");
-  l.append("wv");
-  l.append("ape");
-#endif
-#ifdef TAGLIB_WITH_TRUEAUDIO
-  l.append("tta");
-#endif
-#ifdef TAGLIB_WITH_MP4
-  l.append("m4a");
-  l.append("m4r");
-  l.append("m4b");
-  l.append("m4p");
-  l.append("3g2");
-  l.append("mp4");
-  l.append("m4v");
-#endif
-#ifdef TAGLIB_WITH_ASF
-  l.append("wma");
-  l.append("asf");
-#endif
-#ifdef TAGLIB_WITH_RIFF
-  l.append("aif");
-  l.append("aiff");
-  l.append("afc");
-  l.append("aifc");
-  l.append("wav");
-#endif
-#ifdef TAGLIB_WITH_MOD
-  l.append("mod");
-  l.append("module"); // alias for "mod"
-  l.append("nst"); // alias for "mod"
-  l.append("wow"); // alias for "mod"
-  l.append("s3m");
-  l.append("it");
-  l.append("xm");
-#endif
-#ifdef TAGLIB_WITH_DSF
-  l.append("dsf");
-  l.append("dff");
-  l.append("dsdiff"); // alias for "dff"
-#endif
-#ifdef TAGLIB_WITH_SHORTEN
-  l.append("shn");
-#endif
+  for(const auto &entry : extensionFactories)
+    l.append(entry.extension);
 
   return l;
 }
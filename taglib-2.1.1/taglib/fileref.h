@@ -52,6 +52,14 @@ namespace TagLib {
    * type system rather than using the constructor that accepts a file name using
    * the FileTypeResolver.
    *
+   * FileRef objects for distinct files can be created, read and saved from
+   * several threads at the same time.  A single FileRef, like the File it
+   * wraps, must not be used from more than one thread at once.  The global
+   * settings (file type resolvers, string handlers, the default text encoding
+   * of ID3v2::FrameFactory::instance() and the debug listener) can be changed
+   * while other threads are working; files opened after the change use the
+   * new setting.
+   *
    * \see FileTypeResolver
    * \see addFileTypeResolver()
    */
@@ -350,6 +358,10 @@ namespace TagLib {
      * this is mostly so that static initializers have something to use for
      * assignment).
      *
+     * \note A FileRef uses the resolvers registered at the time it is
+     * constructed.  Resolvers may be called from several threads at once and
+     * must stay alive as long as any thread may construct a FileRef.
+     *
      * \see FileTypeResolver
      */
     static const FileTypeResolver *addFileTypeResolver(const FileTypeResolver *resolver);
@@ -49,6 +49,46 @@ namespace
   constexpr long MaxPaddingLegnth = 1024 * 1024;
 
   constexpr char LastBlockFlag = '\x80';
+
+  // The metadata is read in blocks of this size.  Usually one or two of them
+  // cover all the block headers.
+  constexpr unsigned int ScanBufferSize = 64 * 1024;
+
+  // A metadata block whose data stays in the file until it is rendered.  This
+  // is used for large blocks like seek tables, which are only needed on save.
+  class LazyMetadataBlock : public FLAC::MetadataBlock
+  {
+  public:
+    LazyMetadataBlock(int code, TagLib::File *file, offset_t offset, unsigned int length) :
+      blockCode(code),
+      file(file),
+      offset(offset),
+      length(length)
+    {
+    }
+
+    int code() const override
+    {
+      return blockCode;
+    }
+
+    ByteVector render() const override
+    {
+      if(file) {
+        file->seek(offset);
+        data = file->readBlock(length);
+        file = nullptr;
+      }
+      return data;
+    }
+
+  private:
+    int blockCode;
+    mutable TagLib::File *file;
+    offset_t offset;
+    unsigned int length;
+    mutable ByteVector data;
+  };
 }  // namespace
 
 class FLAC::File::FilePrivate
@@ -416,8 +456,12 @@ void FLAC::File::removePicture(Picture *picture, bool del)
   if(it != d->blocks.end())
     d->blocks.erase(it);
 
+  // The picture may outlive the file, so it must not read from it anymore.
+
   if(del)
     delete picture;
+  else
+    picture->loadData();
 }
 
 void FLAC::File::removePictures()
@@ -523,32 +567,52 @@ void FLAC::File::scan()
   if(!isValid())
     return;
 
-  offset_t nextBlockOffset;
+  // The stream marker is normally right after the ID3v2 tag, if any.  Then
+  // the first read covers it and the metadata blocks following it.
 
-  if(d->ID3v2Location >= 0)
-    nextBlockOffset = find("fLaC", d->ID3v2Location + d->ID3v2OriginalSize);
-  else
-    nextBlockOffset = find("fLaC");
+  offset_t nextBlockOffset = d->ID3v2Location >= 0 ? d->ID3v2Location + d->ID3v2OriginalSize : 0;
 
-  if(nextBlockOffset < 0) {
-    debug("FLAC::File::scan() -- FLAC stream not found");
-    setValid(false);
-    return;
+  seek(nextBlockOffset);
+  ByteVector buffer = readBlock(ScanBufferSize);
+  offset_t bufferOffset = nextBlockOffset;
+
+  if(!buffer.startsWith("fLaC")) {
+    nextBlockOffset = find("fLaC", nextBlockOffset);
+    if(nextBlockOffset < 0) {
+      debug("FLAC::File::scan() -- FLAC stream not found");
+      setValid(false);
+      return;
+    }
+
+    seek(nextBlockOffset);
+    buffer = readBlock(ScanBufferSize);
+    bufferOffset = nextBlockOffset;
   }
 
   nextBlockOffset += 4;
   d->flacStart = nextBlockOffset;
 
+  const offset_t fileLength = length();
+
   while(true) {
 
-    seek(nextBlockOffset);
-    const ByteVector header = readBlock(4);
-    if(header.size() != 4) {
+    // Read the next part of the metadata if the block header is not buffered.
+
+    if(nextBlockOffset + 4 > bufferOffset + buffer.size()) {
+      seek(nextBlockOffset);
+      buffer = readBlock(ScanBufferSize);
+      bufferOffset = nextBlockOffset;
+    }
+
+    const auto headerPos = static_cast<unsigned int>(nextBlockOffset - bufferOffset);
+    if(headerPos + 4 > buffer.size()) {
       debug("FLAC::File::scan() -- Failed to read a block header");
       setValid(false);
       return;
     }
 
+    const ByteVector header = buffer.mid(headerPos, 4);
+
     // Header format (from spec):
     // <1> Last-metadata-block flag
     // <7> BLOCK_TYPE
@@ -581,13 +645,27 @@ void FLAC::File::scan()
       return;
     }
 
-    const ByteVector data = readBlock(blockLength);
-    if(data.size() != blockLength) {
+    const offset_t dataOffset = nextBlockOffset + 4;
+    if(dataOffset + blockLength > fileLength) {
       debug("FLAC::File::scan() -- Failed to read a metadata block");
       setValid(false);
       return;
     }
 
+    // Blocks reaching beyond the buffer are only partially available here.
+    // Pictures and seek tables leave their payload in the file, other blocks
+    // are read completely.
+
+    const unsigned int bufferedLength = std::min(blockLength, buffer.size() - headerPos - 4);
+    const bool isComplete = bufferedLength == blockLength;
+    ByteVector data = buffer.mid(headerPos + 4, bufferedLength);
+
+    if(!isComplete && blockType != MetadataBlock::Padding &&
+       blockType != MetadataBlock::Picture && blockType != MetadataBlock::SeekTable) {
+      seek(dataOffset);
+      data = readBlock(blockLength);
+    }
+
     MetadataBlock *block = nullptr;
 
     // Found the vorbis-comment
@@ -602,7 +680,16 @@ void FLAC::File::scan()
     }
     else if(blockType == MetadataBlock::Picture) {
       auto picture = new FLAC::Picture();
-      if(picture->parse(data)) {
+      bool parsed = isComplete ? picture->parse(data) : picture->parse(data, this, dataOffset, blockLength);
+
+      // The picture header itself did not fit into the buffer.
+
+      if(!parsed && !isComplete) {
+        seek(dataOffset);
+        parsed = picture->parse(readBlock(blockLength));
+      }
+
+      if(parsed) {
         block = picture;
       }
       else {
@@ -613,6 +700,9 @@ void FLAC::File::scan()
     else if(blockType == MetadataBlock::Padding) {
       // Skip all padding blocks.
     }
+    else if(!isComplete) {
+      block = new LazyMetadataBlock(blockType, this, dataOffset, blockLength);
+    }
     else {
       block = new UnknownMetadataBlock(blockType, data);
     }
@@ -26,6 +26,7 @@
 #include "flacpicture.h"
 
 #include "tdebug.h"
+#include "tfile.h"
 
 using namespace TagLib;
 
@@ -40,6 +41,11 @@ public:
   int colorDepth { 0 };
   int numColors { 0 };
   ByteVector data;
+
+  // Location of image data which has not been read yet
+  TagLib::File *file { nullptr };
+  offset_t dataOffset { -1 };
+  unsigned int dataLength { 0 };
 };
 
 FLAC::Picture::Picture() :
@@ -61,6 +67,12 @@ int FLAC::Picture::code() const
 }
 
 bool FLAC::Picture::parse(const ByteVector &data)
+{
+  return parse(data, nullptr, -1, 0);
+}
+
+bool FLAC::Picture::parse(const ByteVector &data, TagLib::File *file, offset_t offset,
+                          unsigned int blockLength)
 {
   if(data.size() < 32) {
     debug("A picture block must contain at least 5 bytes.");
@@ -97,10 +109,19 @@ bool FLAC::Picture::parse(const ByteVector &data)
   unsigned int dataLength = data.toUInt(pos);
   pos += 4;
   if(pos + dataLength > data.size()) {
+    if(file && static_cast<unsigned long long>(pos) + dataLength <= blockLength) {
+      d->data.clear();
+      d->file = file;
+      d->dataOffset = offset + pos;
+      d->dataLength = dataLength;
+      return true;
+    }
+
     debug("Invalid picture block.");
     return false;
   }
   d->data = data.mid(pos, dataLength);
+  d->file = nullptr;
 
   return true;
 }
@@ -119,6 +140,7 @@ ByteVector FLAC::Picture::render() const
   result.append(ByteVector::fromUInt(d->height));
   result.append(ByteVector::fromUInt(d->colorDepth));
   result.append(ByteVector::fromUInt(d->numColors));
+  loadData();
   result.append(ByteVector::fromUInt(d->data.size()));
   result.append(d->data);
   return result;
@@ -196,10 +218,25 @@ void FLAC::Picture::setNumColors(int numColors)
 
 ByteVector FLAC::Picture::data() const
 {
+  loadData();
   return d->data;
 }
 
 void FLAC::Picture::setData(const ByteVector &data)
 {
   d->data = data;
+  d->file = nullptr;
+}
+
+void FLAC::Picture::loadData() const
+{
+  if(!d->file)
+    return;
+
+  d->file->seek(d->dataOffset);
+  d->data = d->file->readBlock(d->dataLength);
+  d->file = nullptr;
+
+  if(d->data.size() != d->dataLength)
+    debug("FLAC::Picture::loadData() -- Failed to read the image data.");
 }
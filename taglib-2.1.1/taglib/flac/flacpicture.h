@@ -26,6 +26,7 @@
 #ifndef TAGLIB_FLACPICTURE_H
 #define TAGLIB_FLACPICTURE_H
 
+#include "taglib.h"
 #include "tlist.h"
 #include "tstring.h"
 #include "tbytevector.h"
@@ -34,6 +35,9 @@
 #include "flacmetadatablock.h"
 
 namespace TagLib {
+
+  class File;
+
   namespace FLAC {
     //! FLAC picture
     class TAGLIB_EXPORT Picture : public MetadataBlock
@@ -128,6 +132,9 @@ namespace TagLib {
 
       /*!
        * Returns the image data.
+       *
+       * \note The image data of pictures read from a FLAC::File may be loaded
+       * from the file when this is first called.
        */
       ByteVector data() const;
 
@@ -152,6 +159,22 @@ namespace TagLib {
       bool parse(const ByteVector &data);
 
     private:
+      friend class File;
+
+      /*!
+       * Parses the picture block from \a data, which may end before the image
+       * data.  The image data is left in \a file at \a offset from the start
+       * of \a data and read when it is first needed.  It has to end within
+       * the \a blockLength bytes of the metadata block.
+       */
+      bool parse(const ByteVector &data, TagLib::File *file, offset_t offset,
+                 unsigned int blockLength);
+
+      /*!
+       * Reads the image data from the file, if it has not been read yet.
+       */
+      void loadData() const;
+
       class PicturePrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<PicturePrivate> d;
@@ -28,6 +28,7 @@
 #include <array>
 #include <climits>
 #include <utility>
+#include <vector>
 
 #include "tdebug.h"
 
@@ -39,92 +40,220 @@ namespace {
     "stbl", "minf", "moof", "traf", "trak",
     "stsd"
   };
+
+  // Upper bound for a single read while walking the headers of a container.
+  // Containers up to this size (e.g. the moov box of an audio file) are read
+  // in one go; in larger ones big leaves such as the stbl tables are skipped.
+  constexpr offset_t maxHeaderReadSize = 256 * 1024;
+
+  struct AtomHeader
+  {
+    explicit AtomHeader(offset_t ofs) : offset(ofs) {}
+
+    offset_t offset;
+    offset_t length { 0 };
+    ByteVector name;
+    // True if neither this atom nor any atom below it is invalid
+    bool valid { false };
+    int firstChild { -1 };
+    int nextSibling { -1 };
+  };
 } // namespace
 
-class MP4::Atom::AtomPrivate
+// Headers of an atom tree, read before any Atom is created for them
+class MP4::Atom::AtomTable
 {
 public:
-  explicit AtomPrivate(offset_t ofs) : offset(ofs) {}
-  offset_t offset;
-  offset_t length { 0 };
-  TagLib::ByteVector name;
-  AtomList children;
+  std::vector<AtomHeader> headers;
 };
 
-MP4::Atom::Atom(File *file)
-  : d(std::make_unique<AtomPrivate>(file->tell()))
-{
-  d->children.setAutoDelete(true);
+namespace {
+  // Reads the atom headers of a tree from a window of file data instead of
+  // issuing a seek and a small read for every header.
+  //
+  // The whole tree is walked up front, only the Atom objects are created on
+  // demand.  The headers of a root level container come from the same few
+  // window reads either way, and an invalid atom anywhere below it has to
+  // mark its ancestors invalid and stop reading, as it always did.
+  class AtomTableBuilder
+  {
+  public:
+    AtomTableBuilder(File *file, std::vector<AtomHeader> &headers) :
+      file(file),
+      fileLength(file->length()),
+      headers(headers)
+    {
+    }
 
-  ByteVector header = file->readBlock(8);
-  if(header.size() != 8) {
-    // The atom header must be 8 bytes long, otherwise there is either
-    // trailing garbage or the file is truncated
-    debug("MP4: Couldn't read 8 bytes of data for atom header");
-    d->length = 0;
-    file->seek(0, File::End);
-    return;
-  }
+    // Reads the atom at position and, for containers, all atoms below it.
+    // Returns the index of its header.
+    int read(offset_t position, offset_t readEnd)
+    {
+      const auto index = static_cast<int>(headers.size());
+      headers.emplace_back(position);
+
+      const ByteVector header = peek(position, 8, readEnd);
+      if(header.size() != 8) {
+        // The atom header must be 8 bytes long, otherwise there is either
+        // trailing garbage or the file is truncated
+        debug("MP4: Couldn't read 8 bytes of data for atom header");
+        stopped = true;
+        return index;
+      }
 
-  d->length = header.toUInt();
+      offset_t length = header.toUInt();
+      offset_t headerLength = 8;
 
-  if(d->length == 0) {
-    // The last atom which extends to the end of the file.
-    d->length = file->length() - d->offset;
-  }
-  else if(d->length == 1) {
-    // The atom has a 64-bit length.
-    if(const long long longLength = file->readBlock(8).toLongLong();
-       longLength <= LONG_MAX) {
-      // The actual length fits in long. That's always the case if long is 64-bit.
-      d->length = static_cast<long>(longLength);
-    }
-    else {
-      debug("MP4: 64-bit atoms are not supported");
-      d->length = 0;
-      file->seek(0, File::End);
-      return;
-    }
-  }
+      if(length == 0) {
+        // The last atom which extends to the end of the file.
+        length = fileLength - position;
+      }
+      else if(length == 1) {
+        // The atom has a 64-bit length.
+        if(const long long longLength = peek(position + 8, 8, readEnd).toLongLong();
+           longLength <= LONG_MAX) {
+          // The actual length fits in long. That's always the case if long is 64-bit.
+          length = static_cast<long>(longLength);
+          headerLength = 16;
+        }
+        else {
+          debug("MP4: 64-bit atoms are not supported");
+          stopped = true;
+          return index;
+        }
+      }
 
-  if(d->length < 8 || d->length > file->length() - d->offset) {
-    debug("MP4: Invalid atom size");
-    d->length = 0;
-    file->seek(0, File::End);
-    return;
-  }
+      if(length < 8 || length > fileLength - position) {
+        debug("MP4: Invalid atom size");
+        stopped = true;
+        return index;
+      }
 
-  d->name = header.mid(4, 4);
+      headers[index].length = length;
+      headers[index].name = header.mid(4, 4);
+      headers[index].valid = true;
 
-  for(auto c : containers) {
-    if(d->name == c) {
-      if(d->name == "meta") {
-        offset_t posAfterMeta = file->tell();
+      if(std::none_of(containers.begin(), containers.end(),
+                      [&name = headers[index].name](const auto &c) { return name == c; })) {
+        return index;
+      }
+
+      // Everything below a root level container is read from its window
+      readEnd = std::max(readEnd, position + length);
+
+      offset_t childPosition = position + headerLength;
+      if(headers[index].name == "meta") {
         static constexpr std::array metaChildrenNames {
           "hdlr", "ilst", "mhdr", "ctry", "lang"
         };
         // meta is not a full atom (i.e. not followed by version, flags). It
         // is followed by the size and type of the first child atom.
         auto metaIsFullAtom = std::none_of(metaChildrenNames.begin(), metaChildrenNames.end(),
-          [nextSize = file->readBlock(8).mid(4, 4)](const auto &child) { return nextSize == child; });
+          [nextSize = peek(childPosition, 8, readEnd).mid(4, 4)](const auto &child) { return nextSize == child; });
         // Only skip next four bytes, which contain version and flags, if meta
         // is a full atom.
-        file->seek(posAfterMeta + (metaIsFullAtom ? 4 : 0));
+        if(metaIsFullAtom)
+          childPosition += 4;
       }
-      else if(d->name == "stsd") {
-        file->seek(8, File::Current);
+      else if(headers[index].name == "stsd") {
+        childPosition += 8;
       }
-      while(file->tell() < d->offset + d->length) {
-        auto child = new MP4::Atom(file);
-        d->children.append(child);
-        if(child->d->length == 0)
-          return;
+
+      int previous = -1;
+      while(childPosition < position + length) {
+        const int child = read(childPosition, readEnd);
+        if(previous < 0)
+          headers[index].firstChild = child;
+        else
+          headers[previous].nextSibling = child;
+        previous = child;
+
+        if(!headers[child].valid)
+          headers[index].valid = false;
+        if(headers[child].length == 0)
+          break;
+        childPosition += headers[child].length;
+      }
+      return index;
+    }
+
+    // True once an invalid atom was found; like a truncated file, nothing
+    // after it is read
+    bool isStopped() const
+    {
+      return stopped;
+    }
+
+  private:
+    ByteVector peek(offset_t position, unsigned int length, offset_t readEnd)
+    {
+      if(position < windowOffset ||
+         position + length > windowOffset + static_cast<offset_t>(window.size())) {
+        const offset_t readSize = std::max<offset_t>(length, std::min(readEnd - position, maxHeaderReadSize));
+        file->seek(position);
+        window = file->readBlock(static_cast<size_t>(readSize));
+        windowOffset = position;
       }
-      return;
+      return window.mid(static_cast<unsigned int>(position - windowOffset), length);
+    }
+
+    File *file;
+    const offset_t fileLength;
+    std::vector<AtomHeader> &headers;
+    ByteVector window;
+    offset_t windowOffset { 0 };
+    bool stopped { false };
+  };
+} // namespace
+
+class MP4::Atom::AtomPrivate
+{
+public:
+  explicit AtomPrivate(offset_t ofs) : offset(ofs) {}
+
+  void setHeader(const std::shared_ptr<const AtomTable> &headerTable, int index)
+  {
+    const AtomHeader &header = headerTable->headers[index];
+    length = header.length;
+    name = header.name;
+    valid = header.valid;
+    if(header.firstChild >= 0) {
+      table = headerTable;
+      firstChild = header.firstChild;
     }
   }
 
-  file->seek(d->offset + d->length);
+  offset_t offset;
+  offset_t length { 0 };
+  TagLib::ByteVector name;
+  AtomList children;
+  bool valid { false };
+  // Where the children come from until they are first needed
+  std::shared_ptr<const AtomTable> table;
+  int firstChild { -1 };
+};
+
+MP4::Atom::Atom(File *file)
+  : d(std::make_unique<AtomPrivate>(file->tell()))
+{
+  d->children.setAutoDelete(true);
+
+  auto table = std::make_shared<AtomTable>();
+  AtomTableBuilder builder(file, table->headers);
+  builder.read(d->offset, d->offset + 16);
+  d->setHeader(table, 0);
+
+  if(builder.isStopped())
+    file->seek(0, File::End);
+  else
+    file->seek(d->offset + d->length);
+}
+
+MP4::Atom::Atom(const std::shared_ptr<const AtomTable> &table, int index)
+  : d(std::make_unique<AtomPrivate>(table->headers[index].offset))
+{
+  d->children.setAutoDelete(true);
+  d->setHeader(table, index);
 }
 
 MP4::Atom::~Atom() = default;
@@ -135,6 +264,7 @@ MP4::Atom::find(const char *name1, const char *name2, const char *name3, const c
   if(name1 == nullptr) {
     return this;
   }
+  loadChildren();
   auto it = std::find_if(d->children.cbegin(), d->children.cend(),
       [&name1](const Atom *child) { return child->d->name == name1; });
   return it != d->children.cend() ? (*it)->find(name2, name3, name4) : nullptr;
@@ -144,7 +274,7 @@ MP4::AtomList
 MP4::Atom::findall(const char *name, bool recursive) const
 {
   MP4::AtomList result;
-  for(const auto &child : std::as_const(d->children)) {
+  for(const auto &child : children()) {
     if(child->d->name == name) {
       result.append(child);
     }
@@ -162,6 +292,7 @@ MP4::Atom::path(MP4::AtomList &path, const char *name1, const char *name2, const
   if(name1 == nullptr) {
     return true;
   }
+  loadChildren();
   auto it = std::find_if(d->children.cbegin(), d->children.cend(),
       [&name1](const Atom *child) { return child->d->name == name1; });
   return it != d->children.cend() ? (*it)->path(path, name2, name3) : false;
@@ -174,11 +305,13 @@ void MP4::Atom::addToOffset(offset_t delta)
 
 void MP4::Atom::prependChild(Atom *atom)
 {
+  loadChildren();
   d->children.prepend(atom);
 }
 
 bool MP4::Atom::removeChild(Atom *meta)
 {
+  loadChildren();
   auto it = d->children.find(meta);
   if(it != d->children.end()) {
     d->children.erase(it);
@@ -204,9 +337,35 @@ const ByteVector &MP4::Atom::name() const
 
 const MP4::AtomList &MP4::Atom::children() const
 {
+  loadChildren();
   return d->children;
 }
 
+void MP4::Atom::loadChildren() const
+{
+  if(!d->table)
+    return;
+
+  for(int index = d->firstChild; index >= 0; index = d->table->headers[index].nextSibling) {
+    d->children.append(new Atom(d->table, index));
+  }
+  d->table.reset();
+}
+
+bool MP4::Atom::isValid() const
+{
+  if(d->length == 0)
+    return false;
+
+  // Atoms below are only checked once they exist, otherwise their headers
+  // have already been
+  if(d->table)
+    return d->valid;
+
+  return std::all_of(d->children.cbegin(), d->children.cend(),
+    [](const Atom *child) { return child->isValid(); });
+}
+
 
 class MP4::Atoms::AtomsPrivate
 {
@@ -219,14 +378,19 @@ MP4::Atoms::Atoms(File *file) :
 {
   d->atoms.setAutoDelete(true);
 
-  file->seek(0, File::End);
-  offset_t end = file->tell();
-  file->seek(0);
-  while(file->tell() + 8 <= end) {
-    auto atom = new MP4::Atom(file);
-    d->atoms.append(atom);
-    if (atom->length() == 0)
+  // The headers of the whole tree are read first, container by container,
+  // and Atom objects only created for the levels that are actually used
+  auto table = std::make_shared<Atom::AtomTable>();
+  AtomTableBuilder builder(file, table->headers);
+
+  const offset_t end = file->length();
+  offset_t position = 0;
+  while(position + 8 <= end) {
+    const int index = builder.read(position, position + 16);
+    d->atoms.append(new MP4::Atom(table, index));
+    if(builder.isStopped() || table->headers[index].length == 0)
       break;
+    position += table->headers[index].length;
   }
 }
 
@@ -255,19 +419,10 @@ MP4::Atoms::path(const char *name1, const char *name2, const char *name3, const
   return path;
 }
 
-namespace
-{
-  bool checkValid(const MP4::AtomList &list)
-  {
-    return std::none_of(list.begin(), list.end(),
-      [](const auto &a) { return a->length() == 0 || !checkValid(a->children()); });
-  }
-}  // namespace
-
 bool MP4::Atoms::checkRootLevelAtoms() {
   bool moovValid = false;
   for(auto it = d->atoms.begin(); it != d->atoms.end(); ++it) {
-    bool invalid = (*it)->length() == 0 || !checkValid((*it)->children());
+    bool invalid = !(*it)->isValid();
     if(!moovValid && !invalid && (*it)->name() == "moov") {
       moovValid = true;
     }
@@ -90,6 +90,13 @@ namespace TagLib {
       const AtomList &children() const;
 
     private:
+      friend class Atoms;
+      class AtomTable;
+
+      Atom(const std::shared_ptr<const AtomTable> &table, int index);
+      void loadChildren() const;
+      bool isValid() const;
+
       class AtomPrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<AtomPrivate> d;
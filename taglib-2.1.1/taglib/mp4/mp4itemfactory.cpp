@@ -25,6 +25,7 @@
 
 #include "mp4itemfactory.h"
 
+#include <mutex>
 #include <utility>
 
 #include "tbytevector.h"
@@ -44,9 +45,24 @@ constexpr char freeFormPrefix[] = "----:com.apple.iTunes:";
 class ItemFactory::ItemFactoryPrivate
 {
 public:
+  // The maps come from virtual functions which subclasses override, so they
+  // cannot be built in the constructor.  They are built once on first use,
+  // which may happen on several threads at the same time.
+  std::once_flag handlerTypesBuilt;
+  std::once_flag propertyKeysBuilt;
   NameHandlerMap handlerTypeForName;
   Map<ByteVector, String> propertyKeyForName;
   Map<String, ByteVector> nameForPropertyKey;
+
+  void buildPropertyKeyMaps(const ItemFactory *factory)
+  {
+    std::call_once(propertyKeysBuilt, [this, factory] {
+      propertyKeyForName = factory->namePropertyMap();
+      for(const auto &[k, t] : std::as_const(propertyKeyForName)) {
+        nameForPropertyKey[t] = k;
+      }
+    });
+  }
 };
 
 ItemFactory ItemFactory::factory;
@@ -234,9 +250,7 @@ std::pair<String, StringList> ItemFactory::itemToProperty(
 
 String ItemFactory::propertyKeyForName(const ByteVector &name) const
 {
-  if(d->propertyKeyForName.isEmpty()) {
-    d->propertyKeyForName = namePropertyMap();
-  }
+  d->buildPropertyKeyMaps(this);
   String key = d->propertyKeyForName.value(name);
   if(key.isEmpty() && name.startsWith(freeFormPrefix)) {
     key = name.mid(std::size(freeFormPrefix) - 1);
@@ -246,14 +260,7 @@ String ItemFactory::propertyKeyForName(const ByteVector &name) const
 
 ByteVector ItemFactory::nameForPropertyKey(const String &key) const
 {
-  if(d->nameForPropertyKey.isEmpty()) {
-    if(d->propertyKeyForName.isEmpty()) {
-      d->propertyKeyForName = namePropertyMap();
-    }
-    for(const auto &[k, t] : std::as_const(d->propertyKeyForName)) {
-      d->nameForPropertyKey[t] = k;
-    }
-  }
+  d->buildPropertyKeyMaps(this);
   ByteVector name = d->nameForPropertyKey.value(key);
   if(name.isEmpty() && !key.isEmpty()) {
     const auto &firstChar = key[0];
@@ -311,9 +318,9 @@ ItemFactory::NameHandlerMap ItemFactory::nameHandlerMap() const
 ItemFactory::ItemHandlerType ItemFactory::handlerTypeForName(
   const ByteVector &name) const
 {
-  if(d->handlerTypeForName.isEmpty()) {
+  std::call_once(d->handlerTypesBuilt, [this] {
     d->handlerTypeForName = nameHandlerMap();
-  }
+  });
   auto type = d->handlerTypeForName.value(name, ItemHandlerType::Unknown);
   if (type == ItemHandlerType::Unknown && name.size() == 4) {
     type = ItemHandlerType::Text;
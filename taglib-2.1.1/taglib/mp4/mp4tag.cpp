@@ -25,9 +25,12 @@
 
 #include "mp4tag.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 
 #include "tdebug.h"
+#include "tutils.h"
 #include "tpropertymap.h"
 #include "mp4itemfactory.h"
 #include "mp4atom.h"
@@ -35,6 +38,64 @@
 
 using namespace TagLib;
 
+namespace
+{
+  constexpr unsigned int DefaultPaddingSize = 4096;
+  constexpr offset_t MinPaddingSize = 1024;
+  constexpr offset_t MaxPaddingSize = 1024 * 1024;
+
+  template <typename T>
+  T fromBigEndian(T value)
+  {
+    if(Utils::systemByteOrder() == Utils::LittleEndian)
+      return Utils::byteSwap(value);
+    else
+      return value;
+  }
+
+  // Adds delta to every big-endian entry of a chunk offset table that points
+  // behind offset.  The loop has no calls and no data dependent branches, so
+  // compilers turn it into SIMD code for both 32 and 64 bit tables.
+  template <typename T>
+  void patchChunkOffsets(char *table, size_t count, T offset, T delta)
+  {
+    for(size_t i = 0; i < count; ++i) {
+      T value;
+      ::memcpy(&value, table + i * sizeof(T), sizeof(T));
+      value = fromBigEndian(value);
+      value += value > offset ? delta : 0;
+      value = fromBigEndian(value);
+      ::memcpy(table + i * sizeof(T), &value, sizeof(T));
+    }
+  }
+
+  // Rewrites the entries of an stco or co64 atom with a single read and a
+  // single write, however many chunks the track has.
+  template <typename T>
+  void updateChunkOffsets(TagLib::File *file, const MP4::Atom *atom,
+                          offset_t delta, offset_t offset)
+  {
+    // Offsets are compared and shifted in the width of the table.  For 32 bit
+    // tables this wraps exactly like the truncating write of the entry would.
+    if constexpr(sizeof(T) == 4) {
+      if(offset > 0xFFFFFFFFLL)
+        return;
+    }
+
+    file->seek(atom->offset() + 12);
+    ByteVector table = file->readBlock(atom->length() - 12);
+    if(table.size() < 4)
+      return;
+
+    const size_t entries = std::min<size_t>(table.toUInt(), (table.size() - 4) / sizeof(T));
+    patchChunkOffsets<T>(table.data() + 4, entries,
+                         static_cast<T>(offset), static_cast<T>(delta));
+
+    file->seek(atom->offset() + 12);
+    file->writeBlock(table);
+  }
+} // namespace
+
 class MP4::Tag::TagPrivate
 {
 public:
@@ -46,10 +107,51 @@ public:
 
   ~TagPrivate() = default;
 
+  // Parses the cover art atom skipped when reading the tag into items.
+  void loadCoverArt()
+  {
+    if(coverArtOffset < 0)
+      return;
+
+    const offset_t offset = coverArtOffset;
+    coverArtOffset = -1;
+
+    file->seek(offset);
+    const Atom atom(file);
+    if(atom.length() != coverArtLength) {
+      debug("MP4: The cover art atom changed since the tag was read");
+      return;
+    }
+
+    file->seek(offset + 8);
+    const ByteVector data = file->readBlock(coverArtLength - 8);
+    if(const auto &[name, itm] = factory->parseItem(&atom, data);
+       itm.isValid()) {
+      items[name] = itm;
+    }
+  }
+
+  // Drops the cover art which has not been read yet, e.g. because the item
+  // was replaced or removed.
+  void discardCoverArt()
+  {
+    coverArtOffset = -1;
+  }
+
   const ItemFactory *factory;
   TagLib::File *file { nullptr };
   Atoms *atoms { nullptr };
   ItemMap items;
+  unsigned int paddingSize { DefaultPaddingSize };
+
+  // Cover art is often most of the tag and rarely needed, so the "covr"
+  // atom is skipped when reading the tag and only its position is kept.
+  // While coverArtOffset is set, items has no "covr" entry.  Every accessor
+  // which can report the cover calls loadCoverArt() first, including the
+  // const ones: for them this is a cache of the file contents, and what the
+  // tag reports is the same whether it has been loaded yet or not.
+  mutable offset_t coverArtOffset { -1 };
+  mutable offset_t coverArtLength { 0 };
 };
 
 MP4::Tag::Tag() :
@@ -71,6 +173,17 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms,
   }
 
   for(const auto &atom : ilst->children()) {
+    if(atom->name() == "covr") {
+      if(d->coverArtOffset < 0 && !d->items.contains("covr")) {
+        d->coverArtOffset = atom->offset();
+        d->coverArtLength = atom->length();
+      }
+      else {
+        debug("MP4: Ignoring duplicate atom \"covr\"");
+      }
+      continue;
+    }
+
     file->seek(atom->offset() + 8);
     ByteVector data = d->file->readBlock(atom->length() - 8);
     if(const auto &[name, itm] = d->factory->parseItem(atom, data);
@@ -86,7 +199,7 @@ ByteVector
 MP4::Tag::padIlst(const ByteVector &data, int length) const
 {
   if(length == -1) {
-    length = ((data.size() + 1023) & ~1023) - data.size();
+    length = static_cast<int>(((data.size() + d->paddingSize + 1023) & ~1023U) - data.size());
   }
   return renderAtom("free", ByteVector(length, '\1'));
 }
@@ -100,6 +213,8 @@ MP4::Tag::renderAtom(const ByteVector &name, const ByteVector &data) const
 bool
 MP4::Tag::save()
 {
+  d->loadCoverArt();
+
   ByteVector data;
   for(const auto &[name, itm] : std::as_const(d->items)) {
     data.append(d->factory->renderItem(name, itm));
@@ -121,6 +236,7 @@ bool
 MP4::Tag::strip()
 {
   d->items.clear();
+  d->discardCoverArt();
 
   AtomList path = d->atoms->path("moov", "udta", "meta", "ilst");
   if(path.size() == 4) {
@@ -130,6 +246,18 @@ MP4::Tag::strip()
   return true;
 }
 
+void
+MP4::Tag::setPaddingSize(unsigned int size)
+{
+  d->paddingSize = size;
+}
+
+unsigned int
+MP4::Tag::paddingSize() const
+{
+  return d->paddingSize;
+}
+
 void
 MP4::Tag::updateParents(const AtomList &path, offset_t delta, int ignore)
 {
@@ -167,19 +295,7 @@ MP4::Tag::updateOffsets(offset_t delta, offset_t offset)
       if(atom->offset() > offset) {
         atom->addToOffset(delta);
       }
-      d->file->seek(atom->offset() + 12);
-      ByteVector data = d->file->readBlock(atom->length() - 12);
-      unsigned int count = data.toUInt();
-      d->file->seek(atom->offset() + 16);
-      unsigned int pos = 4;
-      while(count--) {
-        auto o = static_cast<offset_t>(data.toUInt(pos));
-        if(o > offset) {
-          o += delta;
-        }
-        d->file->writeBlock(ByteVector::fromUInt(static_cast<unsigned int>(o)));
-        pos += 4;
-      }
+      updateChunkOffsets<uint32_t>(d->file, atom, delta, offset);
     }
 
     const MP4::AtomList co64 = moov->findall("co64", true);
@@ -187,19 +303,7 @@ MP4::Tag::updateOffsets(offset_t delta, offset_t offset)
       if(atom->offset() > offset) {
         atom->addToOffset(delta);
       }
-      d->file->seek(atom->offset() + 12);
-      ByteVector data = d->file->readBlock(atom->length() - 12);
-      unsigned int count = data.toUInt();
-      d->file->seek(atom->offset() + 16);
-      unsigned int pos = 4;
-      while(count--) {
-        long long o = data.toLongLong(pos);
-        if(o > offset) {
-          o += delta;
-        }
-        d->file->writeBlock(ByteVector::fromLongLong(o));
-        pos += 8;
-      }
+      updateChunkOffsets<uint64_t>(d->file, atom, delta, offset);
     }
   }
 
@@ -285,8 +389,20 @@ MP4::Tag::saveExisting(ByteVector data, const AtomList &path)
       delta = data.size() - length;
     }
     else if(delta < 0) {
-      data.append(padIlst(data, static_cast<int>(-delta - 8)));
-      delta = 0;
+      // Padding won't increase beyond 1% of the file size or 1MB.
+      offset_t threshold = d->file->length() / 100;
+      threshold = std::max<offset_t>(threshold, MinPaddingSize);
+      threshold = std::min<offset_t>(threshold, MaxPaddingSize);
+      threshold = std::max<offset_t>(threshold, d->paddingSize + MinPaddingSize);
+
+      if(-delta - 8 > threshold) {
+        data.append(padIlst(data));
+        delta = data.size() - length;
+      }
+      else {
+        data.append(padIlst(data, static_cast<int>(-delta - 8)));
+        delta = 0;
+      }
     }
 
     d->file->insert(data, offset, length);
@@ -432,37 +548,53 @@ MP4::Tag::setTrack(unsigned int value)
 
 bool MP4::Tag::isEmpty() const
 {
+  if(d->items.isEmpty())
+    d->loadCoverArt();
   return d->items.isEmpty();
 }
 
 const MP4::ItemMap &MP4::Tag::itemMap() const
 {
+  d->loadCoverArt();
   return d->items;
 }
 
 MP4::Item MP4::Tag::item(const String &key) const
 {
-  return d->items[key];
+  if(key == "covr")
+    d->loadCoverArt();
+  return d->items.value(key);
 }
 
 void MP4::Tag::setItem(const String &key, const Item &value)
 {
+  if(key == "covr")
+    d->discardCoverArt();
   d->items[key] = value;
 }
 
 void MP4::Tag::removeItem(const String &key)
 {
+  if(key == "covr")
+    d->discardCoverArt();
   d->items.erase(key);
 }
 
 bool MP4::Tag::contains(const String &key) const
 {
+  if(key == "covr")
+    d->loadCoverArt();
   return d->items.contains(key);
 }
 
 PropertyMap MP4::Tag::properties() const
 {
+  // Cover art is never a property, so a "covr" atom which has not been read
+  // yet is only listed as unsupported data, without reading it.
   PropertyMap props;
+  if(d->coverArtOffset >= 0) {
+    props.addUnsupportedData("covr");
+  }
   for(const auto &[k, t] : std::as_const(d->items)) {
     if(auto [key, val] = d->factory->itemToProperty(k.data(String::Latin1), t);
        !key.isEmpty()) {
@@ -477,8 +609,11 @@ PropertyMap MP4::Tag::properties() const
 
 void MP4::Tag::removeUnsupportedProperties(const StringList &props)
 {
-  for(const auto &prop : props)
+  for(const auto &prop : props) {
+    if(prop == "covr")
+      d->discardCoverArt();
     d->items.erase(prop);
+  }
 }
 
 PropertyMap MP4::Tag::setProperties(const PropertyMap &props)
@@ -507,6 +642,7 @@ PropertyMap MP4::Tag::setProperties(const PropertyMap &props)
 StringList MP4::Tag::complexPropertyKeys() const
 {
   StringList keys;
+  d->loadCoverArt();
   if(d->items.contains("covr")) {
     keys.append("PICTURE");
   }
@@ -517,6 +653,7 @@ List<VariantMap> MP4::Tag::complexProperties(const String &key) const
 {
   List<VariantMap> props;
   if(const String uppercaseKey = key.upper(); uppercaseKey == "PICTURE") {
+    d->loadCoverArt();
     const CoverArtList pictures = d->items.value("covr").toCoverArtList();
     for(const CoverArt &picture : pictures) {
       String mimeType = "image/";
@@ -566,6 +703,7 @@ bool MP4::Tag::setComplexProperties(const String &key, const List<VariantMap> &v
       }
       pictures.append(CoverArt(format, property.value("data").value<ByteVector>()));
     }
+    d->discardCoverArt();
     d->items["covr"] = pictures;
   }
   else {
@@ -100,6 +100,25 @@ namespace TagLib {
          */
         bool strip();
 
+        /*!
+         * Sets the number of bytes of free space that are reserved behind the
+         * ilst atom whenever the tag has to grow.  Later edits consume this
+         * padding and leave the media data where it is; once it is used up it
+         * is refilled.  The default is 4 KiB, 0 only rounds the tag up to the
+         * next KiB.
+         *
+         * Padding left by a shrinking tag is kept up to 1% of the file size
+         * (at most 1 MiB), larger gaps are released.
+         */
+        void setPaddingSize(unsigned int size);
+
+        /*!
+         * Returns the number of bytes reserved when the tag has to grow.
+         *
+         * \see setPaddingSize()
+         */
+        unsigned int paddingSize() const;
+
         PropertyMap properties() const override;
         void removeUnsupportedProperties(const StringList &props) override;
         PropertyMap setProperties(const PropertyMap &props) override;
@@ -185,7 +185,9 @@ namespace TagLib {
        * released and default ISO-8859-1 handler is restored.
        *
        * \note The caller is responsible for deleting the previous handler
-       * as needed after it is released.
+       * as needed after it is released, but not before tags that other
+       * threads are reading or rendering are done with it.  The handler is
+       * shared by all threads.
        *
        * \see StringHandler
        */
@@ -26,6 +26,7 @@
 #include "id3v2framefactory.h"
 
 #include <array>
+#include <atomic>
 #include <utility>
 
 #include "tdebug.h"
@@ -91,8 +92,10 @@ namespace
 class FrameFactory::FrameFactoryPrivate
 {
 public:
-  String::Type defaultEncoding { String::Latin1 };
-  bool useDefaultEncoding { false };
+  // Atomic so that the instance() shared by all files can be configured
+  // while other threads are parsing.
+  std::atomic<String::Type> defaultEncoding { String::Latin1 };
+  std::atomic<bool> useDefaultEncoding { false };
 
   template <class T> void setTextEncoding(T *frame)
   {
@@ -368,12 +371,13 @@ void FrameFactory::rebuildAggregateFrames(ID3v2::Tag *tag) const
     if(auto tipl =
            dynamic_cast<TextIdentificationFrame *>(tag->frameList("TIPL").front())) {
       if(StringList tiplValues = tipl->toStringList(); tiplValues.size() % 2 == 0) {
-        static StringList tiplKeys;
-        if(tiplKeys.isEmpty()) {
+        static const StringList tiplKeys = [] {
+          StringList keys;
           for(const auto &kv : TextIdentificationFrame::involvedPeopleMap()) {
-            tiplKeys.append(kv.second);
+            keys.append(kv.second);
           }
-        }
+          return keys;
+        }();
         StringList tmclValues;
         for(auto it = tiplValues.begin(); it != tiplValues.end();) {
           const String involvement = *it;
@@ -409,8 +413,8 @@ String::Type FrameFactory::defaultTextEncoding() const
 
 void FrameFactory::setDefaultTextEncoding(String::Type encoding)
 {
-  d->useDefaultEncoding = true;
   d->defaultEncoding = encoding;
+  d->useDefaultEncoding = true;
 }
 
 bool FrameFactory::isUsingDefaultTextEncoding() const
@@ -111,6 +111,11 @@ namespace TagLib {
        *
        * Valid string types for ID3v2 tags are Latin1, UTF8, UTF16 and UTF16BE.
        *
+       * \note Setting this on instance() affects every file which was not
+       * given its own factory, including those being read in other threads
+       * at the time.  Pass a separate factory to the file constructor if the
+       * encoding should only apply to some files.
+       *
        * \see defaultTextEncoding()
        */
       void setDefaultTextEncoding(String::Type encoding);
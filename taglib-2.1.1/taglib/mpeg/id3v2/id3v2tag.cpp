@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <utility>
 
 #include "tdebug.h"
@@ -52,7 +53,7 @@ using namespace ID3v2;
 namespace
 {
   const ID3v2::Latin1StringHandler defaultStringHandler;
-  const ID3v2::Latin1StringHandler *stringHandler = &defaultStringHandler;
+  std::atomic<const ID3v2::Latin1StringHandler *> stringHandler { &defaultStringHandler };
 
   constexpr long MinPaddingSize = 1024;
   constexpr long MaxPaddingSize = 1024 * 1024;
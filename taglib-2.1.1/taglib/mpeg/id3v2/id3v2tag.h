@@ -363,7 +363,9 @@ namespace TagLib {
        * released and default ISO-8859-1 handler is restored.
        *
        * \note The caller is responsible for deleting the previous handler
-       * as needed after it is released.
+       * as needed after it is released.  Frames being parsed in other threads
+       * may still be using it at that point, and parse() may be called from
+       * several threads at once.
        *
        * \see Latin1StringHandler
        */
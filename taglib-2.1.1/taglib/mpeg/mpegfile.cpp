@@ -523,7 +523,7 @@ offset_t MPEG::File::findID3v2(Properties::ReadStyle readStyle)
   if(readBlock(headerID.size()) == headerID)
     return 0;
 
-  if(readStyle == Properties::Fast)
+  if(readStyle == Properties::Fast || readStyle == Properties::TagsOnly)
     return -1;
 
   if(const Header firstHeader(this, 0, true); firstHeader.isValid())
@@ -31,6 +31,7 @@
 #include "xingheader.h"
 #ifdef TAGLIB_WITH_APE
 #include "apetag.h"
+#include "apefooter.h"
 #endif
 
 using namespace TagLib;
@@ -175,13 +176,13 @@ void MPEG::Properties::read(File *file, ReadStyle readStyle)
       // d->length = 1000LL * numFrames * firstHeader.samplesPerFrame() / firstHeader.sampleRate();
       // d->bitrate = d->length > 0 ? totalFrameSize * 8 / d->length : 0;
       //
-      // With Fast read style, we do not try to estimate the length and just set
-      // it and the bitrate to zero.
+      // With Fast and TagsOnly read styles, we do not try to estimate the length
+      // and just set it and the bitrate to zero.
       // With Average read style, in order to come faster to an estimate which
       // is accurate enough, we stop when the average bytes/frame rate is stable
       // for 10 frames and then calculate the length from the estimated bitrate
       // and the stream length.
-      if(readStyle == Fast) {
+      if(readStyle == Fast || readStyle == TagsOnly) {
         bitRate = 0;
         d->length = 0;
       }
@@ -230,9 +231,23 @@ void MPEG::Properties::read(File *file, ReadStyle readStyle)
       d->bitrate = bitRate;
 
       // Look for the last MPEG audio frame to calculate the stream length.
+      // Without a scan, everything between the first frame and the tags at
+      // the end of the file is taken as audio.
 
-      if(const offset_t lastFrameOffset = file->lastFrameOffset();
-         lastFrameOffset < 0) {
+      if(readStyle == TagsOnly) {
+        offset_t streamEnd = file->length();
+        if(file->hasID3v1Tag())
+          streamEnd -= 128;
+#ifdef TAGLIB_WITH_APE
+        if(file->hasAPETag())
+          streamEnd -= file->APETag()->footer()->completeTagSize();
+#endif
+        if(const offset_t streamLength = streamEnd - firstFrameOffset;
+           streamLength > 0)
+          d->length = static_cast<int>(static_cast<double>(streamLength) * 8.0 / d->bitrate + 0.5);
+      }
+      else if(const offset_t lastFrameOffset = file->lastFrameOffset();
+              lastFrameOffset < 0) {
         debug("MPEG::Properties::read() -- Could not find an MPEG frame in the stream.");
       }
       else
@@ -25,12 +25,15 @@
 
 #include "oggfile.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "tdebug.h"
 #include "tmap.h"
 #include "oggpage.h"
 #include "oggpageheader.h"
+#include "oggutils.h"
 
 using namespace TagLib;
 
@@ -43,6 +46,225 @@ namespace
       return page->firstPacketIndex() + page->packetCount();
     return page->firstPacketIndex() + page->packetCount() - 1;
   }
+
+  // Splits the packets into exactly pageCount pages, so that the pages
+  // following them keep their sequence numbers.  The lacing values are spread
+  // evenly over the pages.  Returns an empty list if the packets don't fit.
+  List<Ogg::Page *> paginateInPlace(const ByteVectorList &packets,
+                                    unsigned int pageCount,
+                                    unsigned int streamSerialNumber,
+                                    int firstPage,
+                                    bool firstPacketContinued,
+                                    bool lastPacketCompleted)
+  {
+    // Each segment is a (packet, offset) pair covering up to 255 bytes.  An
+    // unfinished last packet has no terminating segment.
+
+    std::vector<std::pair<const ByteVector *, unsigned int>> segments;
+    for(auto it = packets.cbegin(); it != packets.cend(); ++it) {
+      const bool terminated = lastPacketCompleted || it != std::prev(packets.cend());
+      for(unsigned int pos = 0; pos < it->size() || (terminated && pos == it->size()); pos += 255)
+        segments.emplace_back(&*it, pos);
+    }
+
+    // Leave some slack on each page, as Page::paginate() estimates the size
+    // of the segment table per packet and a page boundary may be moved by one
+    // segment below.
+
+    const size_t segmentCount = segments.size();
+    if(pageCount == 0 ||
+       segmentCount < 2 * pageCount ||
+       (segmentCount + pageCount - 1) / pageCount > 253)
+      return List<Ogg::Page *>();
+
+    auto segmentSize = [&segments](size_t index) {
+      return std::min<unsigned int>(255, segments[index].first->size() - segments[index].second);
+    };
+
+    List<Ogg::Page *> pages;
+    size_t begin = 0;
+
+    for(unsigned int pageIndex = 0; pageIndex < pageCount; pageIndex++) {
+      size_t end = segmentCount * (pageIndex + 1) / pageCount;
+
+      // Don't start a page with the empty segment terminating a packet.
+
+      if(end < segmentCount && segmentSize(end) == 0)
+        ++end;
+
+      ByteVectorList pagePackets;
+      for(size_t i = begin; i < end; ) {
+        const ByteVector *packet = segments[i].first;
+        const unsigned int offset = segments[i].second;
+        unsigned int length = 0;
+        for(; i < end && segments[i].first == packet; i++)
+          length += segmentSize(i);
+        pagePackets.append(packet->mid(offset, length));
+      }
+
+      const bool continued = segments[begin].second > 0 ||
+                             (pageIndex == 0 && firstPacketContinued);
+      const bool completed = pageIndex == pageCount - 1
+                           ? lastPacketCompleted : segmentSize(end - 1) < 255;
+
+      List<Ogg::Page *> page = Ogg::Page::paginate(pagePackets,
+                                                   Ogg::Page::SinglePagePerGroup,
+                                                   streamSerialNumber,
+                                                   firstPage + static_cast<int>(pageIndex),
+                                                   continued,
+                                                   completed);
+      pages.append(page);
+
+      if(page.size() != 1) {
+        pages.setAutoDelete(true);
+        return List<Ogg::Page *>();
+      }
+
+      begin = end;
+    }
+
+    return pages;
+  }
+
+  // Adds delta to the sequence numbers of the pages of the given stream from
+  // offset up to its last page and returns the end of the renumbered range.
+  // The pages are patched in large blocks, so the cost is a few big reads and
+  // writes rather than two per page.
+  offset_t renumberPages(Ogg::File *file, offset_t offset,
+                         unsigned int streamSerialNumber, int delta)
+  {
+    static constexpr unsigned int blockSize = 1024 * 1024;
+
+    bool done = false;
+
+    while(!done) {
+      file->seek(offset);
+      ByteVector block = file->readBlock(blockSize);
+
+      unsigned int pos = 0;
+      unsigned int dirtyBegin = block.size();
+      unsigned int dirtyEnd = 0;
+
+      while(pos + 27 <= block.size()) {
+        if(!block.containsAt("OggS", pos) || block[pos + 26] == 0) {
+          done = true;
+          break;
+        }
+
+        const unsigned int headerSize = 27 + static_cast<unsigned char>(block[pos + 26]);
+        if(pos + headerSize > block.size())
+          break;
+
+        unsigned int pageSize = headerSize;
+        for(unsigned int i = pos + 27; i < pos + headerSize; i++)
+          pageSize += static_cast<unsigned char>(block[i]);
+
+        if(pos + pageSize > block.size())
+          break;
+
+        if(block.toUInt(pos + 14, false) == streamSerialNumber) {
+          char *page = block.data() + pos;
+
+          const ByteVector sequenceNumber =
+            ByteVector::fromUInt(block.toUInt(pos + 18, false) + delta, false);
+          std::copy(sequenceNumber.begin(), sequenceNumber.end(), page + 18);
+          std::fill(page + 22, page + 26, 0);
+
+          const ByteVector checksum =
+            ByteVector::fromUInt(Ogg::pageChecksum(page, pageSize), false);
+          std::copy(checksum.begin(), checksum.end(), page + 22);
+
+          dirtyBegin = std::min(dirtyBegin, pos);
+          dirtyEnd = pos + pageSize;
+
+          if(page[5] & 0x04)
+            done = true;
+        }
+
+        pos += pageSize;
+
+        if(done)
+          break;
+      }
+
+      if(dirtyBegin < dirtyEnd) {
+        file->seek(offset + dirtyBegin);
+        file->writeBlock(block.mid(dirtyBegin, dirtyEnd - dirtyBegin));
+      }
+
+      // Stop at a truncated page at the end of the file.
+
+      if(pos == 0)
+        break;
+
+      offset += pos;
+    }
+
+    return offset;
+  }
+
+  // Returns the offset of the last page of the given stream or -1 if there is
+  // none.  The file is searched backwards from the end in 64 KiB blocks, so
+  // this normally takes a single read.  Candidates are checked by their
+  // header and checksum, so stray "OggS" bytes in the audio data or trailing
+  // garbage are skipped.  The search gives up after 1 MiB, so that a broken
+  // file is not read backwards all the way to its start.
+  offset_t findLastPage(Ogg::File *file, unsigned int streamSerialNumber)
+  {
+    static constexpr offset_t blockSize = 64 * 1024;
+    static constexpr offset_t maxPageSize = 27 + 255 + 255 * 255;
+    static constexpr int maxBlocks = 16;
+
+    const offset_t fileLength = file->length();
+    offset_t blockEnd = fileLength;
+
+    for(int blocks = 0; blockEnd > 0; ++blocks) {
+      if(blocks == maxBlocks) {
+        debug("Ogg::File::lastPageHeader() -- No page of the stream found near the end of the file.");
+        break;
+      }
+
+      const offset_t blockStart = std::max<offset_t>(0, blockEnd - blockSize);
+
+      // Read past the block so that pages starting near its end are complete.
+
+      file->seek(blockStart);
+      const ByteVector block =
+        file->readBlock(static_cast<size_t>(std::min(fileLength, blockEnd + maxPageSize) - blockStart));
+
+      for(auto pos = static_cast<unsigned int>(std::min<offset_t>(blockEnd - blockStart, block.size()));
+          pos-- > 0; ) {
+        if(block[pos] != 'O' || !block.containsAt("OggS", pos))
+          continue;
+
+        if(pos + 27 > block.size() || block[pos + 4] != 0 || block[pos + 26] == 0 ||
+           block.toUInt(pos + 14, false) != streamSerialNumber)
+          continue;
+
+        const unsigned int headerSize = 27 + static_cast<unsigned char>(block[pos + 26]);
+        if(pos + headerSize > block.size())
+          continue;
+
+        unsigned int pageSize = headerSize;
+        for(unsigned int i = pos + 27; i < pos + headerSize; i++)
+          pageSize += static_cast<unsigned char>(block[i]);
+
+        if(pos + pageSize > block.size())
+          continue;
+
+        ByteVector page = block.mid(pos, pageSize);
+        const unsigned int checksum = page.toUInt(22, false);
+        std::fill(page.begin() + 22, page.begin() + 26, 0);
+
+        if(Ogg::pageChecksum(page.data(), page.size()) == checksum)
+          return blockStart + pos;
+      }
+
+      blockEnd = blockStart;
+    }
+
+    return -1;
+  }
 }  // namespace
 
 class Ogg::File::FilePrivate
@@ -53,9 +275,13 @@ public:
     pages.setAutoDelete(true);
   }
 
+  // Index of the pages read so far, kept up to date by writePacket()
   List<Page *> pages;
+  Map<unsigned int, ByteVector> packets;
   std::unique_ptr<PageHeader> firstPageHeader;
   std::unique_ptr<PageHeader> lastPageHeader;
+  offset_t firstPageHeaderOffset { -1 };
+  offset_t lastPageHeaderOffset { -1 };
   Map<unsigned int, ByteVector> dirtyPackets;
 };
 
@@ -73,6 +299,11 @@ ByteVector Ogg::File::packet(unsigned int i)
   if(d->dirtyPackets.contains(i))
     return d->dirtyPackets[i];
 
+  // Packets which have already been put together are served from memory.
+
+  if(d->packets.contains(i))
+    return d->packets[i];
+
   // If we haven't indexed the page where the packet we're interested in starts,
   // begin reading pages until we have.
 
@@ -101,6 +332,7 @@ ByteVector Ogg::File::packet(unsigned int i)
     packet.append((*it)->packets().front());
   }
 
+  d->packets[i] = packet;
   return packet;
 }
 
@@ -117,11 +349,11 @@ void Ogg::File::setPacket(unsigned int i, const ByteVector &p)
 const Ogg::PageHeader *Ogg::File::firstPageHeader()
 {
   if(!d->firstPageHeader) {
-    const offset_t firstPageHeaderOffset = find("OggS");
-    if(firstPageHeaderOffset < 0)
+    d->firstPageHeaderOffset = find("OggS");
+    if(d->firstPageHeaderOffset < 0)
       return nullptr;
 
-    d->firstPageHeader = std::make_unique<PageHeader>(this, firstPageHeaderOffset);
+    d->firstPageHeader = std::make_unique<PageHeader>(this, d->firstPageHeaderOffset);
   }
 
   return d->firstPageHeader->isValid() ? d->firstPageHeader.get() : nullptr;
@@ -130,11 +362,14 @@ const Ogg::PageHeader *Ogg::File::firstPageHeader()
 const Ogg::PageHeader *Ogg::File::lastPageHeader()
 {
   if(!d->lastPageHeader) {
-    const offset_t lastPageHeaderOffset = rfind("OggS");
-    if(lastPageHeaderOffset < 0)
+    const PageHeader *first = firstPageHeader();
+    if(!first)
       return nullptr;
 
-    d->lastPageHeader = std::make_unique<PageHeader>(this, lastPageHeaderOffset);
+    // A failed search leaves an invalid header, so that it is not repeated.
+
+    d->lastPageHeaderOffset = findLastPage(this, first->streamSerialNumber());
+    d->lastPageHeader = std::make_unique<PageHeader>(this, d->lastPageHeaderOffset);
   }
 
   return d->lastPageHeader->isValid() ? d->lastPageHeader.get() : nullptr;
@@ -248,14 +483,32 @@ void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
   // TODO: This pagination method isn't accurate for what's being done here.
   // This should account for real possibilities like non-aligned packets and such.
 
+  const unsigned int streamSerialNumber = firstPage->header()->streamSerialNumber();
+  const int originalPageCount = lastPage->pageSequenceNumber() - firstPage->pageSequenceNumber() + 1;
+
   List<Page *> pages = Page::paginate(packets,
                                       Page::SinglePagePerGroup,
-                                      firstPage->header()->streamSerialNumber(),
+                                      streamSerialNumber,
                                       firstPage->pageSequenceNumber(),
                                       firstPage->header()->firstPacketContinued(),
                                       lastPage->header()->lastPacketCompleted());
   pages.setAutoDelete(true);
 
+  // Changing the number of pages means renumbering the rest of the stream, so
+  // try to spread the packets over as many pages as they used to take.
+
+  if(static_cast<int>(pages.size()) != originalPageCount) {
+    List<Page *> samePages = paginateInPlace(packets,
+                                             originalPageCount,
+                                             streamSerialNumber,
+                                             firstPage->pageSequenceNumber(),
+                                             firstPage->header()->firstPacketContinued(),
+                                             lastPage->header()->lastPacketCompleted());
+    samePages.setAutoDelete(true);
+    if(!samePages.isEmpty())
+      pages.swap(samePages);
+  }
+
   // Write the pages.
 
   ByteVector data;
@@ -269,30 +522,55 @@ void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
 
   // Renumber the following pages if the pages have been split or merged.
 
-  if(const int numberOfNewPages
-      = pages.back()->pageSequenceNumber() - lastPage->pageSequenceNumber();
-     numberOfNewPages != 0) {
-    offset_t pageOffset = originalOffset + data.size();
-
-    while(true) {
-      Page page(this, pageOffset);
-      if(!page.header()->isValid())
-        break;
+  const int numberOfNewPages = pages.back()->pageSequenceNumber() - lastPage->pageSequenceNumber();
+  const offset_t sizeDifference = static_cast<offset_t>(data.size()) - originalLength;
 
-      page.setPageSequenceNumber(page.pageSequenceNumber() + numberOfNewPages);
-      const ByteVector pageData = page.render();
+  offset_t renumberedEnd = originalOffset + data.size();
+  if(numberOfNewPages != 0)
+    renumberedEnd = renumberPages(this, renumberedEnd, streamSerialNumber, numberOfNewPages);
 
-      seek(pageOffset + 18);
-      writeBlock(pageData.mid(18, 8));
+  // Update the cached page headers rather than looking them up again.
 
-      if(page.header()->lastPageOfStream())
-        break;
+  if(d->firstPageHeaderOffset >= originalOffset) {
+    d->firstPageHeader.reset();
+    d->firstPageHeaderOffset = -1;
+  }
 
-      pageOffset += page.size();
+  if(d->lastPageHeader) {
+    if(d->lastPageHeaderOffset < originalOffset + originalLength) {
+      d->lastPageHeader.reset();
+      d->lastPageHeaderOffset = -1;
+    }
+    else {
+      d->lastPageHeaderOffset += sizeDifference;
+      if(d->lastPageHeaderOffset < renumberedEnd &&
+         d->lastPageHeader->streamSerialNumber() == streamSerialNumber) {
+        d->lastPageHeader->setPageSequenceNumber(
+          d->lastPageHeader->pageSequenceNumber() + numberOfNewPages);
+      }
     }
   }
 
-  // Discard all the pages to keep them up-to-date by fetching them again.
+  // Replace the rewritten pages in the page index.  The pages following them
+  // have moved and are read again when needed.
+
+  const unsigned int firstPacketIndex = firstPage->firstPacketIndex();
+
+  while(d->pages.back() != firstPage) {
+    delete d->pages.back();
+    d->pages.erase(std::prev(d->pages.end()));
+  }
+  delete d->pages.back();
+  d->pages.erase(std::prev(d->pages.end()));
+
+  offset_t pageOffset = originalOffset;
+  for(const auto &page : std::as_const(pages)) {
+    auto newPage = new Page(this, pageOffset);
+    newPage->setFirstPacketIndex(page == pages.front()
+                                 ? firstPacketIndex : nextPacketIndex(d->pages.back()));
+    d->pages.append(newPage);
+    pageOffset += page->size();
+  }
 
-  d->pages.clear();
+  d->packets[i] = packet;
 }
@@ -78,6 +78,10 @@ namespace TagLib {
       /*!
        * Returns a pointer to the PageHeader for the last page in the stream or
        * null if the page could not be found.
+       *
+       * \note Only pages of the logical stream which starts the file and have
+       * a valid checksum are considered.  The search usually takes a single
+       * read of the last 64 KiB of the file.
        */
       const PageHeader *lastPageHeader();
 
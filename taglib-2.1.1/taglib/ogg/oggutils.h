@@ -0,0 +1,106 @@
+/***************************************************************************
+    copyright            : (C) 2002 - 2008 by Scott Wheeler
+    email                : wheeler@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_OGGUTILS_H
+#define TAGLIB_OGGUTILS_H
+
+// THIS FILE IS NOT A PART OF THE TAGLIB API
+
+#ifndef DO_NOT_DOCUMENT  // tell Doxygen not to document this header
+
+#include <array>
+#include <cstddef>
+
+namespace TagLib
+{
+  namespace Ogg
+  {
+    namespace
+    {
+
+      using CrcTables = std::array<std::array<unsigned int, 256>, 8>;
+
+      /*!
+       * Builds the lookup tables of the slicing-by-8 CRC.  Table \e k holds
+       * the checksum of each byte followed by \e k zero bytes.
+       */
+      constexpr CrcTables makeCrcTables()
+      {
+        CrcTables tables {};
+
+        for(unsigned int i = 0; i < 256; i++) {
+          unsigned int crc = i << 24;
+          for(int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+          tables[0][i] = crc;
+        }
+
+        for(size_t k = 1; k < tables.size(); k++) {
+          for(unsigned int i = 0; i < 256; i++) {
+            const unsigned int prev = tables[k - 1][i];
+            tables[k][i] = (prev << 8) ^ tables[0][prev >> 24];
+          }
+        }
+
+        return tables;
+      }
+
+      constexpr CrcTables crcTables = makeCrcTables();
+
+      /*!
+       * Returns the CRC checksum of \a length bytes at \a data, continuing
+       * from \a crc so that a page can be checksummed in several pieces.
+       *
+       * \note This uses an uncommon variant of CRC32 specializes in Ogg.
+       * Eight bytes are folded in per step instead of one.
+       */
+      inline unsigned int pageChecksum(const char *data, size_t length, unsigned int crc = 0)
+      {
+        const auto &t = crcTables;
+        auto p = reinterpret_cast<const unsigned char *>(data);
+
+        while(length >= 8) {
+          crc ^= static_cast<unsigned int>(p[0]) << 24 | static_cast<unsigned int>(p[1]) << 16 |
+                 static_cast<unsigned int>(p[2]) << 8  | static_cast<unsigned int>(p[3]);
+          crc = t[7][crc >> 24] ^ t[6][(crc >> 16) & 0xff] ^
+                t[5][(crc >> 8) & 0xff] ^ t[4][crc & 0xff] ^
+                t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+          p += 8;
+          length -= 8;
+        }
+
+        while(length-- > 0)
+          crc = (crc << 8) ^ t[0][((crc >> 24) ^ *p++) & 0xff];
+
+        return crc;
+      }
+
+    }  // namespace
+  }  // namespace Ogg
+}  // namespace TagLib
+
+#endif
+
+#endif
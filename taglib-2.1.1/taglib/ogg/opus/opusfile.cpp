@@ -59,20 +59,20 @@ bool Ogg::Opus::File::isSupported(IOStream *stream)
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
-Opus::File::File(FileName file, bool readProperties, Properties::ReadStyle) :
+Opus::File::File(FileName file, bool readProperties, Properties::ReadStyle propertiesStyle) :
   Ogg::File(file),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
-Opus::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle) :
+Opus::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle propertiesStyle) :
   Ogg::File(stream),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
 Opus::File::~File() = default;
@@ -111,7 +111,7 @@ bool Opus::File::save()
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void Opus::File::read(bool readProperties)
+void Opus::File::read(bool readProperties, Properties::ReadStyle propertiesStyle)
 {
   ByteVector opusHeaderData = packet(0);
 
@@ -132,5 +132,5 @@ void Opus::File::read(bool readProperties)
   d->comment = std::make_unique<Ogg::XiphComment>(commentHeaderData.mid(8));
 
   if(readProperties)
-    d->properties = std::make_unique<Properties>(this);
+    d->properties = std::make_unique<Properties>(this, propertiesStyle);
 }
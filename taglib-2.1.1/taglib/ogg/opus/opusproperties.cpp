@@ -55,7 +55,7 @@ Opus::Properties::Properties(File *file, ReadStyle style) :
   AudioProperties(style),
   d(std::make_unique<PropertiesPrivate>())
 {
-  read(file);
+  read(file, style);
 }
 
 Opus::Properties::~Properties() = default;
@@ -97,7 +97,7 @@ int Opus::Properties::opusVersion() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void Opus::Properties::read(File *file)
+void Opus::Properties::read(File *file, ReadStyle style)
 {
   // Get the identification header from the Ogg implementation.
 
@@ -130,8 +130,13 @@ void Opus::Properties::read(File *file)
   // *Channel Mapping Family* (8 bits, unsigned)
   // pos += 1;
 
+  // The last page is found by searching backwards from the end of the file,
+  // which is skipped when only the tags are wanted.  Unlike Vorbis and Speex,
+  // the Opus header has no bitrate to estimate the length from, so length and
+  // bitrate stay zero then.
+
   const Ogg::PageHeader *first = file->firstPageHeader();
-  const Ogg::PageHeader *last  = file->lastPageHeader();
+  const Ogg::PageHeader *last  = style != TagsOnly ? file->lastPageHeader() : nullptr;
 
   if(first && last) {
     const long long start = first->absoluteGranularPosition();
@@ -155,6 +160,6 @@ void Opus::Properties::read(File *file)
             "end of this file was incorrect.");
     }
   }
-  else
+  else if(style != TagsOnly)
     debug("Opus::Properties::read() -- Could not find valid first and last Ogg pages.");
 }
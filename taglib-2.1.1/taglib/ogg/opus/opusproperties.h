@@ -67,12 +67,19 @@ namespace TagLib {
         /*!
          * Returns the length of the file in milliseconds.
          *
+         * \note Returns 0 when read with AudioProperties::TagsOnly: the length
+         * needs the last Ogg page, and the Opus header has no bitrate to
+         * estimate it from.
+         *
          * \see lengthInSeconds()
          */
         int lengthInMilliseconds() const override;
 
         /*!
          * Returns the average bit rate of the file in kb/s.
+         *
+         * \note Returns 0 when read with AudioProperties::TagsOnly, for the
+         * same reason as lengthInMilliseconds().
          */
         int bitrate() const override;
 
@@ -102,7 +109,7 @@ namespace TagLib {
         int opusVersion() const;
 
       private:
-        void read(File *file);
+        void read(File *file, ReadStyle style);
 
         class PropertiesPrivate;
         TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
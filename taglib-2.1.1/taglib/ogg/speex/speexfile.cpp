@@ -59,20 +59,20 @@ bool Ogg::Speex::File::isSupported(IOStream *stream)
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
-Speex::File::File(FileName file, bool readProperties, Properties::ReadStyle) :
+Speex::File::File(FileName file, bool readProperties, Properties::ReadStyle propertiesStyle) :
   Ogg::File(file),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
-Speex::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle) :
+Speex::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle propertiesStyle) :
   Ogg::File(stream),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
 Speex::File::~File() = default;
@@ -111,7 +111,7 @@ bool Speex::File::save()
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void Speex::File::read(bool readProperties)
+void Speex::File::read(bool readProperties, Properties::ReadStyle propertiesStyle)
 {
   ByteVector speexHeaderData = packet(0);
 
@@ -126,5 +126,5 @@ void Speex::File::read(bool readProperties)
   d->comment = std::make_unique<Ogg::XiphComment>(commentHeaderData);
 
   if(readProperties)
-    d->properties = std::make_unique<Properties>(this);
+    d->properties = std::make_unique<Properties>(this, propertiesStyle);
 }
@@ -58,7 +58,9 @@ namespace TagLib {
          * Constructs a Speex file from \a file.  If \a readProperties is \c true the
          * file's audio properties will also be read.
          *
-         * \note In the current implementation, \a propertiesStyle is ignored.
+         * \note In the current implementation, \a propertiesStyle only matters
+         *   if it is Properties::TagsOnly, which estimates the length from the
+         *   bitrate in the header instead of looking for the last Ogg page.
          */
         File(FileName file, bool readProperties = true,
              Properties::ReadStyle propertiesStyle = Properties::Average);
@@ -70,7 +72,9 @@ namespace TagLib {
          * \note TagLib will *not* take ownership of the stream, the caller is
          * responsible for deleting it after the File object.
          *
-         * \note In the current implementation, \a propertiesStyle is ignored.
+         * \note In the current implementation, \a propertiesStyle only matters
+         *   if it is Properties::TagsOnly, which estimates the length from the
+         *   bitrate in the header instead of looking for the last Ogg page.
          */
         File(IOStream *stream, bool readProperties = true,
              Properties::ReadStyle propertiesStyle = Properties::Average);
@@ -125,7 +129,7 @@ namespace TagLib {
         static bool isSupported(IOStream *stream);
 
       private:
-        void read(bool readProperties);
+        void read(bool readProperties, Properties::ReadStyle propertiesStyle);
 
         class FilePrivate;
         TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
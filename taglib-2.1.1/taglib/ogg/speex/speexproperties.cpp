@@ -58,7 +58,7 @@ Speex::Properties::Properties(File *file, ReadStyle style) :
   AudioProperties(style),
   d(std::make_unique<PropertiesPrivate>())
 {
-  read(file);
+  read(file, style);
 }
 
 Speex::Properties::~Properties() = default;
@@ -97,7 +97,7 @@ int Speex::Properties::speexVersion() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void Speex::Properties::read(File *file)
+void Speex::Properties::read(File *file, ReadStyle style)
 {
   // Get the identification header from the Ogg implementation.
 
@@ -146,8 +146,11 @@ void Speex::Properties::read(File *file)
   // frames_per_packet;      /**< Number of frames stored per Ogg packet */
   // unsigned int framesPerPacket = data.mid(pos, 4).toUInt(false);
 
+  // The last page is found by searching backwards from the end of the file,
+  // which is skipped when only the tags are wanted.
+
   const Ogg::PageHeader *first = file->firstPageHeader();
-  const Ogg::PageHeader *last  = file->lastPageHeader();
+  const Ogg::PageHeader *last  = style != TagsOnly ? file->lastPageHeader() : nullptr;
 
   if(first && last) {
     const long long start = first->absoluteGranularPosition();
@@ -171,6 +174,19 @@ void Speex::Properties::read(File *file)
             "end of this file was incorrect or the sample rate is zero.");
     }
   }
+  else if(style == TagsOnly) {
+    // Without the last page the length is estimated from the bitrate in the
+    // header, taking everything behind the header packets as audio.  VBR
+    // streams usually leave the bitrate at -1, their length stays unknown.
+    if(d->bitrateNominal > 0) {
+      offset_t streamLength = file->length();
+      for(unsigned int i = 0; i < 2; ++i) {
+        streamLength -= file->packet(i).size();
+      }
+      if(streamLength > 0)
+        d->length = static_cast<int>(static_cast<double>(streamLength) * 8000.0 / d->bitrateNominal + 0.5);
+    }
+  }
   else
     debug("Speex::Properties::read() -- Could not find valid first and last Ogg pages.");
 
@@ -61,7 +61,7 @@ Vorbis::Properties::Properties(File *file, ReadStyle style) :
   AudioProperties(style),
   d(std::make_unique<PropertiesPrivate>())
 {
-  read(file);
+  read(file, style);
 }
 
 Vorbis::Properties::~Properties() = default;
@@ -110,7 +110,7 @@ int Vorbis::Properties::bitrateMinimum() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void Vorbis::Properties::read(File *file)
+void Vorbis::Properties::read(File *file, ReadStyle style)
 {
   // Get the identification header from the Ogg implementation.
 
@@ -149,8 +149,11 @@ void Vorbis::Properties::read(File *file)
   // Find the length of the file.  See http://wiki.xiph.org/VorbisStreamLength/
   // for my notes on the topic.
 
+  // The last page is found by searching backwards from the end of the file,
+  // which is skipped when only the tags are wanted.
+
   const Ogg::PageHeader *first = file->firstPageHeader();
-  const Ogg::PageHeader *last  = file->lastPageHeader();
+  const Ogg::PageHeader *last  = style != TagsOnly ? file->lastPageHeader() : nullptr;
 
   if(first && last) {
     const long long start = first->absoluteGranularPosition();
@@ -174,6 +177,18 @@ void Vorbis::Properties::read(File *file)
             "end of this file was incorrect or the sample rate is zero.");
     }
   }
+  else if(style == TagsOnly) {
+    // Without the last page the length is estimated from the nominal
+    // bitrate, taking everything behind the header packets as audio.
+    if(d->bitrateNominal > 0) {
+      offset_t streamLength = file->length();
+      for(unsigned int i = 0; i < 3; ++i) {
+        streamLength -= file->packet(i).size();
+      }
+      if(streamLength > 0)
+        d->length = static_cast<int>(static_cast<double>(streamLength) * 8000.0 / d->bitrateNominal + 0.5);
+    }
+  }
   else
     debug("Vorbis::Properties::read() -- Could not find valid first and last Ogg pages.");
 
@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "tdebug.h"
+#include "tfilecursor.h"
 #include "riffutils.h"
 
 using namespace TagLib;
@@ -282,30 +283,33 @@ void RIFF::File::removeChunk(const ByteVector &name)
 void RIFF::File::read()
 {
   const bool bigEndian = d->endianness == BigEndian;
+  const offset_t fileLength = length();
 
   offset_t offset = tell();
 
   offset += 4;
   d->sizeOffset = offset;
 
-  seek(offset);
-  d->size = readBlock(4).toUInt(bigEndian);
+  // The chunk headers are parsed from buffered windows of the file.
+
+  FileCursor cursor(this, offset);
+  d->size = cursor.readUInt(bigEndian);
 
   offset += 8;
 
   // + 8: chunk header at least, fix for additional junk bytes
-  while(offset + 8 <= length()) {
+  while(offset + 8 <= fileLength) {
 
-    seek(offset);
-    const ByteVector   chnkName = readBlock(4);
-    const unsigned int chunkSize = readBlock(4).toUInt(bigEndian);
+    cursor.seek(offset);
+    const ByteVector   chnkName = cursor.readBlock(4);
+    const unsigned int chunkSize = cursor.readUInt(bigEndian);
 
     if(!isValidChunkName(chnkName)) {
       debug("RIFF::File::read() -- Chunk '" + chnkName + "' has invalid ID");
       break;
     }
 
-    if(static_cast<long long>(offset) + 8 + chunkSize > length()) {
+    if(static_cast<long long>(offset) + 8 + chunkSize > fileLength) {
       debug("RIFF::File::read() -- Chunk '" + chnkName + "' has invalid size (larger than the file size)");
       break;
     }
@@ -321,12 +325,12 @@ void RIFF::File::read()
     // Check padding
 
     if(offset & 1) {
-      seek(offset);
-      if(const ByteVector iByte = readBlock(1); iByte.size() == 1) {
+      cursor.seek(offset);
+      if(const ByteVector iByte = cursor.readBlock(1); iByte.size() == 1) {
         bool skipPadding = iByte[0] == '\0';
         if(!skipPadding) {
           // Padding byte is not zero, check if it is good to ignore it
-          if(const ByteVector fourCcAfterPadding = readBlock(4);
+          if(const ByteVector fourCcAfterPadding = cursor.readBlock(4);
              isValidChunkName(fourCcAfterPadding)) {
             // Use the padding, it is followed by a valid chunk name.
             skipPadding = true;
@@ -25,6 +25,7 @@
 
 #include "infotag.h"
 
+#include <atomic>
 #include <utility>
 
 #include "tbytevector.h"
@@ -37,7 +38,7 @@ using namespace RIFF::Info;
 namespace
 {
   const RIFF::Info::StringHandler defaultStringHandler;
-  const RIFF::Info::StringHandler *stringHandler = &defaultStringHandler;
+  std::atomic<const RIFF::Info::StringHandler *> stringHandler { &defaultStringHandler };
 } // namespace
 
 class RIFF::Info::Tag::TagPrivate
@@ -218,12 +219,13 @@ void RIFF::Info::Tag::removeUnsupportedProperties(const StringList &props)
 
 PropertyMap RIFF::Info::Tag::setProperties(const PropertyMap &props)
 {
-  static Map<String, ByteVector> idForPropertyKey;
-  if(idForPropertyKey.isEmpty()) {
+  static const Map<String, ByteVector> idForPropertyKey = [] {
+    Map<String, ByteVector> m;
     for(const auto &[id, key] : propertyKeyForId) {
-      idForPropertyKey[key] = id;
+      m[key] = id;
     }
-  }
+    return m;
+  }();
 
   const PropertyMap origProps = properties();
   for(const auto &[key, _] : origProps) {
@@ -277,10 +279,11 @@ void RIFF::Info::Tag::removeField(const ByteVector &id)
 
 ByteVector RIFF::Info::Tag::render() const
 {
+  const StringHandler *const handler = stringHandler;
   ByteVector data("INFO");
 
   for(const auto &[field, list] : std::as_const(d->fieldListMap)) {
-    ByteVector text = stringHandler->render(list);
+    ByteVector text = handler->render(list);
     if(text.isEmpty())
       continue;
 
@@ -312,6 +315,7 @@ void RIFF::Info::Tag::setStringHandler(const StringHandler *handler)
 
 void RIFF::Info::Tag::parse(const ByteVector &data)
 {
+  const StringHandler *const handler = stringHandler;
   unsigned int p = 4;
   while(p < data.size()) {
     const unsigned int size = data.toUInt(p + 4, false);
@@ -319,7 +323,7 @@ void RIFF::Info::Tag::parse(const ByteVector &data)
       break;
 
     if(const ByteVector id = data.mid(p, 4); isValidChunkName(id)) {
-      const String text = stringHandler->parse(data.mid(p + 8, size));
+      const String text = handler->parse(data.mid(p + 8, size));
       d->fieldListMap[id] = text;
     }
 
@@ -180,7 +180,8 @@ namespace TagLib {
        * released and default UTF-8 handler is restored.
        *
        * \note The caller is responsible for deleting the previous handler
-       * as needed after it is released.
+       * as needed after it is released.  Like the ID3v1 handler, it is shared
+       * by all threads and may still be in use by them when this returns.
        *
        * \see StringHandler
        */
@@ -29,6 +29,7 @@
 
 #if !defined(NDEBUG) || defined(TRACE_IN_RELEASE)
 
+#include <atomic>
 #include <bitset>
 
 #include "tdebug.h"
@@ -39,22 +40,23 @@
 namespace TagLib
 {
   // The instance is defined in tdebuglistener.cpp.
-  extern DebugListener *debugListener;
+  extern std::atomic<DebugListener *> debugListener;
 
   void debug(const String &s)
   {
-    debugListener->printMessage("TagLib: " + s + "\n");
+    debugListener.load()->printMessage("TagLib: " + s + "\n");
   }
 
   void debugData(const ByteVector &v)
   {
+    DebugListener *const listener = debugListener;
     for(unsigned int i = 0; i < v.size(); ++i) {
       const std::string bits = std::bitset<8>(v[i]).to_string();
       const String msg = Utils::formatString(
         "*** [%u] - char '%c' - int %d, 0x%02x, 0b%s\n",
         i, v[i], v[i], v[i], bits.c_str());
 
-      debugListener->printMessage(msg);
+      listener->printMessage(msg);
     }
   }
 }  // namespace TagLib
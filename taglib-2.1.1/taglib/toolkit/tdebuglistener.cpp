@@ -25,6 +25,7 @@
 
 #include "tdebuglistener.h"
 
+#include <atomic>
 #include <iostream>
 
 #ifdef _WIN32
@@ -68,7 +69,7 @@ namespace TagLib
   {
   };
 
-  DebugListener *debugListener = &defaultListener;
+  std::atomic<DebugListener *> debugListener { &defaultListener };
 
   DebugListener::DebugListener() = default;
 
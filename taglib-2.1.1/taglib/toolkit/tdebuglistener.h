@@ -66,7 +66,8 @@ namespace TagLib
    * and the default stderr listener is restored.
    *
    * \note The caller is responsible for deleting the previous listener
-   * as needed after it is released.
+   * as needed after it is released.  TagLib may print messages from several
+   * threads at once, so printMessage() has to be thread-safe.
    *
    * \see DebugListener
    */
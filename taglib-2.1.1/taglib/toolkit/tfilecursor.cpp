@@ -0,0 +1,93 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tfilecursor.h"
+
+#include "tfile.h"
+
+using namespace TagLib;
+
+FileCursor::FileCursor(File *file, offset_t offset, unsigned int bufferSize) :
+  file(file),
+  bufferSize(bufferSize),
+  position(offset)
+{
+}
+
+offset_t FileCursor::offset() const
+{
+  return position;
+}
+
+void FileCursor::seek(offset_t offset)
+{
+  position = offset;
+}
+
+ByteVector FileCursor::readBlock(unsigned int length)
+{
+  // Blocks that don't fit into the buffer are read directly.
+
+  if(length > bufferSize) {
+    file->seek(position);
+    position += length;
+    return file->readBlock(length);
+  }
+
+  const unsigned int index = fill(length);
+  position += length;
+  return buffer.mid(index, length);
+}
+
+unsigned short FileCursor::readUShort(bool mostSignificantByteFirst)
+{
+  const unsigned int index = fill(2);
+  position += 2;
+  return buffer.mid(index, 2).toUShort(mostSignificantByteFirst);
+}
+
+unsigned int FileCursor::readUInt(bool mostSignificantByteFirst)
+{
+  const unsigned int index = fill(4);
+  position += 4;
+  return buffer.mid(index, 4).toUInt(mostSignificantByteFirst);
+}
+
+long long FileCursor::readLongLong(bool mostSignificantByteFirst)
+{
+  const unsigned int index = fill(8);
+  position += 8;
+  return buffer.mid(index, 8).toLongLong(mostSignificantByteFirst);
+}
+
+unsigned int FileCursor::fill(unsigned int length)
+{
+  if(position < bufferOffset || position + length > bufferOffset + buffer.size()) {
+    file->seek(position);
+    buffer = file->readBlock(bufferSize);
+    bufferOffset = position;
+  }
+
+  return static_cast<unsigned int>(position - bufferOffset);
+}
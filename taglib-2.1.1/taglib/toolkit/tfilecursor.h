@@ -0,0 +1,89 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_TFILECURSOR_H
+#define TAGLIB_TFILECURSOR_H
+
+#include "taglib.h"
+#include "tbytevector.h"
+
+// THIS FILE IS NOT A PART OF THE TAGLIB API
+
+#ifndef DO_NOT_DOCUMENT  // tell Doxygen not to document this header
+
+namespace TagLib {
+
+  class File;
+
+  /*!
+   * Reads a file through a buffered window that is refilled as the cursor
+   * moves.  Walking a table of chunk headers with it costs one read per
+   * window instead of a seek and several reads per chunk.
+   *
+   * Like File::readBlock(), reads near the end of the file return less data
+   * and numbers are converted from what is available.
+   */
+  class FileCursor
+  {
+  public:
+    static constexpr unsigned int DefaultBufferSize = 16 * 1024;
+
+    FileCursor(File *file, offset_t offset, unsigned int bufferSize = DefaultBufferSize);
+
+    /*!
+     * Returns the position of the cursor in the file.
+     */
+    offset_t offset() const;
+
+    /*!
+     * Moves the cursor to \a offset, without reading anything yet.
+     */
+    void seek(offset_t offset);
+
+    /*!
+     * Reads \a length bytes and moves past them.
+     */
+    ByteVector readBlock(unsigned int length);
+
+    unsigned short readUShort(bool mostSignificantByteFirst);
+    unsigned int readUInt(bool mostSignificantByteFirst);
+    long long readLongLong(bool mostSignificantByteFirst);
+
+  private:
+    // Makes sure the buffer holds length bytes from the cursor on, as far as
+    // the file has them, and returns the index of the cursor in the buffer.
+    unsigned int fill(unsigned int length);
+
+    File *file;
+    const unsigned int bufferSize;
+    ByteVector buffer;
+    offset_t bufferOffset { 0 };
+    offset_t position;
+  };
+
+}  // namespace TagLib
+
+#endif
+
+#endif
@@ -28,11 +28,17 @@
 #ifdef _WIN32
 # include <windows.h>
 #else
+# include <cerrno>
 # include <climits>
-# include <cstdio>
+# include <cstring>
+# include <fcntl.h>
+# include <sys/stat.h>
 # include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 #include "tstring.h"
 #include "tdebug.h"
 
@@ -108,36 +114,69 @@ namespace
     operator FileName () const { return c_str(); }
   };
 
-  using FileHandle = FILE *;
+  // Uses a plain file descriptor with positional reads and writes, so that
+  // seeking is free and each read or write is a single system call.
+
+  using FileHandle = int;
 
-  const FileHandle InvalidFileHandle = nullptr;
+  const FileHandle InvalidFileHandle = -1;
 
   FileHandle openFile(const FileName &path, bool readOnly)
   {
-    return fopen(path, readOnly ? "rb" : "rb+");
+    return open(path, readOnly ? O_RDONLY : O_RDWR);
   }
 
   FileHandle openFile(const int fileDescriptor, bool readOnly)
   {
-    return fdopen(fileDescriptor, readOnly ? "rb" : "rb+");
+    // The descriptor is taken over as it is, so it has to allow the
+    // requested access.
+    const int flags = fcntl(fileDescriptor, F_GETFL);
+    if(flags == -1)
+      return InvalidFileHandle;
+
+    const int mode = flags & O_ACCMODE;
+    if(mode == O_WRONLY || (!readOnly && mode != O_RDWR))
+      return InvalidFileHandle;
+
+    return fileDescriptor;
   }
 
   void closeFile(FileHandle file)
   {
-    fclose(file);
+    close(file);
   }
 
-  size_t readFile(FileHandle file, ByteVector &buffer)
+  size_t readFile(FileHandle file, char *data, size_t length, offset_t position)
   {
-    return fread(buffer.data(), sizeof(char), buffer.size(), file);
+    size_t count = 0;
+    while(count < length) {
+      const ssize_t result = pread(file, data + count, length - count,
+                                   static_cast<off_t>(position + count));
+      if(result > 0)
+        count += static_cast<size_t>(result);
+      else if(result == 0 || errno != EINTR)
+        break;
+    }
+    return count;
   }
 
-  size_t writeFile(FileHandle file, const ByteVector &buffer)
+  size_t writeFile(FileHandle file, const char *data, size_t length, offset_t position)
   {
-    return fwrite(buffer.data(), sizeof(char), buffer.size(), file);
+    size_t count = 0;
+    while(count < length) {
+      const ssize_t result = pwrite(file, data + count, length - count,
+                                    static_cast<off_t>(position + count));
+      if(result > 0)
+        count += static_cast<size_t>(result);
+      else if(result == 0 || errno != EINTR)
+        break;
+    }
+    return count;
   }
 
 #endif  // _WIN32
+
+  constexpr unsigned int DefaultReadAheadSize = 16 * 1024;
 }  // namespace
 
 class FileStream::FileStreamPrivate
@@ -148,11 +187,113 @@ public:
   {
   }
 
+  // Reads buffer.size() bytes at the current position and moves past them.
+  size_t read(ByteVector &buffer);
+  // Writes data at the current position and moves past it.
+  size_t write(const ByteVector &data);
+
   FileHandle file { InvalidFileHandle };
   FileNameHandle name;
   bool readOnly { true };
+
+  // Size of the file, or -1 if it has to be asked for again.  Only writes
+  // through this stream change it.
+  offset_t length { -1 };
+
+  unsigned int readAheadSize { DefaultReadAheadSize };
+
+#ifndef _WIN32
+
+  offset_t position { 0 };
+
+  // Reads shorter than readAheadSize are served from this window, which
+  // covers the headers and chunk tables a parser walks with small reads.
+  std::vector<char> readAhead;
+  offset_t readAheadOffset { 0 };
+  size_t readAheadLength { 0 };
+
+#endif
 };
 
+#ifdef _WIN32
+
+size_t FileStream::FileStreamPrivate::read(ByteVector &buffer)
+{
+  return readFile(file, buffer);
+}
+
+size_t FileStream::FileStreamPrivate::write(const ByteVector &data)
+{
+  length = -1;
+  return writeFile(file, data);
+}
+
+#else
+
+size_t FileStream::FileStreamPrivate::read(ByteVector &buffer)
+{
+  const size_t size = buffer.size();
+
+  if(position >= readAheadOffset &&
+     position + static_cast<offset_t>(size) <= readAheadOffset + static_cast<offset_t>(readAheadLength)) {
+    ::memcpy(buffer.data(), readAhead.data() + (position - readAheadOffset), size);
+    position += size;
+    return size;
+  }
+
+  // Nothing to read at or past the end of the file
+  if(length >= 0 && position >= length)
+    return 0;
+
+  size_t count;
+  if(size < readAheadSize) {
+    offset_t start = position;
+
+    // Reads in front of the window are often part of a backward scan, as in
+    // File::rfind() or the MPEG frame search, so center the new window on
+    // the block.
+    if(position < readAheadOffset)
+      start = std::max<offset_t>(position - (readAheadSize - size) / 2, 0);
+
+    readAhead.resize(readAheadSize);
+    readAheadOffset = start;
+    readAheadLength = readFile(file, readAhead.data(), readAheadSize, start);
+
+    const auto skip = static_cast<size_t>(position - start);
+    count = readAheadLength > skip ? std::min(size, readAheadLength - skip) : 0;
+    ::memcpy(buffer.data(), readAhead.data() + skip, count);
+  }
+  else {
+    count = readFile(file, buffer.data(), size, position);
+  }
+
+  position += count;
+  return count;
+}
+
+size_t FileStream::FileStreamPrivate::write(const ByteVector &data)
+{
+  const size_t count = writeFile(file, data.data(), data.size(), position);
+  const offset_t end = position + count;
+
+  // Keep the part of the read-ahead window that was overwritten up to date.
+  const offset_t windowEnd = readAheadOffset + readAheadLength;
+  if(position < windowEnd && end > readAheadOffset) {
+    const offset_t first = std::max(position, readAheadOffset);
+    const offset_t last = std::min(end, windowEnd);
+    ::memcpy(readAhead.data() + (first - readAheadOffset),
+             data.data() + (first - position), static_cast<size_t>(last - first));
+  }
+
+  position = end;
+  if(length >= 0 && position > length)
+    length = position;
+
+  return count;
+}
+
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // public members
 ////////////////////////////////////////////////////////////////////////////////
@@ -191,8 +332,15 @@ FileStream::FileStream(int fileDescriptor, bool openReadOnly) :
   else
     d->file = openFile(fileDescriptor, true);
 
-  if(d->file == InvalidFileHandle)
+  if(d->file == InvalidFileHandle) {
     debug("Could not open file using file descriptor");
+    return;
+  }
+
+#ifndef _WIN32
+  // Like a stdio stream opened on the descriptor, start at its offset.
+  d->position = std::max<offset_t>(lseek(d->file, 0, SEEK_CUR), 0);
+#endif
 }
 
 FileStream::~FileStream()
@@ -225,7 +373,7 @@ ByteVector FileStream::readBlock(size_t length)
 
   ByteVector buffer(static_cast<unsigned int>(length));
 
-  const size_t count = readFile(d->file, buffer);
+  const size_t count = d->read(buffer);
   buffer.resize(static_cast<unsigned int>(count));
 
   return buffer;
@@ -243,7 +391,7 @@ void FileStream::writeBlock(const ByteVector &data)
     return;
   }
 
-  writeFile(d->file, data);
+  d->write(data);
 }
 
 void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
@@ -298,7 +446,7 @@ void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
     // to overwrite.  Appropriately increment the readPosition.
 
     seek(readPosition);
-    const auto bytesRead = static_cast<unsigned int>(readFile(d->file, aboutToOverwrite));
+    const auto bytesRead = static_cast<unsigned int>(d->read(aboutToOverwrite));
     aboutToOverwrite.resize(bytesRead);
     readPosition += bufferLength;
 
@@ -344,7 +492,7 @@ void FileStream::removeBlock(offset_t start, size_t length)
   unsigned int bytesRead = UINT_MAX;
   while(bytesRead != 0) {
     seek(readPosition);
-    bytesRead = static_cast<unsigned int>(readFile(d->file, buffer));
+    bytesRead = static_cast<unsigned int>(d->read(buffer));
     readPosition += bytesRead;
 
     // Check to see if we just read the last block.  We need to call clear()
@@ -356,7 +504,7 @@ void FileStream::removeBlock(offset_t start, size_t length)
     }
 
     seek(writePosition);
-    writeFile(d->file, buffer);
+    d->write(buffer);
 
     writePosition += bytesRead;
   }
@@ -397,38 +545,32 @@ void FileStream::seek(offset_t offset, Position p)
 
 #else
 
-  int whence;
+  offset_t position;
   switch(p) {
   case Beginning:
-    whence = SEEK_SET;
+    position = offset;
     break;
   case Current:
-    whence = SEEK_CUR;
+    position = d->position + offset;
     break;
   case End:
-    whence = SEEK_END;
+    position = length() + offset;
     break;
   default:
     debug("FileStream::seek() -- Invalid Position value.");
     return;
   }
 
-  fseek(d->file, offset, whence);
+  // Seeking before the start of the file fails and keeps the position.
+  if(position >= 0)
+    d->position = position;
 
 #endif
 }
 
 void FileStream::clear()
 {
-#ifdef _WIN32
-
-  // NOP
-
-#else
-
-  clearerr(d->file);
-
-#endif
+  // NOP, reads and writes do not leave sticky end-of-file or error flags.
 }
 
 offset_t FileStream::tell() const
@@ -447,7 +589,7 @@ offset_t FileStream::tell() const
 
 #else
 
-  return ftell(d->file);
+  return d->position;
 
 #endif
 }
@@ -459,12 +601,16 @@ offset_t FileStream::length()
     return 0;
   }
 
+  if(d->length >= 0)
+    return d->length;
+
 #ifdef _WIN32
 
   LARGE_INTEGER fileSize;
 
   if(GetFileSizeEx(d->file, &fileSize)) {
-    return fileSize.QuadPart;
+    d->length = fileSize.QuadPart;
+    return d->length;
   }
 
   debug("FileStream::length() -- Failed to get the file size.");
@@ -472,18 +618,29 @@ offset_t FileStream::length()
 
 #else
 
-  const offset_t curpos = tell();
-
-  seek(0, End);
-  const offset_t endpos = tell();
+  if(struct stat st; fstat(d->file, &st) == 0 && S_ISREG(st.st_mode)) {
+    d->length = st.st_size;
+    return d->length;
+  }
 
-  seek(curpos, Beginning);
+  // Not a regular file, ask for the end offset.  Reads and writes carry their
+  // own position, so moving the descriptor's offset does no harm.
 
-  return endpos;
+  return lseek(d->file, 0, SEEK_END);
 
 #endif
 }
 
+void FileStream::setReadAheadSize(unsigned int size)
+{
+  d->readAheadSize = size;
+}
+
+unsigned int FileStream::readAheadSize() const
+{
+  return d->readAheadSize;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // protected members
 ////////////////////////////////////////////////////////////////////////////////
@@ -496,6 +653,7 @@ void FileStream::truncate(offset_t length)
 
   seek(length);
 
+  d->length = -1;
   if(!SetEndOfFile(d->file)) {
     debug("FileStream::truncate() -- Failed to truncate the file.");
   }
@@ -504,9 +662,14 @@ void FileStream::truncate(offset_t length)
 
 #else
 
-  fflush(d->file);
-  if(const int error = ftruncate(fileno(d->file), length); error != 0)
+  d->readAheadLength = 0;
+  if(const int error = ftruncate(d->file, length); error != 0) {
     debug("FileStream::truncate() -- Couldn't truncate the file.");
+    d->length = -1;
+  }
+  else {
+    d->length = length;
+  }
 
 #endif
 }
@@ -139,6 +139,23 @@ namespace TagLib {
      */
     void truncate(offset_t length) override;
 
+    /*!
+     * Sets the size of the read-ahead window.  Reads shorter than \a size
+     * fetch a whole window from the file, so walking headers with small
+     * reads costs one system call per window instead of one per read.  The
+     * default is 16 KiB, 0 disables read-ahead.
+     *
+     * \note This has no effect on Windows.
+     */
+    void setReadAheadSize(unsigned int size);
+
+    /*!
+     * Returns the size of the read-ahead window.
+     *
+     * \see setReadAheadSize()
+     */
+    unsigned int readAheadSize() const;
+
   protected:
 
     /*!
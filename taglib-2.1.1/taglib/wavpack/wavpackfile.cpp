@@ -73,20 +73,20 @@ bool WavPack::File::isSupported(IOStream *stream)
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
-WavPack::File::File(FileName file, bool readProperties, Properties::ReadStyle) :
+WavPack::File::File(FileName file, bool readProperties, Properties::ReadStyle propertiesStyle) :
   TagLib::File(file),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
-WavPack::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle) :
+WavPack::File::File(IOStream *stream, bool readProperties, Properties::ReadStyle propertiesStyle) :
   TagLib::File(stream),
   d(std::make_unique<FilePrivate>())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties, propertiesStyle);
 }
 
 WavPack::File::~File() = default;
@@ -227,7 +227,7 @@ bool WavPack::File::hasAPETag() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void WavPack::File::read(bool readProperties)
+void WavPack::File::read(bool readProperties, Properties::ReadStyle propertiesStyle)
 {
   // Look for an ID3v1 tag
 
@@ -262,6 +262,6 @@ void WavPack::File::read(bool readProperties)
     else
       streamLength = length();
 
-    d->properties = std::make_unique<Properties>(this, streamLength);
+    d->properties = std::make_unique<Properties>(this, streamLength, propertiesStyle);
   }
 }
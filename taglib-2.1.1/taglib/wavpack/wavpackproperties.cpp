@@ -30,6 +30,7 @@
 #include "wavpackproperties.h"
 
 #include <cstdint>
+#include <algorithm>
 #include <array>
 
 #include "tstring.h"
@@ -62,7 +63,7 @@ WavPack::Properties::Properties(File *file, offset_t streamLength, ReadStyle sty
   AudioProperties(style),
   d(std::make_unique<PropertiesPrivate>())
 {
-  read(file, streamLength);
+  read(file, streamLength, style);
 }
 
 WavPack::Properties::~Properties() = default;
@@ -135,6 +136,10 @@ unsigned int WavPack::Properties::sampleFrames() const
 #define ID_LARGE                0x80
 #define ID_SAMPLE_RATE          (ID_OPTIONAL_DATA | 0x7)
 
+#define MIN_WINDOW_SIZE         (64 * 1024)
+#define MAX_WINDOW_SIZE         (1024 * 1024)
+#define MAX_SCAN_LENGTH         (4 * 1024 * 1024)
+
 namespace
 {
   constexpr std::array sampleRates {
@@ -230,7 +235,7 @@ namespace
 
 }  // namespace
 
-void WavPack::Properties::read(File *file, offset_t streamLength)
+void WavPack::Properties::read(File *file, offset_t streamLength, ReadStyle style)
 {
   offset_t offset = 0;
 
@@ -303,7 +308,7 @@ void WavPack::Properties::read(File *file, offset_t streamLength)
   }
 
   if(d->sampleFrames == ~0u)
-    d->sampleFrames = seekFinalIndex(file, streamLength);
+    d->sampleFrames = style != TagsOnly ? seekFinalIndex(file, streamLength) : 0;
 
   if(d->sampleFrames > 0 && d->sampleRate > 0) {
     const auto length = static_cast<double>(d->sampleFrames) * 1000.0 / d->sampleRate;
@@ -314,33 +319,54 @@ void WavPack::Properties::read(File *file, offset_t streamLength)
 
 unsigned int WavPack::Properties::seekFinalIndex(File *file, offset_t streamLength)
 {
-  offset_t offset = streamLength;
+  // Only called when the first block does not carry the total number of
+  // samples.  The final block is found by reading windows backwards from the
+  // end of the stream and scanning them in memory, starting small because
+  // the last block usually holds less than a second of audio.  The search
+  // gives up after a few MiB, so that a truncated or corrupt file is not
+  // read backwards all the way to its start.
 
-  while (offset >= 32) {
-    offset = file->rfind("wvpk", offset - 4);
+  static const ByteVector blockId("wvpk", 4);
 
-    if(offset == -1)
-      return 0;
+  offset_t windowEnd = streamLength;
+  offset_t windowSize = MIN_WINDOW_SIZE;
 
-    file->seek(offset);
-    const ByteVector data = file->readBlock(32);
-    if(data.size() < 32)
-      return 0;
+  while(windowEnd > 0) {
+    if(streamLength - windowEnd >= MAX_SCAN_LENGTH) {
+      debug("WavPack::Properties::seekFinalIndex() -- No final block found near the end of the stream.");
+      break;
+    }
 
-    const unsigned int blockSize    = data.toUInt(4, false);
-    const unsigned int blockIndex   = data.toUInt(16, false);
-    const unsigned int blockSamples = data.toUInt(20, false);
-    const unsigned int flags        = data.toUInt(24, false);
-    const int vers                  = data.toShort(8, false);
+    const offset_t windowStart = std::max<offset_t>(windowEnd - windowSize, 0);
+
+    // Headers beginning in the window may extend up to 31 bytes past it
 
-    // try not to trigger on a spurious "wvpk" in WavPack binary block data
+    file->seek(windowStart);
+    const ByteVector data = file->readBlock(static_cast<size_t>(windowEnd - windowStart) + 31);
 
-    if(vers < MIN_STREAM_VERS || vers > MAX_STREAM_VERS || (blockSize & 1) ||
-      blockSize < 24 || blockSize >= 1048576 || blockSamples > 131072)
+    for(auto index = static_cast<int>(windowEnd - windowStart) - 1; index >= 0; --index) {
+      if(data.size() < static_cast<unsigned int>(index) + 32 || data[index] != 'w' ||
+         !data.containsAt(blockId, index))
         continue;
 
-    if (blockSamples && (flags & FINAL_BLOCK))
-      return blockIndex + blockSamples;
+      const unsigned int blockSize    = data.toUInt(index + 4, false);
+      const unsigned int blockIndex   = data.toUInt(index + 16, false);
+      const unsigned int blockSamples = data.toUInt(index + 20, false);
+      const unsigned int flags        = data.toUInt(index + 24, false);
+      const int vers                  = data.toShort(index + 8, false);
+
+      // try not to trigger on a spurious "wvpk" in WavPack binary block data
+
+      if(vers < MIN_STREAM_VERS || vers > MAX_STREAM_VERS || (blockSize & 1) ||
+        blockSize < 24 || blockSize >= 1048576 || blockSamples > 131072)
+          continue;
+
+      if(blockSamples && (flags & FINAL_BLOCK))
+        return blockIndex + blockSamples;
+    }
+
+    windowEnd  = windowStart;
+    windowSize = std::min<offset_t>(windowSize * 2, MAX_WINDOW_SIZE);
   }
 
   return 0;
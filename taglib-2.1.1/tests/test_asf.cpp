@@ -28,9 +28,11 @@
 
 #include "tstringlist.h"
 #include "tbytevectorlist.h"
+#include "tbytevectorstream.h"
 #include "tpropertymap.h"
 #include "tag.h"
 #include "asffile.h"
+#include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
 
@@ -53,6 +55,7 @@ class TestASF : public CppUnit::TestFixture
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testPropertiesAllSupported);
   CPPUNIT_TEST(testRepeatedSave);
+  CPPUNIT_TEST(testHeaderReads);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -404,6 +407,23 @@ public:
     CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(68202), f.length());
   }
 
+  void testHeaderReads()
+  {
+    // One read for the size of the header object and one for all of it
+    CountingStream stream(PlainFile(TEST_FILE_PATH_C("silence-1.wma")).readAll());
+    ASF::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(String("test"), f.tag()->title());
+    CPPUNIT_ASSERT_EQUAL(String("Windows Media Audio 9.1"), f.audioProperties()->codecName());
+    CPPUNIT_ASSERT_EQUAL(2, stream.reads);
+
+    if(const long before = readSyscalls(); before >= 0) {
+      ASF::File file(TEST_FILE_PATH_C("silence-1.wma"));
+      CPPUNIT_ASSERT(file.isValid());
+      CPPUNIT_ASSERT(readSyscalls() - before <= 4);
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestASF);
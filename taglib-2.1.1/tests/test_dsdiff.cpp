@@ -25,6 +25,7 @@
 
 #include "tbytevectorlist.h"
 #include "tpropertymap.h"
+#include "tbytevectorstream.h"
 #include "dsdifffile.h"
 #include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
@@ -43,6 +44,8 @@ class TestDSDIFF : public CppUnit::TestFixture
   CPPUNIT_TEST(testStrip);
   CPPUNIT_TEST(testRepeatedSave);
   CPPUNIT_TEST(testId3InProp);
+  CPPUNIT_TEST(testReadSyscalls);
+  CPPUNIT_TEST(testChunkReads);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -337,6 +340,25 @@ public:
       CPPUNIT_ASSERT(!f.hasDIINTag());
     }
   }
+
+  void testReadSyscalls()
+  {
+    if(const long before = readSyscalls(); before >= 0) {
+      DSDIFF::File f(TEST_FILE_PATH_C("empty10ms.dff"));
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(readSyscalls() - before <= 4);
+    }
+  }
+
+  void testChunkReads()
+  {
+    // The root, PROP and DIIN chunk tables are walked in buffered windows
+    CountingStream stream(PlainFile(TEST_FILE_PATH_C("empty10ms.dff")).readAll());
+    DSDIFF::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(2822400, f.audioProperties()->sampleRate());
+    CPPUNIT_ASSERT(stream.reads <= 2);
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestDSDIFF);
@@ -24,6 +24,7 @@
  ***************************************************************************/
 
 #include "tfile.h"
+#include "tfilestream.h"
 #include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
@@ -37,6 +38,9 @@ class TestFile : public CppUnit::TestFixture
   CPPUNIT_TEST(testRFindInSmallFile);
   CPPUNIT_TEST(testSeek);
   CPPUNIT_TEST(testTruncate);
+  CPPUNIT_TEST(testLengthAfterWrite);
+  CPPUNIT_TEST(testReadAhead);
+  CPPUNIT_TEST(testFileDescriptor);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -139,6 +143,85 @@ public:
     }
   }
 
+  void testLengthAfterWrite()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    PlainFile f(name.c_str());
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4328), f.length());
+
+    // Writes through the stream are seen even while they are buffered
+    f.seek(4300);
+    f.writeBlock(ByteVector(100, 'x'));
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4400), f.length());
+    f.seek(0, File::End);
+    f.writeBlock(ByteVector(10, 'y'));
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4410), f.length());
+
+    f.truncate(1000);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(1000), f.length());
+    f.insert(ByteVector(24, 'z'), 10, 0);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(1024), f.length());
+    f.removeBlock(0, 512);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(512), f.length());
+  }
+
+  void testReadAhead()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    FileStream reference(name.c_str(), true);
+    reference.setReadAheadSize(0);
+    const ByteVector original = reference.readBlock(4328);
+
+    FileStream stream(name.c_str());
+    CPPUNIT_ASSERT_EQUAL(16U * 1024U, stream.readAheadSize());
+
+    // Small reads in both directions see the same bytes as unbuffered ones
+    for(offset_t offset : {0, 100, 4000, 4320, 50, 2000}) {
+      stream.seek(offset);
+      CPPUNIT_ASSERT_EQUAL(original.mid(static_cast<unsigned int>(offset), 16),
+                           stream.readBlock(16));
+      CPPUNIT_ASSERT_EQUAL(std::min<offset_t>(offset + 16, 4328), stream.tell());
+    }
+
+    // Writes show up in the read-ahead window
+    stream.seek(10);
+    CPPUNIT_ASSERT_EQUAL(original.mid(10, 4), stream.readBlock(4));
+    stream.seek(12);
+    stream.writeBlock(ByteVector("abcd"));
+    stream.seek(10);
+    CPPUNIT_ASSERT_EQUAL(original.mid(10, 2) + ByteVector("abcd"), stream.readBlock(6));
+
+    stream.truncate(2000);
+    stream.seek(1990);
+    CPPUNIT_ASSERT_EQUAL(original.mid(1990, 10), stream.readBlock(100));
+    stream.seek(3000);
+    CPPUNIT_ASSERT(stream.readBlock(16).isEmpty());
+  }
+
+  void testFileDescriptor()
+  {
+#ifndef _WIN32
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    const int fd = ::open(name.c_str(), O_RDONLY);
+    CPPUNIT_ASSERT(fd != -1);
+    ::lseek(fd, 100, SEEK_SET);
+
+    // A read only descriptor can't be written, the stream starts at its offset
+    FileStream stream(fd);
+    CPPUNIT_ASSERT(stream.isOpen());
+    CPPUNIT_ASSERT(stream.readOnly());
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(100), stream.tell());
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4328), stream.length());
+    CPPUNIT_ASSERT_EQUAL(PlainFile(name.c_str()).readAll().mid(100, 8), stream.readBlock(8));
+#endif
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestFile);
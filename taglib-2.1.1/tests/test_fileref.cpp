@@ -29,6 +29,7 @@
 #include "taglib_config.h"
 #include "tfilestream.h"
 #include "tbytevectorstream.h"
+#include "plainfile.h"
 #include "tag.h"
 #include "fileref.h"
 #include "mpegfile.h"
@@ -108,6 +109,8 @@ class TestFileRef : public CppUnit::TestFixture
   CPPUNIT_TEST(testAudioProperties);
   CPPUNIT_TEST(testDefaultFileExtensions);
   CPPUNIT_TEST(testFileResolver);
+  CPPUNIT_TEST(testExtensionCase);
+  CPPUNIT_TEST(testContentDetectionReads);
 #ifdef TAGLIB_WITH_ASF
   CPPUNIT_TEST(testASF);
 #endif
@@ -412,6 +415,51 @@ public:
     CPPUNIT_ASSERT(f2.isNull());
   }
 
+  void testExtensionCase()
+  {
+    ScopedFileCopy copy("xing", ".Mp3");
+    FileRef f(copy.fileName().c_str());
+    CPPUNIT_ASSERT(!f.isNull());
+    CPPUNIT_ASSERT(dynamic_cast<MPEG::File *>(f.file()));
+  }
+
+  void testContentDetectionReads()
+  {
+    // The isSupported() checks share one header read, so opening a stream
+    // without an extension costs about as much as opening the right type.
+
+    const ByteVector data = PlainFile(TEST_FILE_PATH_C("xing.mp3")).readAll();
+    {
+      CountingStream stream(data);
+      const MPEG::File f(&stream);
+      const int direct = stream.reads;
+
+      CountingStream detected(data);
+      FileRef ref(&detected);
+      CPPUNIT_ASSERT(dynamic_cast<MPEG::File *>(ref.file()));
+      CPPUNIT_ASSERT(detected.reads <= direct + 1);
+    }
+#ifdef TAGLIB_WITH_DSF
+    const ByteVector dsfData = PlainFile(TEST_FILE_PATH_C("empty10ms.dsf")).readAll();
+    {
+      CountingStream stream(dsfData);
+      const DSF::File f(&stream);
+      const int direct = stream.reads;
+
+      CountingStream detected(dsfData);
+      FileRef ref(&detected);
+      CPPUNIT_ASSERT(dynamic_cast<DSF::File *>(ref.file()));
+      CPPUNIT_ASSERT(detected.reads <= direct + 1);
+    }
+#endif
+    {
+      CountingStream stream(ByteVector(4096, 'x'));
+      FileRef ref(&stream);
+      CPPUNIT_ASSERT(ref.isNull());
+      CPPUNIT_ASSERT_EQUAL(1, stream.reads);
+    }
+  }
+
   void testAudioProperties()
   {
     FileRef f(TEST_FILE_PATH_C("xing.mp3"));
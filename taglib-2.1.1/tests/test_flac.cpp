@@ -67,6 +67,9 @@ class TestFLAC : public CppUnit::TestFixture
   CPPUNIT_TEST(testRemoveXiphField);
   CPPUNIT_TEST(testEmptySeekTable);
   CPPUNIT_TEST(testPictureStoredAfterComment);
+  CPPUNIT_TEST(testLargePictures);
+  CPPUNIT_TEST(testLargePictureOverrunningBlock);
+  CPPUNIT_TEST(testLargeApplicationBlock);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -663,6 +666,124 @@ public:
     CPPUNIT_ASSERT(fileData.startsWith(expectedData));
   }
 
+
+  void testLargePictures()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    const ByteVector data1 = ByteVector(100000, 'a') + ByteVector("end1");
+    const ByteVector data2 = ByteVector(200000, 'b') + ByteVector("end2");
+
+    {
+      FLAC::File f(newname.c_str());
+      auto pic = new FLAC::Picture();
+      pic->setMimeType("image/png");
+      pic->setDescription("first");
+      pic->setData(data1);
+      f.addPicture(pic);
+      pic = new FLAC::Picture();
+      pic->setMimeType("image/jpeg");
+      pic->setDescription("second");
+      pic->setData(data2);
+      f.addPicture(pic);
+      f.save();
+    }
+    {
+      // Pictures beyond the first buffer keep their data in the file until
+      // it is needed; saving must still write them out correctly.
+
+      FLAC::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      f.xiphComment()->setTitle("Title");
+      f.save();
+    }
+    FLAC::Picture *removed = nullptr;
+    {
+      FLAC::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.xiphComment()->title());
+
+      const List<FLAC::Picture *> pictures = f.pictureList();
+      CPPUNIT_ASSERT_EQUAL(3U, pictures.size());
+      CPPUNIT_ASSERT_EQUAL(String("first"), pictures[1]->description());
+      CPPUNIT_ASSERT_EQUAL(String("image/png"), pictures[1]->mimeType());
+      CPPUNIT_ASSERT_EQUAL(data1, pictures[1]->data());
+      CPPUNIT_ASSERT_EQUAL(String("second"), pictures[2]->description());
+
+      removed = pictures[2];
+      f.removePicture(removed, false);
+    }
+    CPPUNIT_ASSERT_EQUAL(data2, removed->data());
+    delete removed;
+  }
+
+  void testLargePictureOverrunningBlock()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    {
+      FLAC::File f(newname.c_str());
+      auto pic = new FLAC::Picture();
+      pic->setMimeType("image/png");
+      pic->setDescription("overrun");
+      pic->setData(ByteVector(100000, 'a'));
+      f.addPicture(pic);
+      f.save();
+    }
+    {
+      // Let the picture data length claim more than the metadata block holds.
+
+      FLAC::File f(newname.c_str());
+      const offset_t lengthOffset = f.find("overrun") + 7 + 16;
+      f.seek(lengthOffset);
+      f.writeBlock(ByteVector::fromUInt(200000));
+    }
+    {
+      FLAC::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      const List<FLAC::Picture *> pictures = f.pictureList();
+      CPPUNIT_ASSERT_EQUAL(1U, pictures.size());
+      CPPUNIT_ASSERT(pictures[0]->description() != "overrun");
+    }
+  }
+
+  void testLargeApplicationBlock()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    const ByteVector payload = ByteVector("TEST") + ByteVector(100000, 'x') + ByteVector("end");
+
+    {
+      // Insert an APPLICATION block right after STREAMINFO.
+
+      FLAC::File f(newname.c_str());
+      const offset_t streamInfoEnd = f.find("fLaC") + 4 + 4 + 34;
+      ByteVector block = ByteVector::fromUInt(payload.size());
+      block[0] = static_cast<char>(FLAC::MetadataBlock::Application);
+      f.insert(block + payload, streamInfoEnd, 0);
+    }
+    {
+      FLAC::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(1U, f.pictureList().size());
+      f.xiphComment()->setTitle("Title");
+      f.save();
+    }
+    {
+      FLAC::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.xiphComment()->title());
+      CPPUNIT_ASSERT_EQUAL(1U, f.pictureList().size());
+
+      const offset_t blockOffset = f.find("TEST");
+      CPPUNIT_ASSERT(blockOffset > 0);
+      f.seek(blockOffset);
+      CPPUNIT_ASSERT_EQUAL(payload, f.readBlock(payload.size()));
+    }
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestFLAC);
@@ -85,12 +85,17 @@ class TestMP4 : public CppUnit::TestFixture
   CPPUNIT_TEST(testHasTag);
   CPPUNIT_TEST(testIsEmpty);
   CPPUNIT_TEST(testUpdateStco);
+  CPPUNIT_TEST(testUpdateCo64);
+  CPPUNIT_TEST(testPaddingReservation);
   CPPUNIT_TEST(testSaveExisingWhenIlstIsLast);
   CPPUNIT_TEST(test64BitAtom);
+  CPPUNIT_TEST(testAtomHeadersReadInBulk);
   CPPUNIT_TEST(testGnre);
   CPPUNIT_TEST(testCovrRead);
   CPPUNIT_TEST(testCovrWrite);
   CPPUNIT_TEST(testCovrRead2);
+  CPPUNIT_TEST(testCovrDeferred);
+  CPPUNIT_TEST(testCovrDeferredInvalid);
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testPropertiesAllSupported);
   CPPUNIT_TEST(testPropertiesMovement);
@@ -302,6 +307,100 @@ public:
     }
   }
 
+  void testUpdateCo64()
+  {
+    const auto atom = [](const char *name, const ByteVector &data) {
+      return ByteVector::fromUInt(static_cast<unsigned int>(data.size() + 8)) +
+             ByteVector(name) + data;
+    };
+
+    // An audiobook sized chunk table, alternating between entries that point
+    // in front of moov and entries behind it
+    constexpr unsigned int chunks = 100000;
+    ByteVector table = ByteVector(4, '\0') + ByteVector::fromUInt(chunks);
+    for(unsigned int i = 0; i < chunks; ++i)
+      table.append(ByteVector::fromLongLong(i % 2 ? 0x100000000LL + i : i % 8));
+
+    const ByteVector moov = atom("moov", atom("trak", atom("mdia", atom("minf",
+      atom("stbl", atom("co64", table))))));
+    CountingStream stream(atom("ftyp", "M4A \0\0\0\0") + moov +
+                          atom("mdat", ByteVector(16, '\0')));
+
+    {
+      MP4::File f(&stream, false);
+      CPPUNIT_ASSERT(f.isValid());
+      f.tag()->setTitle("Title");
+      stream.writes = 0;
+      CPPUNIT_ASSERT(f.save());
+      // The whole table is written back at once
+      CPPUNIT_ASSERT(stream.writes < 10);
+    }
+
+    MP4::File f(&stream, false);
+    MP4::Atoms atoms(&f);
+    const MP4::Atom *co64 = atoms.find("moov", "trak", "mdia", "minf")->find("stbl", "co64");
+    const auto delta = static_cast<long long>(atoms.find("moov")->length() - moov.size());
+    CPPUNIT_ASSERT(delta > 0);
+    f.seek(co64->offset() + 12);
+    const ByteVector data = f.readBlock(co64->length() - 12);
+    CPPUNIT_ASSERT_EQUAL(chunks, data.toUInt(0U));
+    for(unsigned int i = 0; i < chunks; ++i) {
+      const long long expected = i % 2 ? 0x100000000LL + i + delta : i % 8;
+      CPPUNIT_ASSERT_EQUAL(expected, data.toLongLong(4 + i * 8));
+    }
+  }
+
+  void testPaddingReservation()
+  {
+    ScopedFileCopy copy("no-tags", ".m4a");
+    string filename = copy.fileName();
+
+    offset_t length;
+    {
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT_EQUAL(4096U, f.tag()->paddingSize());
+      f.tag()->setTitle("Title");
+      f.save();
+      length = f.length();
+    }
+    {
+      // Growing edits are absorbed by the padding reserved on the first save
+      MP4::File f(filename.c_str());
+      f.tag()->setArtist(String(ByteVector(3000, 'x')));
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(length, f.length());
+    }
+    {
+      // Once the padding is used up it is refilled
+      MP4::File f(filename.c_str());
+      f.tag()->setAlbum(String(ByteVector(3000, 'y')));
+      f.save();
+      CPPUNIT_ASSERT(f.length() > length + 4096);
+      length = f.length();
+    }
+    {
+      // Shrinking keeps the freed space as padding
+      MP4::File f(filename.c_str());
+      f.tag()->setTitle("T");
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(length, f.length());
+    }
+    {
+      // Unless the gap gets larger than 1% of this small file
+      MP4::File f(filename.c_str());
+      f.tag()->setArtist("");
+      f.tag()->setAlbum("");
+      f.save();
+      CPPUNIT_ASSERT(f.length() < length);
+    }
+    {
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("T"), f.tag()->title());
+      CPPUNIT_ASSERT(f.tag()->artist().isEmpty());
+      CPPUNIT_ASSERT(f.audioProperties()->lengthInMilliseconds() > 0);
+    }
+  }
+
   void testFreeForm()
   {
     ScopedFileCopy copy("has-tags", ".m4a");
@@ -368,10 +467,30 @@ public:
       MP4::Atoms atoms(&f);
       MP4::Atom *moov = atoms.atoms()[0];
       // original size + 'pgap' size + padding
-      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(77 + 25 + 974), moov->length());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(77 + 25 + 5070), moov->length());
     }
   }
 
+  void testAtomHeadersReadInBulk()
+  {
+    CountingStream stream(PlainFile(TEST_FILE_PATH_C("has-tags.m4a")).readAll());
+    MP4::File f(&stream, false);
+    CPPUNIT_ASSERT(f.isValid());
+
+    // One read per root level atom header and one for the whole moov box
+    stream.reads = 0;
+    MP4::Atoms atoms(&f);
+    CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(atoms.atoms().size()));
+    CPPUNIT_ASSERT_EQUAL(4, stream.reads);
+
+    // Children are created from the headers read up front
+    stream.reads = 0;
+    CPPUNIT_ASSERT(atoms.find("moov", "udta", "meta", "ilst"));
+    CPPUNIT_ASSERT_EQUAL(1U, atoms.find("moov")->findall("stco", true).size());
+    CPPUNIT_ASSERT(atoms.find("moov", "trak", "mdia", "minf")->find("stbl", "stsd"));
+    CPPUNIT_ASSERT_EQUAL(0, stream.reads);
+  }
+
   void testGnre()
   {
     MP4::File f(TEST_FILE_PATH_C("gnre.m4a"));
@@ -429,6 +548,72 @@ public:
     CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(287), l[1].data().size());
   }
 
+  void testCovrDeferred()
+  {
+    ScopedFileCopy copy("has-tags", ".m4a");
+    string filename = copy.fileName();
+
+    {
+      // The cover art is not read but must survive saving other changes.
+
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT(f.tag()->properties().unsupportedData().contains("covr"));
+      f.tag()->setTitle("Title");
+      f.save();
+    }
+    {
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+      CPPUNIT_ASSERT(f.tag()->contains("covr"));
+      CPPUNIT_ASSERT(f.tag()->complexPropertyKeys().contains("PICTURE"));
+      const List<VariantMap> pictures = f.tag()->complexProperties("PICTURE");
+      CPPUNIT_ASSERT_EQUAL(2U, pictures.size());
+      CPPUNIT_ASSERT_EQUAL(String("image/png"), pictures.front().value("mimeType").toString());
+      CPPUNIT_ASSERT_EQUAL(79U, pictures.front().value("data").toByteVector().size());
+
+      // Removing the item before it was read must not bring it back.
+
+      MP4::File f2(filename.c_str());
+      f2.tag()->removeItem("covr");
+      CPPUNIT_ASSERT(!f2.tag()->itemMap().contains("covr"));
+    }
+    {
+      MP4::File f(filename.c_str());
+      f.tag()->removeUnsupportedProperties(StringList("covr"));
+      f.save();
+    }
+    {
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT(!f.tag()->contains("covr"));
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+    }
+  }
+
+  void testCovrDeferredInvalid()
+  {
+    ScopedFileCopy copy("has-tags", ".m4a");
+    string filename = copy.fileName();
+
+    {
+      // Break the first child of the cover art atom.
+
+      MP4::File f(filename.c_str());
+      f.seek(f.find("covr") + 8);
+      f.writeBlock("junk");
+    }
+    {
+      // The unreadable cover art is reported the same before and after the
+      // deferred parse.
+
+      MP4::File f(filename.c_str());
+      CPPUNIT_ASSERT(!f.tag()->contains("covr"));
+      CPPUNIT_ASSERT(!f.tag()->itemMap().contains("covr"));
+      CPPUNIT_ASSERT(!f.tag()->item("covr").isValid());
+      CPPUNIT_ASSERT(!f.tag()->contains("covr"));
+      CPPUNIT_ASSERT(!f.tag()->complexPropertyKeys().contains("PICTURE"));
+    }
+  }
+
   void testProperties()
   {
     MP4::File f(TEST_FILE_PATH_C("has-tags.m4a"));
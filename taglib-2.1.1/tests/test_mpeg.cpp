@@ -76,7 +76,9 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testIgnoreGarbage);
   CPPUNIT_TEST(testExtendedHeader);
   CPPUNIT_TEST(testReadStyleFast);
+  CPPUNIT_TEST(testReadStyleTagsOnly);
   CPPUNIT_TEST(testID3v22Properties);
+  CPPUNIT_TEST(testReadSyscalls);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -144,16 +146,19 @@ public:
     constexpr std::array readStyles = {
       MPEG::Properties::Fast,
       MPEG::Properties::Average,
-      MPEG::Properties::Accurate
+      MPEG::Properties::Accurate,
+      MPEG::Properties::TagsOnly
     };
     for(auto readStyle : readStyles) {
       MPEG::File f(TEST_FILE_PATH_C("empty1s.aac"), true, readStyle);
+      const bool scanned = readStyle == MPEG::Properties::Average ||
+                           readStyle == MPEG::Properties::Accurate;
       CPPUNIT_ASSERT(f.audioProperties());
-      CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1,
+      CPPUNIT_ASSERT_EQUAL(scanned ? 1 : 0,
         f.audioProperties()->lengthInSeconds());
-      CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1176,
+      CPPUNIT_ASSERT_EQUAL(scanned ? 1176 : 0,
         f.audioProperties()->lengthInMilliseconds());
-      CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1,
+      CPPUNIT_ASSERT_EQUAL(scanned ? 1 : 0,
         f.audioProperties()->bitrate());
       CPPUNIT_ASSERT_EQUAL(1, f.audioProperties()->channels());
       CPPUNIT_ASSERT_EQUAL(MPEG::Header::FrontCenter,
@@ -636,6 +641,35 @@ public:
     }
   }
 
+  void testReadStyleTagsOnly()
+  {
+    {
+      // The Xing header is in the first frame, so the length is exact
+      MPEG::File f(TEST_FILE_PATH_C("lame_cbr.mp3"), true, MPEG::Properties::TagsOnly);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(1887164, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(String("-1.020000 dB"),
+                           f.properties().value("REPLAYGAIN_TRACK_GAIN").front());
+    }
+    {
+      // Without a VBR header the length is estimated from the file size
+      MPEG::File f(TEST_FILE_PATH_C("bladeenc.mp3"), true, MPEG::Properties::TagsOnly);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(64, f.audioProperties()->bitrate());
+      CPPUNIT_ASSERT_EQUAL(44100, f.audioProperties()->sampleRate());
+      CPPUNIT_ASSERT_EQUAL(3553, f.audioProperties()->lengthInMilliseconds());
+    }
+    {
+      // The APE and ID3v1 tags at the end do not count as audio
+      MPEG::File f(TEST_FILE_PATH_C("ape-id3v1.mp3"), true, MPEG::Properties::TagsOnly);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(f.hasAPETag());
+      CPPUNIT_ASSERT(f.hasID3v1Tag());
+      CPPUNIT_ASSERT_EQUAL(32, f.audioProperties()->bitrate());
+      CPPUNIT_ASSERT_EQUAL((8419 - 83 - 128) * 8 / 32, f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
   void testID3v22Properties()
   {
     ScopedFileCopy copy("itunes10", ".mp3");
@@ -686,6 +720,15 @@ public:
     CPPUNIT_ASSERT_EQUAL(2315U, data.size());
   }
 
+  void testReadSyscalls()
+  {
+    if(const long before = readSyscalls(); before >= 0) {
+      MPEG::File f(TEST_FILE_PATH_C("ape-id3v2.mp3"));
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(readSyscalls() - before <= 4);
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMPEG);
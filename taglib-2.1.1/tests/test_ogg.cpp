@@ -31,7 +31,11 @@
 #include "tpropertymap.h"
 #include "oggfile.h"
 #include "vorbisfile.h"
+#include "oggpage.h"
 #include "oggpageheader.h"
+#include "oggutils.h"
+#include "tbytevectorstream.h"
+#include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
 
@@ -47,8 +51,16 @@ class TestOGG : public CppUnit::TestFixture
   CPPUNIT_TEST(testDictInterface1);
   CPPUNIT_TEST(testDictInterface2);
   CPPUNIT_TEST(testAudioProperties);
+  CPPUNIT_TEST(testReadStyleTagsOnly);
   CPPUNIT_TEST(testPageChecksum);
   CPPUNIT_TEST(testPageGranulePosition);
+  CPPUNIT_TEST(testSlicedChecksum);
+  CPPUNIT_TEST(testRenumberPages);
+  CPPUNIT_TEST(testKeepPageCount);
+  CPPUNIT_TEST(testRepeatedSaves);
+  CPPUNIT_TEST(testLastPageTrailingGarbage);
+  CPPUNIT_TEST(testLastPageOtherStream);
+  CPPUNIT_TEST(testLastPageLongTrailingGarbage);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -200,6 +212,18 @@ public:
     CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->bitrateMinimum());
   }
 
+  void testReadStyleTagsOnly()
+  {
+    // The length is estimated from the nominal bitrate in the header.  This
+    // file is silence and much smaller than the bitrate suggests.
+    Ogg::Vorbis::File f(TEST_FILE_PATH_C("empty.ogg"), true, Ogg::Vorbis::Properties::TagsOnly);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(30, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT_EQUAL(112, f.audioProperties()->bitrate());
+    CPPUNIT_ASSERT_EQUAL(44100, f.audioProperties()->sampleRate());
+    CPPUNIT_ASSERT_EQUAL(2, f.audioProperties()->channels());
+  }
+
   void testPageChecksum()
   {
     ScopedFileCopy copy("empty", ".ogg");
@@ -250,6 +274,211 @@ public:
       CPPUNIT_ASSERT_EQUAL(static_cast<long long>(0), f.readBlock(8).toLongLong());
     }
   }
+
+  void testSlicedChecksum()
+  {
+    ByteVector data;
+    for(int i = 0; i < 100; i++)
+      data.append(static_cast<char>(i * 37 + 11));
+
+    for(unsigned int length = 0; length <= data.size(); length++) {
+      unsigned int expected = 0;
+      for(unsigned int i = 0; i < length; i++) {
+        expected ^= static_cast<unsigned int>(static_cast<unsigned char>(data[i])) << 24;
+        for(int bit = 0; bit < 8; bit++)
+          expected = (expected & 0x80000000) ? (expected << 1) ^ 0x04c11db7 : expected << 1;
+      }
+      CPPUNIT_ASSERT_EQUAL(expected, Ogg::pageChecksum(data.data(), length));
+
+      const unsigned int half = length / 2;
+      CPPUNIT_ASSERT_EQUAL(expected, Ogg::pageChecksum(data.data() + half, length - half,
+                                                       Ogg::pageChecksum(data.data(), half)));
+    }
+  }
+
+  void testRenumberPages()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    string newname = copy.fileName();
+
+    {
+      Vorbis::File f(newname.c_str());
+      f.tag()->setComment(String(ByteVector(70000, 'A')));
+      f.save();
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String(ByteVector(70000, 'A')), f.tag()->comment());
+
+      // Every page must be numbered in order and carry a valid checksum.
+
+      offset_t offset = f.find("OggS");
+      int sequenceNumber = 0;
+      while(offset < f.length()) {
+        Ogg::Page page(&f, offset);
+        CPPUNIT_ASSERT(page.header()->isValid());
+        CPPUNIT_ASSERT_EQUAL(sequenceNumber, page.pageSequenceNumber());
+
+        const ByteVector rendered = page.render();
+        f.seek(offset);
+        CPPUNIT_ASSERT_EQUAL(rendered, f.readBlock(page.size()));
+
+        offset += page.size();
+        sequenceNumber++;
+      }
+      CPPUNIT_ASSERT_EQUAL(sequenceNumber - 1, f.lastPageHeader()->pageSequenceNumber());
+    }
+  }
+
+  void testKeepPageCount()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    string newname = copy.fileName();
+
+    int lastPageNumber = 0;
+    {
+      Vorbis::File f(newname.c_str());
+      f.tag()->setComment(String(ByteVector(70000, 'A')));
+      f.save();
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      lastPageNumber = f.lastPageHeader()->pageSequenceNumber();
+      CPPUNIT_ASSERT_EQUAL(11, lastPageNumber);
+    }
+    {
+      // A smaller comment still spanning several pages is spread over the
+      // same pages, so the audio pages keep their numbers.
+
+      Vorbis::File f(newname.c_str());
+      f.tag()->setComment(String(ByteVector(30000, 'B')));
+      f.save();
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(lastPageNumber, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(String(ByteVector(30000, 'B')), f.tag()->comment());
+      CPPUNIT_ASSERT_EQUAL(3832U, f.packet(2).size());
+
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT_EQUAL(3685, f.audioProperties()->lengthInMilliseconds());
+
+      offset_t offset = f.find("OggS");
+      while(offset < f.length()) {
+        Ogg::Page page(&f, offset);
+        CPPUNIT_ASSERT(page.header()->isValid());
+        const ByteVector rendered = page.render();
+        f.seek(offset);
+        CPPUNIT_ASSERT_EQUAL(rendered, f.readBlock(page.size()));
+        offset += page.size();
+      }
+    }
+  }
+
+  void testRepeatedSaves()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    string newname = copy.fileName();
+
+    {
+      // The page index and page headers are kept up to date across saves.
+
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT_EQUAL(2, f.lastPageHeader()->pageSequenceNumber());
+
+      f.tag()->setComment(String(ByteVector(70000, 'A')));
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(11, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(30U, f.packet(0).size());
+      CPPUNIT_ASSERT_EQUAL(3832U, f.packet(2).size());
+
+      f.tag()->setArtist("The Artist");
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(11, f.lastPageHeader()->pageSequenceNumber());
+
+      // The comment header and the setup header now take a page each.
+
+      f.tag()->setComment("");
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(3, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(3832U, f.packet(2).size());
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(3, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(String("The Artist"), f.tag()->artist());
+      CPPUNIT_ASSERT_EQUAL(String(), f.tag()->comment());
+      CPPUNIT_ASSERT_EQUAL(3832U, f.packet(2).size());
+    }
+  }
+
+  void testLastPageTrailingGarbage()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    string newname = copy.fileName();
+
+    {
+      Vorbis::File f(newname.c_str());
+      f.seek(0, File::End);
+      f.writeBlock(ByteVector("OggS\0\0garbage", 14));
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.lastPageHeader());
+      CPPUNIT_ASSERT(f.lastPageHeader()->lastPageOfStream());
+      CPPUNIT_ASSERT_EQUAL(2, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(3685, f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
+  void testLastPageOtherStream()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    string newname = copy.fileName();
+
+    {
+      // Append a copy of the first page belonging to another logical stream.
+
+      Vorbis::File f(newname.c_str());
+      f.seek(0);
+      ByteVector page = f.readBlock(58);
+      const ByteVector serial = ByteVector::fromUInt(0x12345678, false);
+      std::copy(serial.begin(), serial.end(), page.begin() + 14);
+      std::fill(page.begin() + 22, page.begin() + 26, 0);
+      const ByteVector checksum =
+        ByteVector::fromUInt(Ogg::pageChecksum(page.data(), page.size()), false);
+      std::copy(checksum.begin(), checksum.end(), page.begin() + 22);
+
+      f.seek(0, File::End);
+      f.writeBlock(page);
+    }
+    {
+      Vorbis::File f(newname.c_str());
+      CPPUNIT_ASSERT(f.lastPageHeader());
+      CPPUNIT_ASSERT_EQUAL(f.firstPageHeader()->streamSerialNumber(),
+                           f.lastPageHeader()->streamSerialNumber());
+      CPPUNIT_ASSERT_EQUAL(2, f.lastPageHeader()->pageSequenceNumber());
+      CPPUNIT_ASSERT_EQUAL(3685, f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
+  void testLastPageLongTrailingGarbage()
+  {
+    ByteVector data = PlainFile(TEST_FILE_PATH_C("empty.ogg")).readAll();
+    data.append(ByteVector(4 * 1024 * 1024, 'x'));
+
+    CountingStream stream(data);
+    Vorbis::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT(!f.lastPageHeader());
+    CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->lengthInMilliseconds());
+
+    // The search does not step back through all of the garbage.
+    CPPUNIT_ASSERT(stream.reads < 40);
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestOGG);
@@ -40,6 +40,7 @@ class TestOpus : public CppUnit::TestFixture
 {
   CPPUNIT_TEST_SUITE(TestOpus);
   CPPUNIT_TEST(testAudioProperties);
+  CPPUNIT_TEST(testReadStyleTagsOnly);
   CPPUNIT_TEST(testReadComments);
   CPPUNIT_TEST(testWriteComments);
   CPPUNIT_TEST(testSplitPackets);
@@ -60,6 +61,18 @@ public:
     CPPUNIT_ASSERT_EQUAL(1, f.audioProperties()->opusVersion());
   }
 
+  void testReadStyleTagsOnly()
+  {
+    // The header has no bitrate to estimate the length from
+    Ogg::Opus::File f(TEST_FILE_PATH_C("correctness_gain_silent_output.opus"), true,
+                      Ogg::Opus::Properties::TagsOnly);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->bitrate());
+    CPPUNIT_ASSERT_EQUAL(1, f.audioProperties()->channels());
+    CPPUNIT_ASSERT_EQUAL(48000, f.audioProperties()->inputSampleRate());
+  }
+
   void testReadComments()
   {
     Ogg::Opus::File f(TEST_FILE_PATH_C("correctness_gain_silent_output.opus"));
@@ -36,6 +36,7 @@ class TestSpeex : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(TestSpeex);
   CPPUNIT_TEST(testAudioProperties);
   CPPUNIT_TEST(testSplitPackets);
+  CPPUNIT_TEST(testReadStyleTagsOnly);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -52,6 +53,32 @@ public:
     CPPUNIT_ASSERT_EQUAL(44100, f.audioProperties()->sampleRate());
   }
 
+  void testReadStyleTagsOnly()
+  {
+    ScopedFileCopy copy("empty", ".spx");
+
+    {
+      // Without a bitrate in the header (VBR) the length is unknown
+      Ogg::Speex::File f(copy.fileName().c_str(), true, Ogg::Speex::Properties::TagsOnly);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(2, f.audioProperties()->channels());
+
+      // Give the stream a bitrate of 16 kb/s.
+      f.seek(f.find("Speex   ") + 52);
+      f.writeBlock(ByteVector::fromUInt(16000, false));
+    }
+    {
+      Ogg::Speex::File f(copy.fileName().c_str(), true, Ogg::Speex::Properties::TagsOnly);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(16000, f.audioProperties()->bitrateNominal());
+      CPPUNIT_ASSERT_EQUAL(16, f.audioProperties()->bitrate());
+      const offset_t streamLength = f.length() - f.packet(0).size() - f.packet(1).size();
+      CPPUNIT_ASSERT_EQUAL(static_cast<int>((streamLength + 1) / 2),
+                           f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
   void testSplitPackets()
   {
     ScopedFileCopy copy("empty", ".spx");
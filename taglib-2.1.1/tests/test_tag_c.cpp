@@ -23,9 +23,13 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <atomic>
+#include <cstring>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <list>
+#include <vector>
 
 #include "taglib_config.h"
 #include "tag_c.h"
@@ -72,14 +76,36 @@ void complexPropertyKeysToList(
   }
 }
 
+BOOL collectProperty(const TagLib_String_Slice *key, const TagLib_String_Slice *values,
+                     unsigned int count, void *userData)
+{
+  auto propertyMap =
+    static_cast<std::unordered_map<std::string, std::list<std::string>> *>(userData);
+  std::list<std::string> valueList;
+  for(unsigned int i = 0; i < count; ++i) {
+    valueList.emplace_back(values[i].data, values[i].size);
+  }
+  (*propertyMap)[std::string(key->data, key->size)] = valueList;
+  return true;
+}
+
+BOOL stopAtFirstProperty(const TagLib_String_Slice *, const TagLib_String_Slice *,
+                         unsigned int, void *)
+{
+  return false;
+}
+
 }  // namespace
 
 class TestTagC : public CppUnit::TestFixture
 {
   CPPUNIT_TEST_SUITE(TestTagC);
   CPPUNIT_TEST(testMp3);
+  CPPUNIT_TEST(testPropertyForeach);
 #ifdef TAGLIB_WITH_VORBIS
   CPPUNIT_TEST(testStream);
+  CPPUNIT_TEST(testTagFields);
+  CPPUNIT_TEST(testStringsPerThread);
 #endif
   CPPUNIT_TEST_SUITE_END();
 
@@ -168,6 +194,59 @@ public:
     taglib_tag_free_strings();
   }
 
+  void testPropertyForeach()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    TagLib_File *file = taglib_file_new(copy.fileName().c_str());
+    taglib_property_set(file, "TITLE", "Title");
+    taglib_property_set(file, "ARTIST", "Artist 1");
+    taglib_property_set_append(file, "ARTIST", "Artist 2");
+
+    std::unordered_map<std::string, std::list<std::string>> expected;
+    propertiesToMap(file, expected);
+    std::unordered_map<std::string, std::list<std::string>> propertyMap;
+    CPPUNIT_ASSERT_EQUAL(2U, taglib_property_foreach(file, collectProperty, &propertyMap));
+    CPPUNIT_ASSERT(expected == propertyMap);
+    CPPUNIT_ASSERT_EQUAL(1U, taglib_property_foreach(file, stopAtFirstProperty, NULL));
+
+    CPPUNIT_ASSERT_EQUAL(2U, taglib_property_count(file));
+    TagLib_String_Slice key;
+    const TagLib_String_Slice *values;
+    unsigned int count;
+    CPPUNIT_ASSERT(taglib_property_at(file, 0, &key, &values, &count));
+    CPPUNIT_ASSERT_EQUAL("ARTIST"s, std::string(key.data, key.size));
+    CPPUNIT_ASSERT_EQUAL(2U, count);
+    CPPUNIT_ASSERT_EQUAL("Artist 2"s, std::string(values[1].data));
+    CPPUNIT_ASSERT(!taglib_property_at(file, 2, &key, &values, &count));
+
+    // The properties are only converted once ...
+    TagLib_String_Slice title;
+    const TagLib_String_Slice *titleValues;
+    CPPUNIT_ASSERT(taglib_property_at(file, 1, &title, &titleValues, NULL));
+    const TagLib_String_Slice *again;
+    CPPUNIT_ASSERT(taglib_property_at(file, 1, NULL, &again, NULL));
+    CPPUNIT_ASSERT_EQUAL(titleValues, again);
+
+    // ... and read again after a change.  Older slices are invalid then, so
+    // the slices are copied before.
+    const std::string oldTitle(titleValues[0].data, titleValues[0].size);
+    taglib_property_set(file, "TITLE", "Changed");
+    CPPUNIT_ASSERT(taglib_property_at(file, 1, &title, &again, NULL));
+    CPPUNIT_ASSERT_EQUAL("TITLE"s, std::string(title.data, title.size));
+    CPPUNIT_ASSERT_EQUAL("Changed"s, std::string(again[0].data, again[0].size));
+    CPPUNIT_ASSERT_EQUAL("Title"s, oldTitle);
+
+    // Every change is seen, and only the latest snapshot is kept.
+    for(int i = 0; i < 100; ++i) {
+      taglib_property_set(file, "TITLE", std::to_string(i).c_str());
+      CPPUNIT_ASSERT_EQUAL(2U, taglib_property_count(file));
+    }
+    CPPUNIT_ASSERT(taglib_property_at(file, 1, NULL, &again, NULL));
+    CPPUNIT_ASSERT_EQUAL("99"s, std::string(again[0].data, again[0].size));
+
+    taglib_file_free(file);
+  }
+
 #ifdef TAGLIB_WITH_VORBIS
   void testStream()
   {
@@ -204,6 +283,9 @@ public:
         {"ALBUM"s, {"Quod Libet Test Data"s}}
       };
       CPPUNIT_ASSERT(expected == propertyMap);
+      propertyMap.clear();
+      taglib_property_foreach(file, collectProperty, &propertyMap);
+      CPPUNIT_ASSERT(expected == propertyMap);
 
       std::list<std::string> keyList;
       complexPropertyKeysToList(file, keyList);
@@ -237,6 +319,80 @@ public:
 
     taglib_tag_free_strings();
   }
+
+  void testTagFields()
+  {
+    {
+      TagLib_File *file = taglib_file_new(TEST_FILE_PATH_C("silence-44-s.flac"));
+      TagLib_Tag_Fields *fields = taglib_file_tag_fields(file);
+      CPPUNIT_ASSERT(fields);
+      CPPUNIT_ASSERT_EQUAL("Silence"s, std::string(fields->title));
+      CPPUNIT_ASSERT_EQUAL("piman / jzig"s, std::string(fields->artist));
+      CPPUNIT_ASSERT_EQUAL("Quod Libet Test Data"s, std::string(fields->album));
+      CPPUNIT_ASSERT_EQUAL(""s, std::string(fields->comment));
+      CPPUNIT_ASSERT_EQUAL("Silence"s, std::string(fields->genre));
+      CPPUNIT_ASSERT_EQUAL(2004U, fields->year);
+      CPPUNIT_ASSERT_EQUAL(2U, fields->track);
+      CPPUNIT_ASSERT_EQUAL(3, fields->length);
+      CPPUNIT_ASSERT_EQUAL(44100, fields->samplerate);
+      CPPUNIT_ASSERT_EQUAL(2, fields->channels);
+      taglib_free(fields);
+
+      // Longer than the blocks of the string arena
+      const std::string comment(10000, 'c');
+      TagLib_Tag *tag = taglib_file_tag(file);
+      taglib_tag_set_comment(tag, comment.c_str());
+      CPPUNIT_ASSERT_EQUAL(comment, std::string(taglib_tag_comment(tag)));
+      CPPUNIT_ASSERT_EQUAL("Silence"s, std::string(taglib_tag_title(tag)));
+      fields = taglib_file_tag_fields(file);
+      CPPUNIT_ASSERT_EQUAL(comment, std::string(fields->comment));
+      CPPUNIT_ASSERT_EQUAL("Quod Libet Test Data"s, std::string(fields->album));
+      taglib_free(fields);
+
+      taglib_file_free(file);
+    }
+    {
+      TagLib_File *file = taglib_file_new(TEST_FILE_PATH_C("no-extension"));
+      CPPUNIT_ASSERT(!taglib_file_tag_fields(file));
+      taglib_file_free(file);
+    }
+
+    taglib_tag_free_strings();
+  }
+
+  void testStringsPerThread()
+  {
+    TagLib_File *file = taglib_file_new(TEST_FILE_PATH_C("silence-44-s.flac"));
+    char *title = taglib_tag_title(taglib_file_tag(file));
+
+    // Other threads freeing their strings must not free this thread's.
+    std::atomic<int> mismatches { 0 };
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+      threads.emplace_back([&mismatches] {
+        TagLib_File *f = taglib_file_new(TEST_FILE_PATH_C("silence-44-s.flac"));
+        const TagLib_Tag *tag = taglib_file_tag(f);
+        for(int i = 0; i < 200; ++i) {
+          const char *album = taglib_tag_album(tag);
+          const char *artist = taglib_tag_artist(tag);
+          if(std::strcmp(album, "Quod Libet Test Data") != 0 ||
+             std::strcmp(artist, "piman / jzig") != 0)
+            ++mismatches;
+          if(i % 10 == 9)
+            taglib_tag_free_strings();
+        }
+        taglib_file_free(f);
+      });
+    }
+    for(auto &thread : threads)
+      thread.join();
+
+    CPPUNIT_ASSERT_EQUAL(0, mismatches.load());
+    CPPUNIT_ASSERT_EQUAL("Silence"s, std::string(title));
+
+    taglib_file_free(file);
+    taglib_tag_free_strings();
+  }
 #endif
 };
 
@@ -0,0 +1,329 @@
+/***************************************************************************
+    copyright           : (C) 2026 by the TagLib developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "taglib_config.h"
+#include "tbytevectorstream.h"
+#include "tdebuglistener.h"
+#include "tpropertymap.h"
+#include "tag.h"
+#include "fileref.h"
+#include "id3v1tag.h"
+#include "id3v2tag.h"
+#include "plainfile.h"
+#ifdef TAGLIB_WITH_RIFF
+#include "infotag.h"
+#endif
+#ifdef TAGLIB_WITH_MP4
+#include "mp4file.h"
+#include "mp4itemfactory.h"
+#endif
+#include <cppunit/extensions/HelperMacros.h>
+#include "utils.h"
+
+using namespace std;
+using namespace TagLib;
+
+namespace
+{
+  // Test files of every format, including some broken ones so that the
+  // error paths and their debug messages run concurrently too.
+  const char *const testFiles[] = {
+    "xing.mp3",
+    "ape-id3v1.mp3",
+    "rare_frames.mp3",
+    "garbage.mp3",
+    "empty1s.aac",
+#ifdef TAGLIB_WITH_VORBIS
+    "test.ogg",
+    "empty_flac.oga",
+    "empty.spx",
+    "correctness_gain_silent_output.opus",
+    "sinewave.flac",
+    "multiple-vc.flac",
+#endif
+#ifdef TAGLIB_WITH_APE
+    "click.mpc",
+    "sv8_header.mpc",
+    "tagged.wv",
+    "no_length.wv",
+    "mac-399-tagged.ape",
+#endif
+#ifdef TAGLIB_WITH_TRUEAUDIO
+    "tagged.tta",
+#endif
+#ifdef TAGLIB_WITH_MP4
+    "has-tags.m4a",
+    "covr-junk.m4a",
+    "no-tags.3g2",
+#endif
+#ifdef TAGLIB_WITH_ASF
+    "silence-1.wma",
+#endif
+#ifdef TAGLIB_WITH_RIFF
+    "empty.aiff",
+    "alaw.aifc",
+    "duplicate_tags.wav",
+    "invalid-chunk.wav",
+#endif
+#ifdef TAGLIB_WITH_MOD
+    "test.mod",
+    "test.s3m",
+    "test.it",
+    "test.xm",
+#endif
+#ifdef TAGLIB_WITH_DSF
+    "empty10ms.dsf",
+    "empty10ms.dff",
+#endif
+#ifdef TAGLIB_WITH_SHORTEN
+    "2sec-silence.shn",
+#endif
+  };
+
+  constexpr size_t testFileCount = sizeof(testFiles) / sizeof(testFiles[0]);
+
+  // Everything a reader would look at, flattened so results from different
+  // threads can be compared.
+  String describe(const FileRef &f)
+  {
+    if(f.isNull())
+      return "null";
+
+    String s = f.properties().toString();
+    if(const AudioProperties *p = f.audioProperties()) {
+      s += String::number(p->lengthInMilliseconds()) + " " +
+           String::number(p->bitrate()) + " " +
+           String::number(p->sampleRate()) + " " +
+           String::number(p->channels());
+    }
+    return s;
+  }
+
+  class CountingListener : public DebugListener
+  {
+  public:
+    void printMessage(const String &) override
+    {
+      ++messages;
+    }
+
+    std::atomic<int> messages { 0 };
+  };
+
+  // Handlers which behave like the defaults, so swapping them does not
+  // change what is read.
+  class Latin1Handler : public ID3v2::Latin1StringHandler
+  {
+  };
+
+  class ID3v1Handler : public ID3v1::StringHandler
+  {
+  };
+
+#ifdef TAGLIB_WITH_RIFF
+  class InfoHandler : public RIFF::Info::StringHandler
+  {
+  };
+#endif
+
+#ifdef TAGLIB_WITH_MP4
+  // A factory of its own, whose lookup maps are still empty when the
+  // threads start, whatever ran before in this process.
+  class FreshItemFactory : public MP4::ItemFactory
+  {
+  public:
+    FreshItemFactory() = default;
+  };
+#endif
+
+  class NullResolver : public FileRef::StreamTypeResolver
+  {
+  public:
+    File *createFile(FileName, bool, AudioProperties::ReadStyle) const override
+    {
+      return nullptr;
+    }
+
+    File *createFileFromStream(IOStream *, bool, AudioProperties::ReadStyle) const override
+    {
+      return nullptr;
+    }
+  };
+} // namespace
+
+class TestThreads : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestThreads);
+  CPPUNIT_TEST(testParallelRead);
+#ifdef TAGLIB_WITH_MP4
+  CPPUNIT_TEST(testParallelMP4ItemFactory);
+#endif
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void testParallelRead()
+  {
+    constexpr int threadCount = 8;
+    constexpr int rounds = 3;
+
+    // Only the raw contents are loaded up front.  The first parse of every
+    // format happens in the threads, so that lazily built tables are built
+    // concurrently when this runs in a fresh process.
+    vector<ByteVector> contents;
+    for(const auto &name : testFiles) {
+      contents.push_back(PlainFile(TEST_FILE_PATH_C(name)).readAll());
+    }
+
+    CountingListener listener1;
+    CountingListener listener2;
+    Latin1Handler latin1Handler;
+    ID3v1Handler id3v1Handler;
+#ifdef TAGLIB_WITH_RIFF
+    InfoHandler infoHandler;
+#endif
+    NullResolver resolver;
+
+    setDebugListener(&listener1);
+
+    atomic<int> mismatches { 0 };
+    atomic<int> running { threadCount };
+
+    // What each thread saw in its first round, by name and by stream.
+    vector<vector<String>> byName(threadCount, vector<String>(testFileCount));
+    vector<vector<String>> byStream(threadCount, vector<String>(testFileCount));
+
+    vector<thread> threads;
+    for(int t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&, t] {
+        for(int r = 0; r < rounds; ++r) {
+          for(size_t i = 0; i < testFileCount; ++i) {
+            // Every thread starts at a different file.
+            const size_t index = (i + t * 5) % testFileCount;
+
+            // By name, which goes through extension detection ...
+            const String name = describe(FileRef(TEST_FILE_PATH_C(testFiles[index])));
+
+            // ... and as a nameless stream, which goes through content
+            // detection.
+            ByteVectorStream stream(contents[index]);
+            const String nameless = describe(FileRef(&stream));
+
+            if(r == 0) {
+              byName[t][index] = name;
+              byStream[t][index] = nameless;
+            }
+            else if(name != byName[t][index] || nameless != byStream[t][index]) {
+              ++mismatches;
+            }
+          }
+        }
+        --running;
+      });
+    }
+
+    // Meanwhile change the global settings, which must not disturb readers.
+    for(int i = 0; running > 0; ++i) {
+      const bool odd = i % 2 != 0;
+      setDebugListener(odd ? &listener2 : &listener1);
+      ID3v2::Tag::setLatin1StringHandler(odd ? &latin1Handler : nullptr);
+      ID3v1::Tag::setStringHandler(odd ? &id3v1Handler : nullptr);
+#ifdef TAGLIB_WITH_RIFF
+      RIFF::Info::Tag::setStringHandler(odd ? &infoHandler : nullptr);
+#endif
+      if(odd)
+        FileRef::addFileTypeResolver(&resolver);
+      else
+        FileRef::clearFileTypeResolvers();
+      this_thread::yield();
+    }
+
+    for(auto &thread : threads)
+      thread.join();
+
+    setDebugListener(nullptr);
+    ID3v2::Tag::setLatin1StringHandler(nullptr);
+    ID3v1::Tag::setStringHandler(nullptr);
+#ifdef TAGLIB_WITH_RIFF
+    RIFF::Info::Tag::setStringHandler(nullptr);
+#endif
+    FileRef::clearFileTypeResolvers();
+
+    CPPUNIT_ASSERT_EQUAL(0, mismatches.load());
+
+    // Every thread must have seen what a single thread sees.  Only compare
+    // the stream results of files which are detected by content.
+    for(size_t i = 0; i < testFileCount; ++i) {
+      const String expected = describe(FileRef(TEST_FILE_PATH_C(testFiles[i])));
+      for(int t = 0; t < threadCount; ++t) {
+        CPPUNIT_ASSERT_EQUAL(expected, byName[t][i]);
+        if(byStream[t][i] != "null")
+          CPPUNIT_ASSERT_EQUAL(expected, byStream[t][i]);
+      }
+    }
+  }
+
+#ifdef TAGLIB_WITH_MP4
+  void testParallelMP4ItemFactory()
+  {
+    constexpr int threadCount = 8;
+
+    const ByteVector contents = PlainFile(TEST_FILE_PATH_C("has-tags.m4a")).readAll();
+    FreshItemFactory factory;
+
+    vector<String> results(threadCount);
+    atomic<int> waiting { threadCount };
+    vector<thread> threads;
+    for(int t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&, t] {
+        // Start parsing together, so that the maps are built concurrently.
+        --waiting;
+        while(waiting > 0)
+          this_thread::yield();
+
+        ByteVectorStream stream(contents);
+        MP4::File f(&stream, true, AudioProperties::Average, &factory);
+        results[t] = f.properties().toString();
+      });
+    }
+    for(auto &thread : threads)
+      thread.join();
+
+    ByteVectorStream stream(contents);
+    const MP4::File f(&stream);
+    const String expected = f.properties().toString();
+    CPPUNIT_ASSERT(!expected.isEmpty());
+    for(const auto &result : results)
+      CPPUNIT_ASSERT_EQUAL(expected, result);
+  }
+#endif
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestThreads);
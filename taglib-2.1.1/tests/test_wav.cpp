@@ -61,6 +61,8 @@ class TestWAV : public CppUnit::TestFixture
   CPPUNIT_TEST(testWaveFormatExtensible);
   CPPUNIT_TEST(testInvalidChunk);
   CPPUNIT_TEST(testRIFFInfoProperties);
+  CPPUNIT_TEST(testReadSyscalls);
+  CPPUNIT_TEST(testManyChunks);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -482,6 +484,50 @@ public:
     }
   }
 
+  void testReadSyscalls()
+  {
+    // The stream length is asked for twice per chunk but looked up once
+    if(const long before = readSyscalls(); before >= 0) {
+      RIFF::WAV::File f(TEST_FILE_PATH_C("duplicate_tags.wav"));
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(readSyscalls() - before <= 8);
+    }
+  }
+
+  void testManyChunks()
+  {
+    const auto chunk = [](const char *name, const ByteVector &data) {
+      ByteVector c = ByteVector(name) + ByteVector::fromUInt(data.size(), false) + data;
+      if(data.size() & 1)
+        c.append('\0');
+      return c;
+    };
+
+    // A broadcast WAV with a lot of metadata in front of the audio
+    ByteVector chunks = chunk("fmt ", ByteVector::fromShort(1, false) +
+                                      ByteVector::fromShort(2, false) +
+                                      ByteVector::fromUInt(44100, false) +
+                                      ByteVector::fromUInt(176400, false) +
+                                      ByteVector::fromShort(4, false) +
+                                      ByteVector::fromShort(16, false));
+    chunks.append(chunk("bext", ByteVector(602, '\0')));
+    chunks.append(chunk("iXML", ByteVector(1001, ' ')));
+    for(int i = 0; i < 50; ++i)
+      chunks.append(chunk("JUNK", ByteVector(static_cast<unsigned int>(i * 3), '\0')));
+    chunks.append(chunk("data", ByteVector(17640, '\0')));
+
+    CountingStream stream(ByteVector("RIFF") + ByteVector::fromUInt(chunks.size() + 4, false) +
+                          ByteVector("WAVE") + chunks);
+    RIFF::WAV::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(100, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT_EQUAL(2, f.audioProperties()->channels());
+
+    // One read for all chunk headers and one for the format, instead of two
+    // or three reads per chunk
+    CPPUNIT_ASSERT(stream.reads < 10);
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestWAV);
@@ -27,10 +27,12 @@
 #include <cstdio>
 
 #include "tbytevectorlist.h"
+#include "tbytevectorstream.h"
 #include "tpropertymap.h"
 #include "apetag.h"
 #include "id3v1tag.h"
 #include "wavpackfile.h"
+#include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
 
@@ -48,6 +50,9 @@ class TestWavPack : public CppUnit::TestFixture
   CPPUNIT_TEST(testFuzzedFile);
   CPPUNIT_TEST(testStripAndProperties);
   CPPUNIT_TEST(testRepeatedSave);
+  CPPUNIT_TEST(testFinalBlockReads);
+  CPPUNIT_TEST(testFinalBlockLongTrailingData);
+  CPPUNIT_TEST(testReadStyleTagsOnly);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -179,6 +184,74 @@ public:
     }
   }
 
+  void testFinalBlockReads()
+  {
+    // 16-bit stereo at 44100 Hz, with the total number of samples unknown
+    const auto block = [](unsigned int index, unsigned int samples, unsigned int flags,
+                          unsigned int payloadSize) {
+      return ByteVector("wvpk") +
+             ByteVector::fromUInt(24 + payloadSize, false) +
+             ByteVector::fromShort(0x410, false) +
+             ByteVector(2, '\0') +
+             ByteVector::fromUInt(0xFFFFFFFF, false) +
+             ByteVector::fromUInt(index, false) +
+             ByteVector::fromUInt(samples, false) +
+             ByteVector::fromUInt(flags | (9 << 23) | 1, false) +
+             ByteVector(4, '\0') +
+             ByteVector(payloadSize, '\x55');
+    };
+
+    // The last block is larger than the first window
+    CountingStream stream(block(0, 4410, 0x800, 1000) +
+                          block(4410, 4410, 0x1000, 200000));
+    WavPack::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(8820U, f.audioProperties()->sampleFrames());
+    CPPUNIT_ASSERT_EQUAL(200, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT(stream.reads < 10);
+
+    CountingStream noLength(PlainFile(TEST_FILE_PATH_C("no_length.wv")).readAll());
+    WavPack::File g(&noLength);
+    CPPUNIT_ASSERT_EQUAL(163392U, g.audioProperties()->sampleFrames());
+    CPPUNIT_ASSERT(noLength.reads < 10);
+  }
+
+  void testFinalBlockLongTrailingData()
+  {
+    const auto block = [](unsigned int index, unsigned int samples, unsigned int flags) {
+      return ByteVector("wvpk") +
+             ByteVector::fromUInt(24 + 1000, false) +
+             ByteVector::fromShort(0x410, false) +
+             ByteVector(2, '\0') +
+             ByteVector::fromUInt(0xFFFFFFFF, false) +
+             ByteVector::fromUInt(index, false) +
+             ByteVector::fromUInt(samples, false) +
+             ByteVector::fromUInt(flags | (9 << 23) | 1, false) +
+             ByteVector(4, '\0') +
+             ByteVector(1000, '\x55');
+    };
+
+    // The final block is further from the end than the search goes
+    CountingStream stream(block(0, 4410, 0x800) + block(4410, 4410, 0x1000) +
+                          ByteVector(6 * 1024 * 1024, '\x55'));
+    WavPack::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(0U, f.audioProperties()->sampleFrames());
+    CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT(stream.reads < 20);
+  }
+
+  void testReadStyleTagsOnly()
+  {
+    // The final block is not looked for
+    WavPack::File f(TEST_FILE_PATH_C("no_length.wv"), true, WavPack::Properties::TagsOnly);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(0U, f.audioProperties()->sampleFrames());
+    CPPUNIT_ASSERT_EQUAL(0, f.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT_EQUAL(44100, f.audioProperties()->sampleRate());
+    CPPUNIT_ASSERT_EQUAL(2, f.audioProperties()->channels());
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestWavPack);
@@ -105,6 +105,50 @@ inline bool fileEqual(const string &filename1, const string &filename2)
   return stream1.good() == stream2.good();
 }
 
+// Number of read system calls made by this process so far, or -1 where the
+// kernel does not report it.  Lets tests check that a parser does not go to
+// the disk more often than needed.
+inline long readSyscalls()
+{
+#ifdef __linux__
+  ifstream io("/proc/self/io");
+  string key;
+  long value;
+  while(io >> key >> value) {
+    if(key == "syscr:")
+      return value;
+  }
+#endif
+  return -1;
+}
+
+#ifdef TAGLIB_BYTEVECTORSTREAM_H
+
+// An in-memory stream which counts the reads and writes made on it, for
+// tests which check how often a parser goes to the stream.
+class CountingStream : public TagLib::ByteVectorStream
+{
+public:
+  using TagLib::ByteVectorStream::ByteVectorStream;
+
+  TagLib::ByteVector readBlock(size_t length) override
+  {
+    ++reads;
+    return TagLib::ByteVectorStream::readBlock(length);
+  }
+
+  void writeBlock(const TagLib::ByteVector &data) override
+  {
+    ++writes;
+    TagLib::ByteVectorStream::writeBlock(data);
+  }
+
+  int reads { 0 };
+  int writes { 0 };
+};
+
+#endif
+
 #ifdef TAGLIB_STRING_H
 
 namespace TagLib {
@@ -0,0 +1,137 @@
+#include "tagloader.h"
+
+#include <QFileInfo>
+#include <QMetaObject>
+
+TagLoader::TagLoader(QObject *parent)
+    : QObject(parent)
+    , m_generation(std::make_shared<std::atomic<quint64>>(0))
+{
+    // One reader for the file the user asked for, one for prefetching
+    m_pool.setMaxThreadCount(2);
+
+    // Cost is in KiB so that large covers count against the budget
+    m_cache.setMaxCost(64 * 1024);
+}
+
+TagLoader::~TagLoader()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void TagLoader::load(const QString &filePath)
+{
+    ++*m_generation;
+    m_pendingFile = filePath;
+
+    // A prefetch of this file may already be running; its result is used
+    if (!m_inFlight.contains(filePath)) {
+        startRead(filePath, false);
+    }
+}
+
+void TagLoader::prefetch(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        // Cached files are checked when they are loaded
+        if (!m_inFlight.contains(filePath) && !m_cache.contains(filePath)) {
+            startRead(filePath, true);
+        }
+    }
+}
+
+void TagLoader::cancel()
+{
+    ++*m_generation;
+    m_pendingFile.clear();
+}
+
+void TagLoader::invalidate(const QString &filePath)
+{
+    m_cache.remove(filePath);
+}
+
+QString TagLoader::pendingFile() const
+{
+    return m_pendingFile;
+}
+
+void TagLoader::startRead(const QString &filePath, bool speculative)
+{
+    m_inFlight.insert(filePath);
+
+    // A cached result is only read again if the file changed since
+    QDateTime cachedModified;
+    qint64 cachedSize = -1;
+    if (const LoadedFile *cached = m_cache.object(filePath)) {
+        cachedModified = cached->lastModified;
+        cachedSize = cached->size;
+    }
+
+    const quint64 generation = m_generation->load();
+    const std::shared_ptr<std::atomic<quint64>> currentGeneration = m_generation;
+
+    m_pool.start([this, filePath, generation, currentGeneration, cachedModified, cachedSize]() {
+        LoadedFile file;
+        bool unchanged = false;
+
+        // Requests superseded before they got a thread are dropped unread
+        const bool skipped = currentGeneration->load() != generation;
+        if (!skipped) {
+            const QFileInfo info(filePath);
+            file.lastModified = info.lastModified();
+            file.size = info.size();
+            unchanged = cachedSize >= 0 && file.size == cachedSize && file.lastModified == cachedModified;
+            if (!unchanged) {
+                file.ok = TagEngine::readTags(filePath, file.tags, &file.errorString, &file.cover);
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, filePath, skipped, unchanged, file]() {
+            handleRead(filePath, skipped, unchanged, file);
+        }, Qt::QueuedConnection);
+    }, speculative ? 0 : 1);
+}
+
+void TagLoader::handleRead(const QString &filePath, bool skipped, bool unchanged, const LoadedFile &file)
+{
+    m_inFlight.remove(filePath);
+
+    if (skipped) {
+        // The user came back to this file while its stale request was queued
+        if (filePath == m_pendingFile) {
+            startRead(filePath, false);
+        }
+        return;
+    }
+
+    if (unchanged) {
+        const LoadedFile *cached = m_cache.object(filePath);
+        if (!cached) {
+            // Evicted while the worker checked the file
+            if (filePath == m_pendingFile) {
+                startRead(filePath, false);
+            }
+            return;
+        }
+
+        if (filePath == m_pendingFile) {
+            const LoadedFile cachedFile = *cached;
+            m_pendingFile.clear();
+            emit loaded(filePath, cachedFile);
+        }
+        return;
+    }
+
+    if (file.ok) {
+        m_cache.insert(filePath, new LoadedFile(file), 1 + file.cover.data.size() / 1024);
+    } else {
+        m_cache.remove(filePath);
+    }
+
+    if (filePath == m_pendingFile) {
+        m_pendingFile.clear();
+        emit loaded(filePath, file);
+    }
+}
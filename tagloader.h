@@ -0,0 +1,70 @@
+#ifndef TAGLOADER_H
+#define TAGLOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+
+#include "tagengine.h"
+
+// Result of reading one file in the background
+struct LoadedFile
+{
+    TagRecord tags;
+    CoverArt cover;
+    QDateTime lastModified;
+    qint64 size = 0;
+    bool ok = false;
+    QString errorString;
+};
+
+// Reads tags on worker threads so slow storage never blocks the GUI.
+//
+// Only the most recent load() is reported; requesting another file drops
+// reads that have not started yet. prefetch() speculatively reads files the
+// user is likely to open next (e.g. the neighbours in the file tree) into a
+// small cache. load() serves a cached file once a worker has checked that
+// its size and modification time are unchanged, so the GUI thread never
+// waits for the file system.
+class TagLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TagLoader(QObject *parent = nullptr);
+    ~TagLoader();
+
+    // Starts loading filePath and cancels any other pending request
+    void load(const QString &filePath);
+    void prefetch(const QStringList &filePaths);
+    // Drops pending requests; an in-flight read still lands in the cache
+    void cancel();
+    // Forgets the cached result, e.g. after the file was saved
+    void invalidate(const QString &filePath);
+
+    QString pendingFile() const;
+
+signals:
+    // Emitted in the GUI thread for the file last passed to load()
+    void loaded(const QString &filePath, const LoadedFile &file);
+
+private:
+    void startRead(const QString &filePath, bool speculative);
+    void handleRead(const QString &filePath, bool skipped, bool unchanged, const LoadedFile &file);
+
+    QThreadPool m_pool;
+    QCache<QString, LoadedFile> m_cache;
+    QSet<QString> m_inFlight;
+    QString m_pendingFile;
+    std::shared_ptr<std::atomic<quint64>> m_generation;
+};
+
+#endif // TAGLOADER_H